@@ -0,0 +1,19 @@
+
+#include "Activation.h"
+
+// the names of the activations in the order of the enum
+static const char* const activationNames[numActivations] = {"tanh", "relu", "leaky_relu", "sigmoid", "linear",
+                                                            "softmax"};
+
+const char* activationName(Activation activation) {
+    return (size_t)activation<numActivations ? activationNames[(size_t)activation] : "unknown";
+}
+
+bool parseActivation(const std::string &name, Activation &activation) {
+    for (size_t index = 0; index<numActivations; index++)
+        if (name == activationNames[index]){
+            activation = (Activation)index;
+            return true;
+        }
+    return false;
+}
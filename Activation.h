@@ -0,0 +1,32 @@
+
+#ifndef NEURALNETWORK_ACTIVATION_H
+#define NEURALNETWORK_ACTIVATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**********************************************************
+ * Program	:  Activation
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: The activation functions a layer of the network can use. The kernels of every activation are looked
+ *                  up once per layer so the loops over the neurons never branch on which one it is. Softmax can only
+ *                  be used by the output layer where it is trained with cross entropy, so the gradient of its outputs
+ *                  is simply the target minus the output
+ ***********************************************************/
+
+// the activation functions in the order they are numbered in model files, tanh is first as it was the only one
+enum class Activation : uint32_t { TANH, RELU, LEAKY_RELU, SIGMOID, LINEAR, SOFTMAX };
+constexpr size_t numActivations = 6;
+
+// the slope of the leaky relu for inputs below zero
+constexpr double leakyReluSlope = 0.01;
+
+// the name of an activation for printing and saving
+const char* activationName(Activation activation);
+// read an activation from its name, returns false if there is no activation with the name
+bool parseActivation(const std::string& name, Activation& activation);
+
+
+#endif //NEURALNETWORK_ACTIVATION_H
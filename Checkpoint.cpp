@@ -0,0 +1,80 @@
+
+#include "Checkpoint.h"
+#include <cstdio>
+#include <iostream>
+
+bool saveCheckpoint(const NeuralNetwork &network, const TrainingProgress &progress, const std::string &fileName) {
+    std::string temporary = fileName+".tmp";
+    if (!saveModelFile(network, temporary, true, &progress) || std::rename(temporary.c_str(), fileName.c_str()) != 0){
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const std::string &fileName, NeuralNetwork &network, TrainingProgress &progress) {
+    return loadNetworkFile(fileName, network, &progress);
+}
+
+CheckpointWriter::CheckpointWriter(std::string fileName, double interval) :
+        fileName(std::move(fileName)),
+        interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(interval))),
+        lastTaken(std::chrono::steady_clock::now()) {
+    writer = std::thread(&CheckpointWriter::writeLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+}
+
+bool CheckpointWriter::due() const {
+    return std::chrono::steady_clock::now()-lastTaken>=interval;
+}
+
+void CheckpointWriter::take(const NeuralNetwork &network, const TrainingProgress &progress) {
+    lastTaken = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // the copy reuses the memory of the buffer after the first checkpoint
+        if (waiting.network)
+            *waiting.network = network;
+        else
+            waiting.network.reset(new NeuralNetwork(network));
+        waiting.progress = progress;
+        hasWaiting = true;
+    }
+    changed.notify_all();
+}
+
+bool CheckpointWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]{ return !hasWaiting && !busy; });
+    return !failed;
+}
+
+void CheckpointWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true){
+        changed.wait(lock, [&]{ return stopping || hasWaiting; });
+        if (!hasWaiting) return;
+        std::swap(waiting, writing);
+        hasWaiting = false;
+        busy = true;
+        lock.unlock();
+
+        bool written = saveCheckpoint(*writing.network, writing.progress, fileName);
+        if (!written)
+            std::cerr<<"Could not write the checkpoint "<<fileName<<std::endl;
+
+        lock.lock();
+        failed = failed || !written;
+        busy = false;
+        changed.notify_all();
+    }
+}
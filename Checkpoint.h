@@ -0,0 +1,71 @@
+
+#ifndef NEURALNETWORK_CHECKPOINT_H
+#define NEURALNETWORK_CHECKPOINT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "ModelFile.h"
+#include "NeuralNetwork.h"
+
+/**********************************************************
+ * Program	:  Checkpoint
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Saves a network part way through training along with its optimizer state and how far the run has got
+ *                  through its data, so a run that is stopped can carry on from its last checkpoint exactly as if it
+ *                  never stopped. Training only pays for copying the network into a spare buffer, the copy is written
+ *                  to disk on a background thread while training carries on. Every checkpoint is written next to the
+ *                  last one and renamed over it so a crash part way through a write never loses the last checkpoint
+ ***********************************************************/
+
+// save a checkpoint of the network and its run to the file, replacing the last one only once the new one is
+// complete, returns false if it could not be written
+bool saveCheckpoint(const NeuralNetwork& network, const TrainingProgress& progress, const std::string& fileName);
+// read a checkpoint back into a network and the progress of its run, returns false if the file is missing or invalid
+bool loadCheckpoint(const std::string& fileName, NeuralNetwork& network, TrainingProgress& progress);
+
+class CheckpointWriter {
+public:
+    // write checkpoints to the file no more often than every interval seconds
+    CheckpointWriter(std::string fileName, double interval);
+    // writes the checkpoint still waiting before returning
+    ~CheckpointWriter();
+    // the writing thread holds a pointer to the writer so it cannot be copied
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // whether the interval has passed since the last checkpoint was taken
+    bool due() const;
+    // copy the network and its progress into the spare buffer and hand it to the writing thread, a checkpoint taken
+    // while the last one is still waiting to be written replaces it
+    void take(const NeuralNetwork& network, const TrainingProgress& progress);
+    // wait for every checkpoint taken so far to be written, returns false if any of them could not be
+    bool flush();
+
+private:
+    // write checkpoints as they are handed over until the writer is destroyed
+    void writeLoop();
+
+    std::string fileName;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point lastTaken;
+
+    // the checkpoint waiting to be written and the one being written, the buffers are swapped rather than copied and
+    // keep their memory from one checkpoint to the next
+    struct Snapshot {
+        std::unique_ptr<NeuralNetwork> network;
+        TrainingProgress progress;
+    };
+    Snapshot waiting, writing;
+    bool hasWaiting = false, busy = false, stopping = false, failed = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread writer;
+};
+
+
+#endif //NEURALNETWORK_CHECKPOINT_H
@@ -0,0 +1,159 @@
+
+#include "DataGenerator.h"
+#include "DatasetFile.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// the engine of a block, seeded by a seed sequence whose mixing the standard spells out so every library gives the
+// same samples
+static std::mt19937_64 blockEngine(uint64_t seed, uint64_t block) {
+    std::seed_seq sequence{(uint32_t)seed, (uint32_t)(seed>>32), (uint32_t)block, (uint32_t)(block>>32)};
+    return std::mt19937_64(sequence);
+}
+
+// add the values of a row to the text separated by commas, as short as they can be while reading back the same
+static void appendRow(std::string& text, const double* values, size_t count) {
+    char number[32];
+    for (size_t value = 0; value<count; value++){
+        if (value)
+            text += ',';
+        std::to_chars_result result = std::to_chars(number, number+sizeof(number), values[value]);
+        text.append(number, result.ptr);
+    }
+}
+
+// generate the samples of a shard a block at a time and write them out, returns false if it could not be written
+static bool generateShard(const std::string& shardName, const GeneratorSettings& settings,
+                          const TargetFunction& function, uint32_t shardIndex, uint32_t numShards, uint64_t first,
+                          uint64_t count) {
+    size_t numInputs = (size_t)settings.topology.front(), numOutputs = (size_t)settings.topology.back();
+    DatasetShardWriter dataset;
+    std::fstream text;
+    std::string buffer;
+    if (settings.scalarSize){
+        if (!dataset.open(shardName, settings.topology, settings.scalarSize, shardIndex, numShards, first, count,
+                          settings.numSamples))
+            return false;
+    }
+    else {
+        text.open(shardName, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+        if (!text)
+            return false;
+        // every text shard is a training file of its own
+        buffer = "Topology: ";
+        for (size_t layer = 0; layer<settings.topology.size(); layer++)
+            buffer += (layer ? "," : "")+std::to_string(settings.topology[layer]);
+        buffer += '\n';
+    }
+
+    std::vector<double> inputs(generatorBlockSize*numInputs), outputs(generatorBlockSize*numOutputs);
+    for (uint64_t sample = first; sample<first+count;){
+        // a shard can start or end part way through a block so the engine is moved on to the first sample needed
+        uint64_t block = sample/generatorBlockSize, blockStart = block*generatorBlockSize;
+        std::mt19937_64 engine = blockEngine(settings.seed, block);
+        engine.discard((sample-blockStart)*numInputs);
+        size_t run = (size_t)std::min(first+count, blockStart+generatorBlockSize)-sample;
+        for (size_t row = 0; row<run; row++){
+            double* sampleInputs = inputs.data()+row*numInputs;
+            // the top bit of every number is the input
+            for (size_t input = 0; input<numInputs; input++)
+                sampleInputs[input] = (double)(engine()>>63);
+            function(sampleInputs, outputs.data()+row*numOutputs);
+        }
+
+        if (settings.scalarSize){
+            if (!dataset.write(inputs.data(), outputs.data(), run))
+                return false;
+        }
+        else
+            for (size_t row = 0; row<run; row++){
+                buffer += "In: ";
+                appendRow(buffer, inputs.data()+row*numInputs, numInputs);
+                buffer += "\nOut: ";
+                appendRow(buffer, outputs.data()+row*numOutputs, numOutputs);
+                buffer += '\n';
+                // the text is written in large blocks rather than a sample at a time
+                if (buffer.size()>=1024*1024){
+                    text.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+        sample += run;
+    }
+
+    if (settings.scalarSize)
+        return dataset.close();
+    text.write(buffer.data(), buffer.size());
+    text.close();
+    return !text.fail();
+}
+
+bool generateShards(const std::string &fileName, const GeneratorSettings &settings, const TargetFunction &function) {
+    if (settings.topology.size()<2 || std::any_of(settings.topology.begin(), settings.topology.end(),
+                                                  [](int size){ return size<=0; })){
+        std::cerr<<"Every layer of the topology needs at least one neuron"<<std::endl;
+        return false;
+    }
+    size_t numThreads = settings.numThreads ? settings.numThreads :
+                        std::max<unsigned>(1, std::thread::hardware_concurrency());
+    size_t numShards = std::max<size_t>(1, std::min<size_t>(settings.numShards ? settings.numShards : numThreads,
+                                                            std::max<size_t>(1, settings.numSamples)));
+
+    // the samples are spread as evenly as they can be with the first shards taking one more
+    std::atomic<size_t> nextShard(0);
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    auto generate = [&]{
+        for (size_t shard = nextShard++; shard<numShards && !failed; shard = nextShard++){
+            uint64_t perShard = settings.numSamples/numShards, extra = settings.numSamples%numShards;
+            uint64_t first = perShard*shard+std::min<uint64_t>(shard, extra);
+            uint64_t count = perShard+(shard<extra);
+            std::string shardName = numShards == 1 ? fileName : fileName+"."+std::to_string(shard);
+            if (!generateShard(shardName, settings, function, (uint32_t)shard, (uint32_t)numShards, first, count)){
+                std::lock_guard<std::mutex> lock(errorMutex);
+                std::cerr<<shardName<<": could not be written"<<std::endl;
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t thread = 1; thread<std::min(numThreads, numShards); thread++)
+        threads.emplace_back(generate);
+    generate();
+    for (std::thread& thread:threads)
+        thread.join();
+    return !failed;
+}
+
+bool parseTargetFunction(const std::string &name, size_t numInputs, size_t numOutputs, TargetFunction &function) {
+    if (name == "mix" && numInputs>=2 && numOutputs == 1)
+        function = [](const double* inputs, double* outputs){
+            bool a = inputs[0] != 0, b = inputs[1] != 0;
+            outputs[0] = (a|b)&(a^b);
+        };
+    else if (name == "parity" && numOutputs == 1)
+        function = [numInputs](const double* inputs, double* outputs){
+            size_t ones = std::count_if(inputs, inputs+numInputs, [](double input){ return input != 0; });
+            outputs[0] = ones%2;
+        };
+    else if (name == "majority" && numOutputs == 1)
+        function = [numInputs](const double* inputs, double* outputs){
+            size_t ones = std::count_if(inputs, inputs+numInputs, [](double input){ return input != 0; });
+            outputs[0] = 2*ones>numInputs;
+        };
+    else if (name == "count")
+        function = [numInputs, numOutputs](const double* inputs, double* outputs){
+            size_t ones = std::count_if(inputs, inputs+numInputs, [](double input){ return input != 0; });
+            std::fill(outputs, outputs+numOutputs, 0.0);
+            outputs[ones%numOutputs] = 1;
+        };
+    else
+        return false;
+    return true;
+}
@@ -0,0 +1,55 @@
+
+#ifndef NEURALNETWORK_DATAGENERATOR_H
+#define NEURALNETWORK_DATAGENERATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Data Generator
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Generates training data for any number of inputs and outputs on every core. The samples are split
+ *                  into blocks which each draw their random inputs from their own engine seeded by the seed and the
+ *                  block's number, so the same seed gives the same samples however many threads or shards make them.
+ *                  The samples are written as shards in the text format or as a binary dataset, each thread
+ *                  buffering and writing its own shards at the same time as the others
+ ***********************************************************/
+
+// the answer the network should learn for a sample, reads the inputs and writes the outputs
+typedef std::function<void(const double* inputs, double* outputs)> TargetFunction;
+
+// how to generate the data
+struct GeneratorSettings {
+    // the topology written into the files, the first layer is the number of inputs and the last the number of outputs
+    std::vector<int> topology = {2, 4, 1};
+    size_t numSamples = 1000000;
+    // the number of shards the samples are split between, zero makes one per thread. A single shard is written under
+    // the name it was given and the others as "<name>.0", "<name>.1" and so on
+    size_t numShards = 0;
+    // write a binary dataset with values of this size, zero writes the text format
+    uint32_t scalarSize = 0;
+    // the number of threads generating shards, zero uses every core
+    size_t numThreads = 0;
+    uint64_t seed = 1;
+};
+
+// the number of samples drawn from each engine
+constexpr size_t generatorBlockSize = 64*1024;
+
+// generate the samples with inputs of random zeros and ones and the outputs the function gives for them, returns
+// false if a shard could not be written
+bool generateShards(const std::string& fileName, const GeneratorSettings& settings, const TargetFunction& function);
+
+// look up one of the built in target functions for the given number of inputs and outputs, returns false if there is
+// none with the name or it does not work with that many outputs
+//     mix      - the original (a|b)&(a^b) of the first two inputs, one output
+//     parity   - whether an odd number of inputs are one, one output
+//     majority - whether more than half of the inputs are one, one output
+//     count    - the number of inputs that are one modulo the outputs as a one hot vector
+bool parseTargetFunction(const std::string& name, size_t numInputs, size_t numOutputs, TargetFunction& function);
+
+
+#endif //NEURALNETWORK_DATAGENERATOR_H
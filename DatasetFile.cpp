@@ -0,0 +1,381 @@
+
+#include "DatasetFile.h"
+#include "MappedFile.h"
+#include "TrainingDataStream.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// the magic bytes every dataset file starts with
+static const char datasetFileMagic[8] = {'N', 'N', 'D', 'A', 'T', 'A', '\0', '\0'};
+
+// round an offset up to the alignment of the matrices
+static uint64_t align(uint64_t offset) {
+    return (offset+datasetFileAlignment-1)/datasetFileAlignment*datasetFileAlignment;
+}
+
+// whether a matrix of rows read from a file lies inside it, the rows are counted by dividing the space left after the
+// offset so neither the size of the matrix nor its end can overflow
+static bool insideFile(uint64_t offset, uint64_t numRows, uint64_t rowSize, uint64_t size) {
+    return offset<=size && (rowSize == 0 || numRows<=(size-offset)/rowSize);
+}
+
+// write zeros to the file until it reaches the given offset
+static void padTo(std::fstream& file, uint64_t& position, uint64_t offset) {
+    static const char zeros[datasetFileAlignment] = {};
+    file.write(zeros, offset-position);
+    position = offset;
+}
+
+bool convertTrainingData(const std::string &textFile, const std::string &datasetFile, uint32_t scalarSize,
+                         size_t samplesPerShard) {
+    if (scalarSize != sizeof(float) && scalarSize != sizeof(double)){
+        std::cerr<<datasetFile<<": values must be 4 or 8 bytes"<<std::endl;
+        return false;
+    }
+    // stream the text so the whole of it never has to be in memory
+    TrainingDataStream input(textFile, 64*1024*1024);
+    if (!input.isOpen()){
+        std::cerr<<textFile<<": "<<(input.getError().empty() ? "could not be opened" : input.getError())<<std::endl;
+        return false;
+    }
+    const std::vector<int>& topology = input.getTopology();
+    size_t numInputs = (size_t)topology.front(), numOutputs = (size_t)topology.back();
+
+    // the shard being written, its inputs go straight into the file while its outputs go into a temporary file which
+    // is copied onto the end once the number of samples in the shard is known
+    std::vector<std::string> shardNames;
+    std::vector<DatasetFileHeader> headers;
+    std::fstream file, outputs;
+    uint64_t position = 0;
+    size_t totalSamples = 0;
+    std::vector<float> converted;
+
+    auto startShard = [&]{
+        shardNames.push_back(datasetFile+"."+std::to_string(shardNames.size()));
+        headers.emplace_back();
+        DatasetFileHeader& header = headers.back();
+        std::memcpy(header.magic, datasetFileMagic, sizeof(datasetFileMagic));
+        header.version = datasetFileVersion;
+        header.scalarSize = scalarSize;
+        header.numLayers = (uint32_t)topology.size();
+        header.shardIndex = (uint32_t)(shardNames.size()-1);
+        header.firstSample = totalSamples;
+        header.inputsOffset = align(sizeof(DatasetFileHeader)+sizeof(uint32_t)*topology.size());
+        // the header is written again once the whole dataset is known
+        file.open(shardNames.back(), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+        file.write((const char*)&header, sizeof(header));
+        for (int size:topology){
+            uint32_t layerSize = (uint32_t)size;
+            file.write((const char*)&layerSize, sizeof(layerSize));
+        }
+        position = sizeof(DatasetFileHeader)+sizeof(uint32_t)*topology.size();
+        padTo(file, position, header.inputsOffset);
+        outputs.open(shardNames.back()+".outputs", std::fstream::in | std::fstream::out | std::fstream::binary |
+                                                   std::fstream::trunc);
+    };
+    // write rows of values to a file in the size the dataset stores
+    auto writeRows = [&](std::fstream& out, const double* values, size_t count){
+        if (scalarSize == sizeof(double)){
+            out.write((const char*)values, count*sizeof(double));
+            return;
+        }
+        converted.assign(values, values+count);
+        out.write((const char*)converted.data(), count*sizeof(float));
+    };
+    auto finishShard = [&]{
+        DatasetFileHeader& header = headers.back();
+        position += header.numSamples*numInputs*scalarSize;
+        header.outputsOffset = align(position);
+        padTo(file, position, header.outputsOffset);
+        // copy the outputs from the temporary file in blocks
+        outputs.seekg(0);
+        std::vector<char> block(1024*1024);
+        while (outputs.read(block.data(), block.size()) || outputs.gcount()>0)
+            file.write(block.data(), outputs.gcount());
+        header.fileSize = header.outputsOffset+header.numSamples*numOutputs*scalarSize;
+        outputs.close();
+        std::remove((shardNames.back()+".outputs").c_str());
+        file.close();
+    };
+
+    while (const TrainingChunk* chunk = input.nextChunk()){
+        for (size_t first = 0; first<chunk->count;){
+            if (!file.is_open())
+                startShard();
+            // fill the shard up to the number of samples it may hold
+            size_t count = chunk->count-first;
+            if (samplesPerShard)
+                count = std::min(count, samplesPerShard-headers.back().numSamples);
+            writeRows(file, chunk->inputs.data()+first*numInputs, count*numInputs);
+            writeRows(outputs, chunk->outputs.data()+first*numOutputs, count*numOutputs);
+            headers.back().numSamples += count;
+            totalSamples += count;
+            first += count;
+            if (samplesPerShard && headers.back().numSamples == samplesPerShard)
+                finishShard();
+        }
+    }
+    if (!input.getError().empty()){
+        std::cerr<<textFile<<": "<<input.getError()<<std::endl;
+        if (file.is_open()) finishShard();
+        for (std::string& name:shardNames)
+            std::remove(name.c_str());
+        return false;
+    }
+    // an empty dataset still gets a shard holding its topology
+    if (shardNames.empty())
+        startShard();
+    if (file.is_open())
+        finishShard();
+
+    // now that every shard is written fill in the number of shards and samples in all of their headers
+    bool written = true;
+    for (size_t shard = 0; shard<shardNames.size(); shard++){
+        headers[shard].numShards = (uint32_t)shardNames.size();
+        headers[shard].totalSamples = totalSamples;
+        file.open(shardNames[shard], std::fstream::in | std::fstream::out | std::fstream::binary);
+        file.seekp(0);
+        file.write((const char*)&headers[shard], sizeof(DatasetFileHeader));
+        file.close();
+        written = written && !file.fail();
+    }
+    // a dataset in a single shard is stored under the name it was given
+    if (shardNames.size() == 1)
+        written = written && std::rename(shardNames[0].c_str(), datasetFile.c_str()) == 0;
+    if (!written)
+        std::cerr<<datasetFile<<": could not be written"<<std::endl;
+    return written;
+}
+
+bool Dataset::open(const std::string &fileName) {
+    shards.clear();
+    topology.clear();
+    numSamples = 0;
+    error.clear();
+    // a dataset in one file is under its own name, otherwise its first shard is
+    std::string firstShard = fileName;
+    std::fstream test(fileName, std::fstream::in);
+    if (!test)
+        firstShard = fileName+".0";
+    test.close();
+    if (!openShard(firstShard, 0))
+        return false;
+
+    // the first shard says how many there are
+    const DatasetFileHeader* header = (const DatasetFileHeader*)shards[0].mapping.get();
+    for (uint32_t shard = 1; shard<header->numShards; shard++)
+        if (!openShard(fileName+"."+std::to_string(shard), shard))
+            return false;
+    if (numSamples != header->totalSamples){
+        error = fileName+": shards hold "+std::to_string(numSamples)+" samples instead of "+
+                std::to_string(header->totalSamples);
+        shards.clear();
+        return false;
+    }
+    return true;
+}
+
+bool Dataset::openShard(const std::string &fileName, uint32_t shardIndex) {
+    size_t size = 0;
+    std::shared_ptr<const void> mapping = mapFile(fileName, size);
+    if (!mapping){
+        error = fileName+": could not be opened";
+        return false;
+    }
+    const char* data = (const char*)mapping.get();
+    const DatasetFileHeader* header = (const DatasetFileHeader*)data;
+    const uint32_t* layers = (const uint32_t*)(data+sizeof(DatasetFileHeader));
+
+    // check the header describes matrices which fit inside the file and match the other shards
+    if (size<sizeof(DatasetFileHeader) || std::memcmp(header->magic, datasetFileMagic, sizeof(datasetFileMagic)) != 0)
+        error = "not a dataset file";
+    else if (header->version != datasetFileVersion)
+        error = "unsupported version "+std::to_string(header->version);
+    else if (header->scalarSize != sizeof(float) && header->scalarSize != sizeof(double))
+        error = "unsupported value size "+std::to_string(header->scalarSize);
+    else if (header->fileSize != size || header->numLayers<2 ||
+             sizeof(DatasetFileHeader)+sizeof(uint32_t)*(uint64_t)header->numLayers>size)
+        error = "file is truncated";
+    else if (header->shardIndex != shardIndex || header->firstSample != numSamples ||
+             (shardIndex>0 && (header->scalarSize != scalarSize ||
+                               !std::equal(topology.begin(), topology.end(), layers, layers+header->numLayers))))
+        error = "does not match the other shards of the dataset";
+    else {
+        uint64_t inputSize = (uint64_t)layers[0]*header->scalarSize;
+        uint64_t outputSize = (uint64_t)layers[header->numLayers-1]*header->scalarSize;
+        if (header->inputsOffset%datasetFileAlignment || header->outputsOffset%datasetFileAlignment ||
+            !insideFile(header->inputsOffset, header->numSamples, inputSize, size) ||
+            !insideFile(header->outputsOffset, header->numSamples, outputSize, size))
+            error = "samples are outside the file";
+    }
+    if (!error.empty()){
+        error = fileName+": "+error;
+        shards.clear();
+        return false;
+    }
+
+    if (shardIndex == 0){
+        topology.assign(layers, layers+header->numLayers);
+        scalarSize = header->scalarSize;
+    }
+    shards.push_back(Shard{mapping, numSamples, (size_t)header->numSamples, data+header->inputsOffset,
+                           data+header->outputsOffset});
+    numSamples += header->numSamples;
+    return true;
+}
+
+const std::vector<int> &Dataset::getTopology() const {
+    return topology;
+}
+
+size_t Dataset::getNumInputs() const {
+    return (size_t)topology.front();
+}
+
+size_t Dataset::getNumOutputs() const {
+    return (size_t)topology.back();
+}
+
+size_t Dataset::getNumSamples() const {
+    return numSamples;
+}
+
+size_t Dataset::getNumShards() const {
+    return shards.size();
+}
+
+uint32_t Dataset::getScalarSize() const {
+    return scalarSize;
+}
+
+const std::string &Dataset::getError() const {
+    return error;
+}
+
+bool DatasetShardWriter::open(const std::string &fileName, const std::vector<int> &topology, uint32_t scalarSize,
+                              uint32_t shardIndex, uint32_t numShards, uint64_t firstSample, uint64_t numSamples,
+                              uint64_t totalSamples) {
+    if ((scalarSize != sizeof(float) && scalarSize != sizeof(double)) || topology.size()<2)
+        return false;
+    numInputs = (size_t)topology.front();
+    numOutputs = (size_t)topology.back();
+    written = 0;
+    failed = false;
+
+    // everything about the shard is known up front so its header is right from the start
+    header = DatasetFileHeader{};
+    std::memcpy(header.magic, datasetFileMagic, sizeof(datasetFileMagic));
+    header.version = datasetFileVersion;
+    header.scalarSize = scalarSize;
+    header.numLayers = (uint32_t)topology.size();
+    header.shardIndex = shardIndex;
+    header.numShards = numShards;
+    header.numSamples = numSamples;
+    header.firstSample = firstSample;
+    header.totalSamples = totalSamples;
+    uint64_t position = sizeof(DatasetFileHeader)+sizeof(uint32_t)*topology.size();
+    header.inputsOffset = align(position);
+    header.outputsOffset = align(header.inputsOffset+numSamples*numInputs*scalarSize);
+    header.fileSize = header.outputsOffset+numSamples*numOutputs*scalarSize;
+
+    file.open(fileName, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+    if (!file)
+        return false;
+    file.write((const char*)&header, sizeof(header));
+    for (int size:topology){
+        uint32_t layerSize = (uint32_t)size;
+        file.write((const char*)&layerSize, sizeof(layerSize));
+    }
+    padTo(file, position, header.inputsOffset);
+    // the rows are written at their offsets so the gap between the matrices is left as zeros by the file system,
+    // writing the last byte makes the file its full size even before they are
+    if (header.fileSize>position){
+        file.seekp(header.fileSize-1);
+        file.put('\0');
+    }
+    return (bool)file;
+}
+
+bool DatasetShardWriter::write(const double *inputs, const double *outputs, size_t count) {
+    if (written+count>header.numSamples){
+        failed = true;
+        return false;
+    }
+    auto writeRows = [&](uint64_t offset, const double* values, size_t numValues){
+        file.seekp(offset);
+        if (header.scalarSize == sizeof(double)){
+            file.write((const char*)values, numValues*sizeof(double));
+            return;
+        }
+        converted.assign(values, values+numValues);
+        file.write((const char*)converted.data(), numValues*sizeof(float));
+    };
+    writeRows(header.inputsOffset+written*numInputs*header.scalarSize, inputs, count*numInputs);
+    writeRows(header.outputsOffset+written*numOutputs*header.scalarSize, outputs, count*numOutputs);
+    written += count;
+    failed = failed || !file;
+    return !failed;
+}
+
+bool DatasetShardWriter::close() {
+    file.close();
+    return !failed && !file.fail() && written == header.numSamples;
+}
+
+// the last shard starting at or before the sample
+const Dataset::Shard &Dataset::findShard(size_t sample) const {
+    std::vector<Shard>::const_iterator shard = std::upper_bound(shards.begin(), shards.end(), sample,
+            [](size_t value, const Shard& candidate){ return value<candidate.first; });
+    return *(shard-1);
+}
+
+template<typename T>
+DatasetBatch<T> Dataset::getBatch(size_t first, size_t count) const {
+    if (first>=numSamples)
+        return DatasetBatch<T>{nullptr, nullptr, 0};
+    const Shard& shard = findShard(first);
+    size_t offset = first-shard.first;
+    count = std::min(count, shard.count-offset);
+    // the samples can only be viewed in place when they are stored as the type asked for
+    if (sizeof(T) != scalarSize)
+        return DatasetBatch<T>{nullptr, nullptr, count};
+    return DatasetBatch<T>{(const T*)shard.inputs+offset*getNumInputs(), (const T*)shard.outputs+offset*getNumOutputs(),
+                           count};
+}
+
+// copy values out of the dataset converting them to doubles
+template<typename T>
+static void copyValues(const char* from, size_t count, double* to) {
+    const T* values = (const T*)from;
+    std::copy(values, values+count, to);
+}
+
+void Dataset::copyBatch(size_t first, size_t count, double *inputs, double *outputs) const {
+    size_t numInputs = getNumInputs(), numOutputs = getNumOutputs();
+    count = std::min(count, numSamples-std::min(first, numSamples));
+    // copy the part of the batch in each shard it spans
+    while (count>0){
+        const Shard& shard = findShard(first);
+        size_t offset = first-shard.first, run = std::min(count, shard.count-offset);
+        const char* inputRows = shard.inputs+offset*numInputs*scalarSize;
+        const char* outputRows = shard.outputs+offset*numOutputs*scalarSize;
+        if (scalarSize == sizeof(float)){
+            copyValues<float>(inputRows, run*numInputs, inputs);
+            copyValues<float>(outputRows, run*numOutputs, outputs);
+        } else {
+            copyValues<double>(inputRows, run*numInputs, inputs);
+            copyValues<double>(outputRows, run*numOutputs, outputs);
+        }
+        inputs += run*numInputs;
+        outputs += run*numOutputs;
+        first += run;
+        count -= run;
+    }
+}
+
+// batches can be viewed as either precision
+template DatasetBatch<float> Dataset::getBatch<float>(size_t, size_t) const;
+template DatasetBatch<double> Dataset::getBatch<double>(size_t, size_t) const;
@@ -0,0 +1,126 @@
+
+#ifndef NEURALNETWORK_DATASETFILE_H
+#define NEURALNETWORK_DATASETFILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+
+/**********************************************************
+ * Program	:  Dataset File
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A binary file for training data. The file starts with a header and the topology followed by every
+ *                  sample's inputs as one contiguous matrix and then every sample's outputs as another, stored as
+ *                  float32 or float64. A dataset can be split into shards named "<name>.0", "<name>.1" and so on. The
+ *                  files are memory mapped when read so batches are served straight out of the file without parsing
+ *                  or copying anything
+ ***********************************************************/
+
+// the header at the start of every dataset file and shard
+struct DatasetFileHeader {
+    // "NNDATA" followed by zeros
+    char magic[8];
+    // the version of the format the file was written with
+    uint32_t version;
+    // the size in bytes of every stored value, 4 for float32 and 8 for float64
+    uint32_t scalarSize;
+    // the number of layers in the topology which follows the header
+    uint32_t numLayers;
+    // the shard the file holds and the number of shards in the dataset
+    uint32_t shardIndex, numShards;
+    uint32_t reserved;
+    // the number of samples in the file, the index in the dataset of its first one and the samples in every shard
+    uint64_t numSamples, firstSample, totalSamples;
+    // where the matrices of inputs and outputs start
+    uint64_t inputsOffset, outputsOffset;
+    // the total size of the file used to check it was not cut short
+    uint64_t fileSize;
+};
+
+// the current version of the format and the alignment of the matrices
+constexpr uint32_t datasetFileVersion = 1;
+constexpr uint64_t datasetFileAlignment = 64;
+
+// convert a text training data file into a dataset storing values of the given size, the dataset is split into shards
+// of the given number of samples unless it is zero, returns false if the text could not be read or the dataset written
+bool convertTrainingData(const std::string& textFile, const std::string& datasetFile, uint32_t scalarSize = 8,
+                         size_t samplesPerShard = 0);
+
+// writes one shard of a dataset whose size is known before it is written, so the shards of a dataset can be written
+// at the same time without waiting on each other. The rows are added a block at a time and go straight to their place
+// in the file
+class DatasetShardWriter {
+public:
+    // create the shard holding numSamples samples from firstSample of a dataset of totalSamples split into numShards,
+    // returns false if it could not be created
+    bool open(const std::string& fileName, const std::vector<int>& topology, uint32_t scalarSize, uint32_t shardIndex,
+              uint32_t numShards, uint64_t firstSample, uint64_t numSamples, uint64_t totalSamples);
+    // add the next samples to the shard, returns false if they could not be written or the shard is already full
+    bool write(const double* inputs, const double* outputs, size_t count);
+    // finish the shard, returns false if a write failed or the shard was not filled
+    bool close();
+
+private:
+    std::fstream file;
+    DatasetFileHeader header = {};
+    size_t numInputs = 0, numOutputs = 0;
+    // the samples written so far
+    uint64_t written = 0;
+    bool failed = false;
+    std::vector<float> converted;
+};
+
+// a run of samples viewed straight out of a dataset
+template<typename T>
+struct DatasetBatch {
+    const T* inputs;
+    const T* outputs;
+    size_t count;
+};
+
+class Dataset {
+public:
+    // map a dataset or every shard of it, returns false if it is missing or invalid
+    bool open(const std::string& fileName);
+
+    const std::vector<int>& getTopology() const;
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+    size_t getNumSamples() const;
+    size_t getNumShards() const;
+    uint32_t getScalarSize() const;
+    // what was wrong with the dataset if it could not be opened
+    const std::string& getError() const;
+
+    // view up to count samples starting at the given one without copying them, the view stops at the end of the
+    // shard holding the first sample and its pointers are null if the dataset does not store values of type T
+    template<typename T>
+    DatasetBatch<T> getBatch(size_t first, size_t count) const;
+    // copy samples into rows of doubles whatever the dataset stores, the samples may span shards
+    void copyBatch(size_t first, size_t count, double* inputs, double* outputs) const;
+
+private:
+    // a mapped shard and where its matrices are
+    struct Shard {
+        std::shared_ptr<const void> mapping;
+        size_t first, count;
+        const char* inputs;
+        const char* outputs;
+    };
+    // map a single file as the given shard
+    bool openShard(const std::string& fileName, uint32_t shardIndex);
+    // the shard holding a sample
+    const Shard& findShard(size_t sample) const;
+
+    std::vector<Shard> shards;
+    std::vector<int> topology;
+    size_t numSamples = 0;
+    uint32_t scalarSize = 0;
+    std::string error;
+};
+
+
+#endif //NEURALNETWORK_DATASETFILE_H
@@ -0,0 +1,41 @@
+
+#include "Evaluation.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Evaluator::Evaluator(const NeuralNetwork &network) : model(network), workspace(model),
+                                                      outputs(batchSize*model.getNumOutputs()) {}
+
+void Evaluator::add(const double *inputs, const double *targets, size_t count) {
+    size_t numInputs = model.getNumInputs(), numOutputs = model.getNumOutputs();
+    for (size_t first = 0; first<count; first += batchSize){
+        size_t batch = std::min(batchSize, count-first);
+        model.predictBatch(inputs+first*numInputs, batch, outputs.data(), workspace);
+        for (size_t sample = 0; sample<batch; sample++){
+            const double* output = outputs.data()+sample*numOutputs;
+            const double* target = targets+(first+sample)*numOutputs;
+            for (size_t index = 0; index<numOutputs; index++)
+                squaredError += (target[index]-output[index])*(target[index]-output[index]);
+            if (numOutputs == 1)
+                correct += std::abs(target[0]-output[0])<0.5;
+            else
+                correct += std::max_element(output, output+numOutputs)-output ==
+                           std::max_element(target, target+numOutputs)-target;
+        }
+    }
+    this->count += count;
+}
+
+Evaluation Evaluator::result() const {
+    Evaluation evaluation;
+    evaluation.count = count;
+    if (count == 0)
+        return evaluation;
+    evaluation.rmse = std::sqrt(squaredError/(count*model.getNumOutputs()));
+    // a network whose weights blew up is as bad as a network can be
+    if (!std::isfinite(evaluation.rmse))
+        evaluation.rmse = std::numeric_limits<double>::infinity();
+    evaluation.accuracy = (double)correct/count;
+    return evaluation;
+}
@@ -0,0 +1,51 @@
+
+#ifndef NEURALNETWORK_EVALUATION_H
+#define NEURALNETWORK_EVALUATION_H
+
+#include <vector>
+#include "Model.h"
+#include "NeuralNetwork.h"
+
+/**********************************************************
+ * Program	:  Evaluation
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Measures how well a network does on samples it is not trained on. The network is frozen into a model
+ *                  and the samples are run through it in batches, which is much faster than feeding them forward one
+ *                  at a time and never changes the network being trained
+ ***********************************************************/
+
+// how a network did on a set of samples
+struct Evaluation {
+    // the number of samples the network was run on
+    size_t count = 0;
+    // the root mean squared error over every output of every sample
+    double rmse = 0;
+    // the fraction of samples given the right answer, for a single output the answer is right when it is within 0.5
+    // of the target and for many outputs when the largest output is the largest target
+    double accuracy = 0;
+};
+
+class Evaluator {
+public:
+    // freeze a copy of the network's current weights to run the samples through
+    explicit Evaluator(const NeuralNetwork& network);
+
+    // run samples stored one after another through the network and add how it did to the totals
+    void add(const double* inputs, const double* targets, size_t count);
+    // how the network did on every sample added so far
+    Evaluation result() const;
+
+private:
+    Model model;
+    Workspace workspace;
+    // the outputs of the batch being scored
+    std::vector<double> outputs;
+    double squaredError = 0;
+    size_t count = 0, correct = 0;
+    // the number of samples fed forward together
+    constexpr static size_t batchSize = 256;
+};
+
+
+#endif //NEURALNETWORK_EVALUATION_H
@@ -0,0 +1,180 @@
+
+#ifndef NEURALNETWORK_FIXEDNETWORK_H
+#define NEURALNETWORK_FIXEDNETWORK_H
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Activation.h"
+#include "Kernels.h"
+#include "ModelFile.h"
+#include "NeuralNetwork.h"
+
+/**********************************************************
+ * Program	:  Fixed Network
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A network whose layer sizes are template parameters, FixedNetwork<2,4,1> being the xor network. The
+ *                  weights of every layer live in a std::array inside the network, the loops over the neurons and
+ *                  their inputs are unrolled at compile time and nothing is allocated, so running a tiny network costs
+ *                  nanoseconds instead of the microseconds spent on the bookkeeping of a network sized at run time.
+ *                  It is only meant for tiny networks as every weight becomes code. The network is read from and
+ *                  saved to the same model files as NeuralNetwork. Unlike the other templates it lives entirely in
+ *                  the header as every topology is its own type
+ ***********************************************************/
+
+// the weights of a layer of Neurons neurons each fed by Inputs neurons and the bias of the layer before
+template<typename Scalar, size_t Inputs, size_t Neurons>
+struct FixedLayer {
+    // the number of weights feeding into every neuron including the bias
+    constexpr static size_t numInputs = Inputs+1;
+    // row major matrix of the weights, one row of numInputs weights per neuron with the bias weight last
+    std::array<Scalar, Neurons*numInputs> weights{};
+    Activation activation = Activation::TANH;
+};
+
+// the tuple of every layer after the input layer given the sizes of all of the layers
+template<typename Scalar, typename Sizes, typename Layers>
+struct FixedLayerTuple;
+template<typename Scalar, size_t... Sizes, size_t... Layer>
+struct FixedLayerTuple<Scalar, std::index_sequence<Sizes...>, std::index_sequence<Layer...>> {
+    constexpr static std::array<size_t, sizeof...(Sizes)> sizes = {Sizes...};
+    typedef std::tuple<FixedLayer<Scalar, sizes[Layer], sizes[Layer+1]>...> type;
+};
+
+template<typename Scalar, size_t... Sizes>
+class BasicFixedNetwork {
+    static_assert(sizeof...(Sizes)>=2, "a network needs at least an input and an output layer");
+public:
+    constexpr static size_t numLayers = sizeof...(Sizes);
+    constexpr static std::array<size_t, numLayers> topology = {Sizes...};
+    constexpr static size_t numInputs = topology.front(), numOutputs = topology.back();
+
+    // feed the inputs forward and write the outputs, the network is never changed so any number of threads can run
+    // it at once
+    void predict(const Scalar* inputs, Scalar* outputs) const {
+        std::array<Scalar, numInputs+1> values;
+        std::copy_n(inputs, numInputs, values.data());
+        values[numInputs] = biases[0];
+        forward<1>(values.data(), outputs);
+    }
+    std::array<Scalar, numOutputs> predict(const std::array<Scalar, numInputs>& inputs) const {
+        std::array<Scalar, numOutputs> outputs;
+        predict(inputs.data(), outputs.data());
+        return outputs;
+    }
+
+    // copy the weights of a network with the same topology, returns false if its layers are not the same sizes
+    template<typename Accumulator>
+    bool assign(const BasicNeuralNetwork<Scalar, Accumulator>& network) {
+        const auto& layers = network.getPackedLayers();
+        if (layers.size() != numLayers)
+            return false;
+        for (size_t layer = 0; layer<numLayers; layer++)
+            if (layers[layer].numNeurons != topology[layer] ||
+                layers[layer].numInputs != (layer == 0 ? 0 : topology[layer-1]+1))
+                return false;
+        for (size_t layer = 0; layer<numLayers; layer++)
+            biases[layer] = layers[layer].outputs.back();
+        assignLayers(layers, std::make_index_sequence<numLayers-1>());
+        return true;
+    }
+    // unpack the weights into a network which can be saved or trained further
+    BasicNeuralNetwork<Scalar> toNetwork() const {
+        typedef typename BasicNeuralNetwork<Scalar>::PackedLayer PackedLayer;
+        std::vector<PackedLayer> layers(numLayers);
+        for (size_t layer = 0; layer<numLayers; layer++){
+            layers[layer].numNeurons = topology[layer];
+            layers[layer].numInputs = layer == 0 ? 0 : topology[layer-1]+1;
+            layers[layer].outputs.assign(topology[layer]+1, 0);
+            layers[layer].outputs.back() = biases[layer];
+            layers[layer].gradients.assign(topology[layer]+1, 0);
+        }
+        unpackLayers(layers, std::make_index_sequence<numLayers-1>());
+        return BasicNeuralNetwork<Scalar>(std::move(layers), 0, 0, 100);
+    }
+
+private:
+    typedef typename FixedLayerTuple<Scalar, std::index_sequence<Sizes...>,
+                                     std::make_index_sequence<numLayers-1>>::type Layers;
+
+    // run the values of the layer before, followed by its bias, through the given layer and everything after it
+    template<size_t Layer>
+    void forward(const Scalar* inputs, Scalar* outputs) const {
+        const auto& layer = std::get<Layer-1>(layers);
+        constexpr size_t numNeurons = topology[Layer];
+        std::array<Scalar, numNeurons+1> values;
+        sums(layer, inputs, values.data(), std::make_index_sequence<numNeurons>());
+        // the activations are the vector kernels the other networks use, tanh of a whole layer costs far more than
+        // all of its sums
+        getKernels<Scalar, Scalar>().activate[(size_t)layer.activation](values.data(), numNeurons);
+        if constexpr (Layer+1 == numLayers)
+            std::copy_n(values.data(), numNeurons, outputs);
+        else {
+            values[numNeurons] = biases[Layer];
+            forward<Layer+1>(values.data(), outputs);
+        }
+    }
+
+    // the sum of every neuron of a layer, unrolled over the neurons and their inputs
+    template<typename Layer, size_t... Neuron>
+    static void sums(const Layer& layer, const Scalar* inputs, Scalar* values, std::index_sequence<Neuron...>) {
+        ((values[Neuron] = dot(layer.weights.data()+Neuron*Layer::numInputs, inputs,
+                               std::make_index_sequence<Layer::numInputs>())), ...);
+    }
+    template<size_t... Input>
+    static Scalar dot(const Scalar* weights, const Scalar* inputs, std::index_sequence<Input...>) {
+        return (Scalar(0)+...+(weights[Input]*inputs[Input]));
+    }
+
+    // copy the weights and activation of every layer after the input layer in or out of the packed layers
+    template<typename PackedLayers, size_t... Layer>
+    void assignLayers(const PackedLayers& packed, std::index_sequence<Layer...>) {
+        ((std::copy(packed[Layer+1].weights.begin(), packed[Layer+1].weights.end(),
+                    std::get<Layer>(layers).weights.begin()),
+          std::get<Layer>(layers).activation = packed[Layer+1].activation), ...);
+    }
+    template<typename PackedLayers, size_t... Layer>
+    void unpackLayers(PackedLayers& packed, std::index_sequence<Layer...>) const {
+        ((packed[Layer+1].weights.assign(std::get<Layer>(layers).weights.begin(),
+                                         std::get<Layer>(layers).weights.end()),
+          packed[Layer+1].deltaWeights.assign(std::get<Layer>(layers).weights.size(), 0),
+          packed[Layer+1].activation = std::get<Layer>(layers).activation), ...);
+    }
+
+    Layers layers;
+    // the value of the bias neuron of every layer which is fed into the layer after it
+    std::array<Scalar, numLayers> biases{};
+};
+
+// the fixed network in double and single precision
+template<size_t... Sizes>
+using FixedNetwork = BasicFixedNetwork<double, Sizes...>;
+template<size_t... Sizes>
+using FloatFixedNetwork = BasicFixedNetwork<float, Sizes...>;
+
+// read a model file into a fixed network, the weights are converted if the file was saved in the other precision.
+// Returns false if the file is missing, invalid or does not have the topology of the network
+template<typename Scalar, size_t... Sizes>
+bool loadFixedNetwork(const std::string& fileName, BasicFixedNetwork<Scalar, Sizes...>& network) {
+    BasicNeuralNetwork<Scalar> loaded(std::vector<int>{});
+    if (!loadNetworkFile(fileName, loaded))
+        return false;
+    if (!network.assign(loaded)){
+        std::cerr<<fileName<<": does not have the topology of the fixed network"<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+// save a fixed network to a model file any network can be loaded from, returns false if it could not be written
+template<typename Scalar, size_t... Sizes>
+bool saveFixedNetwork(const BasicFixedNetwork<Scalar, Sizes...>& network, const std::string& fileName) {
+    return saveModelFile(network.toNetwork(), fileName);
+}
+
+
+#endif //NEURALNETWORK_FIXEDNETWORK_H
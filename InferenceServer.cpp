@@ -0,0 +1,320 @@
+
+#include "InferenceServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// the number of recent requests whose latency is kept for the percentiles
+static constexpr size_t latencyWindow = 1<<16;
+
+// read or write all of a buffer, going round again when a call is cut short
+static bool readFully(int descriptor, void* buffer, size_t size) {
+    char* position = (char*)buffer;
+    while (size>0){
+        ssize_t done = read(descriptor, position, size);
+        if (done<0 && errno == EINTR) continue;
+        if (done<=0) return false;
+        position += done;
+        size -= (size_t)done;
+    }
+    return true;
+}
+
+static bool writeFully(int descriptor, const void* buffer, size_t size) {
+    const char* position = (const char*)buffer;
+    while (size>0){
+        // a client that went away must not kill the server with a broken pipe signal
+        ssize_t done = send(descriptor, position, size, MSG_NOSIGNAL);
+        if (done<0 && errno == ENOTSOCK)
+            done = write(descriptor, position, size);
+        if (done<0 && errno == EINTR) continue;
+        if (done<=0) return false;
+        position += done;
+        size -= (size_t)done;
+    }
+    return true;
+}
+
+bool readFrame(int descriptor, std::vector<double> &values, uint32_t expected) {
+    uint32_t count = 0;
+    if (!readFully(descriptor, &count, sizeof(count)))
+        return false;
+    // a frame of any other size is refused before anything is allocated for it
+    if (count != 0 && count != expected)
+        return false;
+    values.resize(count);
+    return readFully(descriptor, values.data(), count*sizeof(double));
+}
+
+bool writeFrame(int descriptor, const double *values, uint32_t count) {
+    // one write for the whole frame so small answers go out in a single packet
+    std::vector<char> frame(sizeof(count)+count*sizeof(double));
+    std::memcpy(frame.data(), &count, sizeof(count));
+    if (count>0)
+        std::memcpy(frame.data()+sizeof(count), values, count*sizeof(double));
+    return writeFully(descriptor, frame.data(), frame.size());
+}
+
+// fill in the address of a unix socket, returns false if the path is too long for one
+static bool socketAddress(const std::string& path, sockaddr_un& address) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size()>=sizeof(address.sun_path))
+        return false;
+    std::memcpy(address.sun_path, path.c_str(), path.size()+1);
+    return true;
+}
+
+int connectToServer(const std::string &path, uint32_t &numInputs, uint32_t &numOutputs) {
+    sockaddr_un address;
+    if (!socketAddress(path, address))
+        return -1;
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor<0)
+        return -1;
+    uint32_t sizes[2];
+    if (connect(descriptor, (const sockaddr*)&address, sizeof(address)) != 0 ||
+        !readFully(descriptor, sizes, sizeof(sizes))){
+        close(descriptor);
+        return -1;
+    }
+    numInputs = sizes[0];
+    numOutputs = sizes[1];
+    return descriptor;
+}
+
+// start the thread running the batches
+InferenceServer::InferenceServer(std::shared_ptr<const Model> model, size_t maxBatchSize, double latencyBudget,
+                                 size_t layerThreads) :
+        model(std::move(model)), maxBatchSize(std::max<size_t>(1, maxBatchSize)), latencyBudget(latencyBudget),
+        started(std::chrono::steady_clock::now()) {
+    if (layerThreads != 1)
+        layerPool = std::make_shared<WorkStealingPool>(layerThreads);
+    latencies.reserve(latencyWindow);
+    batcher = std::thread(&InferenceServer::batchLoop, this);
+}
+
+// answer whatever is still queued and wait for the batching thread to exit
+InferenceServer::~InferenceServer() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queueChanged.notify_one();
+    batcher.join();
+}
+
+std::shared_ptr<InferenceServer::Request> InferenceServer::submit(const double *inputs) {
+    std::shared_ptr<Request> request = std::make_shared<Request>();
+    request->inputs.assign(inputs, inputs+model->getNumInputs());
+    request->queued = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(request);
+    }
+    queueChanged.notify_one();
+    return request;
+}
+
+void InferenceServer::wait(Request &request) {
+    std::unique_lock<std::mutex> lock(mutex);
+    requestsAnswered.wait(lock, [&]{ return request.answered; });
+}
+
+void InferenceServer::predict(const double *inputs, double *outputs) {
+    std::shared_ptr<Request> request = submit(inputs);
+    wait(*request);
+    std::copy(request->outputs.begin(), request->outputs.end(), outputs);
+}
+
+// wait for a request, give others until the batch is full or the first request's budget runs out to join it and run
+// them all together
+void InferenceServer::batchLoop() {
+    Workspace workspace;
+    workspace.pool = layerPool;
+    std::vector<std::shared_ptr<Request>> batch;
+    std::vector<double> inputs, outputs;
+    size_t numInputs = model->getNumInputs(), numOutputs = model->getNumOutputs();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true){
+        queueChanged.wait(lock, [&]{ return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+        queueChanged.wait_until(lock, queue.front()->queued+
+                                      std::chrono::duration_cast<std::chrono::steady_clock::duration>(latencyBudget),
+                                [&]{ return stopping || queue.size()>=maxBatchSize; });
+        size_t count = std::min(queue.size(), maxBatchSize);
+        batch.assign(queue.begin(), queue.begin()+count);
+        queue.erase(queue.begin(), queue.begin()+count);
+        lock.unlock();
+
+        // gather the inputs into rows, run them and hand the outputs back to every request
+        inputs.resize(count*numInputs);
+        outputs.resize(count*numOutputs);
+        for (size_t sample = 0; sample<count; sample++)
+            std::copy(batch[sample]->inputs.begin(), batch[sample]->inputs.end(), inputs.begin()+sample*numInputs);
+        model->predictBatch(inputs.data(), count, outputs.data(), workspace);
+        for (size_t sample = 0; sample<count; sample++)
+            batch[sample]->outputs.assign(outputs.begin()+sample*numOutputs, outputs.begin()+(sample+1)*numOutputs);
+
+        std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+        lock.lock();
+        for (std::shared_ptr<Request>& request:batch){
+            request->answered = true;
+            double latency = std::chrono::duration<double>(finished-request->queued).count();
+            if (latencies.size()<latencyWindow)
+                latencies.push_back(latency);
+            else
+                latencies[nextLatency] = latency;
+            nextLatency = (nextLatency+1)%latencyWindow;
+        }
+        requests += count;
+        batches++;
+        requestsAnswered.notify_all();
+    }
+}
+
+bool InferenceServer::serveStream(int input, int output) {
+    uint32_t sizes[2] = {(uint32_t)model->getNumInputs(), (uint32_t)model->getNumOutputs()};
+    if (!writeFully(output, sizes, sizeof(sizes)))
+        return true;
+
+    // the reader queues every request as soon as it arrives while this thread answers them in order, a null request
+    // stands for a request for the statistics
+    std::mutex pendingMutex;
+    std::condition_variable pendingChanged;
+    std::deque<std::shared_ptr<Request>> pending;
+    bool finished = false, malformed = false;
+    std::thread reader([&]{
+        std::vector<double> values;
+        uint32_t count = 0;
+        while (readFully(input, &count, sizeof(count))){
+            // the count comes from the client so it is checked before anything is allocated for the request
+            if (count != 0 && count != model->getNumInputs()){
+                malformed = true;
+                break;
+            }
+            values.resize(count);
+            if (!readFully(input, values.data(), count*sizeof(double)))
+                break;
+            std::shared_ptr<Request> request = values.empty() ? nullptr : submit(values.data());
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending.push_back(request);
+            pendingChanged.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        finished = true;
+        pendingChanged.notify_one();
+    });
+
+    bool open = true;
+    while (true){
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex);
+            pendingChanged.wait(lock, [&]{ return finished || !pending.empty(); });
+            if (pending.empty()) break;
+            request = pending.front();
+            pending.pop_front();
+        }
+        // keep draining the requests after the client stops listening so the reader is never left blocked
+        if (!request){
+            InferenceStatistics statistics = getStatistics();
+            double values[inferenceStatisticsSize] = {(double)statistics.requests, (double)statistics.batches,
+                                                      statistics.p50Latency, statistics.p99Latency,
+                                                      statistics.requestsPerSecond, statistics.averageBatchSize};
+            open = open && writeFrame(output, values, inferenceStatisticsSize);
+            continue;
+        }
+        wait(*request);
+        open = open && writeFrame(output, request->outputs.data(), (uint32_t)request->outputs.size());
+    }
+    reader.join();
+    if (malformed)
+        std::cerr<<"Request does not have "<<model->getNumInputs()<<" inputs, closing the connection"<<std::endl;
+    return !malformed;
+}
+
+bool InferenceServer::serveSocket(const std::string &path) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)){
+        std::cerr<<path<<": socket path is too long"<<std::endl;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        // a socket left behind by a server that did not shut down cleanly is replaced
+        unlink(path.c_str());
+        if (listener<0 || bind(listener, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0){
+            std::cerr<<path<<": "<<std::strerror(errno)<<std::endl;
+            if (listener>=0) close(listener);
+            listener = -1;
+            return false;
+        }
+        listening = true;
+    }
+
+    // every connection is served on its own thread until it closes or the server stops
+    while (true){
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection<0 && errno == EINTR) continue;
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        if (connection<0 || !listening){
+            if (connection>=0) close(connection);
+            break;
+        }
+        connections.push_back(connection);
+        std::thread([this, connection]{
+            serveStream(connection, connection);
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            connections.erase(std::find(connections.begin(), connections.end(), connection));
+            close(connection);
+            connectionClosed.notify_all();
+        }).detach();
+    }
+    // wait for the connections to finish their last requests
+    std::unique_lock<std::mutex> lock(connectionsMutex);
+    connectionClosed.wait(lock, [&]{ return connections.empty(); });
+    close(listener);
+    listener = -1;
+    unlink(path.c_str());
+    return true;
+}
+
+// shutting the sockets down wakes up the accept and every read blocked on them
+void InferenceServer::stop() {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    if (!listening) return;
+    listening = false;
+    shutdown(listener, SHUT_RDWR);
+    for (int connection:connections)
+        shutdown(connection, SHUT_RDWR);
+}
+
+InferenceStatistics InferenceServer::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    InferenceStatistics statistics = {requests, batches, 0, 0, 0, 0};
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-started).count();
+    statistics.requestsPerSecond = seconds>0 ? requests/seconds : 0;
+    statistics.averageBatchSize = batches ? (double)requests/batches : 0;
+    if (latencies.empty())
+        return statistics;
+    std::vector<double> sorted = latencies;
+    std::nth_element(sorted.begin(), sorted.begin()+sorted.size()/2, sorted.end());
+    statistics.p50Latency = sorted[sorted.size()/2];
+    std::nth_element(sorted.begin(), sorted.begin()+sorted.size()*99/100, sorted.end());
+    statistics.p99Latency = sorted[sorted.size()*99/100];
+    return statistics;
+}
+
+void InferenceServer::resetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex);
+    latencies.clear();
+    nextLatency = requests = batches = 0;
+    started = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,120 @@
+
+#ifndef NEURALNETWORK_INFERENCESERVER_H
+#define NEURALNETWORK_INFERENCESERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Model.h"
+
+/**********************************************************
+ * Program	:  Inference Server
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Loads a model once and answers requests for it for as long as it runs. Requests from every client
+ *                  are queued together and a single thread takes them off the queue in micro batches, waiting until
+ *                  either the batch is full or the oldest request has used up its latency budget, and runs each batch
+ *                  through the model as one matrix-matrix product per layer. Clients talk to it over a unix socket
+ *                  or stdin and stdout with the same framing:
+ *
+ *                  the server first sends the number of inputs and outputs of the model as two uint32s, after that
+ *                  every request is a uint32 count followed by that many doubles and is answered in order by a frame
+ *                  of the outputs. A request with a count of zero asks for the statistics of the server instead,
+ *                  answered by a frame of the requests, batches, p50 and p99 latency in seconds, requests per
+ *                  second and average batch size
+ ***********************************************************/
+
+// how the server has done since it started or its statistics were last reset
+struct InferenceStatistics {
+    size_t requests, batches;
+    // the time from a request being queued to its outputs being ready in seconds, over the most recent requests
+    double p50Latency, p99Latency;
+    double requestsPerSecond, averageBatchSize;
+};
+// the number of values in the frame answering a request for the statistics
+constexpr uint32_t inferenceStatisticsSize = 6;
+
+class InferenceServer {
+public:
+    // a request waiting in the queue or being run
+    struct Request {
+        std::vector<double> inputs, outputs;
+        std::chrono::steady_clock::time_point queued;
+        bool answered = false;
+    };
+
+    // serve the model in batches of up to maxBatchSize requests, no request waits longer than latencyBudget seconds
+    // for others to join its batch. Wide layers of every batch are split between layerThreads threads, zero uses
+    // every core and one runs every batch on the batching thread alone
+    InferenceServer(std::shared_ptr<const Model> model, size_t maxBatchSize, double latencyBudget,
+                    size_t layerThreads = 1);
+    ~InferenceServer();
+    // the batching thread holds a pointer to the server so it cannot be copied
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // queue a request for the inputs of one sample without waiting for it
+    std::shared_ptr<Request> submit(const double* inputs);
+    // wait until a request has been answered
+    void wait(Request& request);
+    // run one sample through the model in whatever batch it lands in and wait for its outputs
+    void predict(const double* inputs, double* outputs);
+
+    // answer framed requests read from one descriptor on another until the input ends or a request does not match the
+    // model, requests are read ahead of the answers so one client can fill a batch by itself. Returns false if a
+    // request was malformed
+    bool serveStream(int input, int output);
+    // listen on a unix socket and serve every connection on a thread of its own until stop is called, returns false
+    // if the socket could not be opened
+    bool serveSocket(const std::string& path);
+    // stop serving the socket and close every connection to it
+    void stop();
+
+    InferenceStatistics getStatistics() const;
+    void resetStatistics();
+
+private:
+    // take batches off the queue and run them until the server is destroyed
+    void batchLoop();
+
+    std::shared_ptr<const Model> model;
+    size_t maxBatchSize;
+    std::chrono::duration<double> latencyBudget;
+    // the threads running the wide layers of every batch, null when the batching thread runs them alone
+    std::shared_ptr<WorkStealingPool> layerPool;
+
+    // the requests waiting for a batch and the thread running the batches
+    mutable std::mutex mutex;
+    std::condition_variable queueChanged, requestsAnswered;
+    std::deque<std::shared_ptr<Request>> queue;
+    std::thread batcher;
+    bool stopping = false;
+
+    // the listening socket and the connections to it, all closed by stop
+    std::mutex connectionsMutex;
+    std::condition_variable connectionClosed;
+    int listener = -1;
+    bool listening = false;
+    std::vector<int> connections;
+
+    // the latency of the most recent requests kept in a ring, and the totals since the statistics were reset
+    std::vector<double> latencies;
+    size_t nextLatency = 0, requests = 0, batches = 0;
+    std::chrono::steady_clock::time_point started;
+};
+
+// frames of doubles as the server sends and receives them, returns false if the descriptor closes part way or a
+// frame holds neither no values nor the expected number
+bool readFrame(int descriptor, std::vector<double>& values, uint32_t expected);
+bool writeFrame(int descriptor, const double* values, uint32_t count);
+// connect to a server's unix socket and read the size of its model, returns -1 if it could not connect
+int connectToServer(const std::string& path, uint32_t& numInputs, uint32_t& numOutputs);
+
+
+#endif //NEURALNETWORK_INFERENCESERVER_H
@@ -0,0 +1,1273 @@
+
+#include "Kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86
+#endif
+
+// past this magnitude tanh rounds to +-1 so inputs are clamped to it before taking the exponential
+static constexpr double tanhLimit = 20.0;
+
+/*
+ * Scalar kernels, the same loops the network used before being vectorized written for any pair of precisions
+ */
+
+template<typename Scalar, typename Accumulator>
+static Accumulator dotScalar(const Scalar* a, const Scalar* b, size_t count) {
+    Accumulator sum = 0.0;
+    for (size_t i = 0; i<count; i++)
+        sum += (Accumulator)a[i] * b[i];
+    return sum;
+}
+
+template<typename Scalar, typename Accumulator>
+static void axpyScalar(Accumulator scale, const Scalar* x, Accumulator* y, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        y[i] += x[i] * scale;
+}
+
+template<typename Scalar>
+static void tanhScalar(Scalar* values, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        values[i] = std::tanh(values[i]);
+}
+
+template<typename Scalar, typename Accumulator>
+static void tanhDerivativeScalar(const Scalar* outputs, Accumulator* gradients, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        gradients[i] *= 1-(Accumulator)outputs[i]*outputs[i];
+}
+
+template<typename Scalar>
+static void reluScalar(Scalar* values, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        values[i] = values[i]>0 ? values[i] : 0;
+}
+
+// the derivative is one where the output is positive and zero everywhere else
+template<typename Scalar, typename Accumulator>
+static void reluDerivativeScalar(const Scalar* outputs, Accumulator* gradients, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        gradients[i] = outputs[i]>0 ? gradients[i] : 0;
+}
+
+template<typename Scalar>
+static void leakyReluScalar(Scalar* values, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        values[i] = values[i]>0 ? values[i] : values[i]*(Scalar)leakyReluSlope;
+}
+
+template<typename Scalar, typename Accumulator>
+static void leakyReluDerivativeScalar(const Scalar* outputs, Accumulator* gradients, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        gradients[i] *= outputs[i]>0 ? 1 : (Accumulator)leakyReluSlope;
+}
+
+template<typename Scalar>
+static void sigmoidScalar(Scalar* values, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        values[i] = 1/(1+std::exp(-values[i]));
+}
+
+template<typename Scalar, typename Accumulator>
+static void sigmoidDerivativeScalar(const Scalar* outputs, Accumulator* gradients, size_t count) {
+    for (size_t i = 0; i<count; i++)
+        gradients[i] *= (Accumulator)outputs[i]*(1-(Accumulator)outputs[i]);
+}
+
+// a linear layer passes its sums straight through
+template<typename Scalar>
+static void linearScalar(Scalar*, size_t) {}
+
+// the gradients of linear and softmax layers are left as they are
+template<typename Scalar, typename Accumulator>
+static void identityDerivativeScalar(const Scalar*, Accumulator*, size_t) {}
+
+// softmax of all the values, the largest is taken off first so the exponentials cannot overflow
+template<typename Scalar>
+static void softmaxScalar(Scalar* values, size_t count) {
+    if (count == 0) return;
+    Scalar largest = *std::max_element(values, values+count), sum = 0;
+    for (size_t i = 0; i<count; i++){
+        values[i] = std::exp(values[i]-largest);
+        sum += values[i];
+    }
+    Scalar scale = 1/sum;
+    for (size_t i = 0; i<count; i++)
+        values[i] *= scale;
+}
+
+// the gradients are either accumulated sums or the stored values of a sample so they get a type of their own
+template<typename Scalar, typename Accumulator, typename Gradient>
+static void momentumUpdateScalar(Accumulator scale, const Gradient* gradients, Accumulator alpha, Scalar* deltas,
+                                 Scalar* weights, size_t count) {
+    for (size_t i = 0; i<count; i++){
+        Accumulator newDelta = (scale * gradients[i]) + (alpha * deltas[i]);
+        deltas[i] = newDelta;
+        weights[i] += newDelta;
+    }
+}
+
+// the optimizer steps read the gradients summed over a batch and write the weights and state of a whole layer in one
+// pass, decay is one unless there is weight decay
+template<typename Scalar, typename Accumulator>
+static void momentumStepScalar(const OptimizerStep<Accumulator>& step, const Accumulator* gradients, Scalar* moments,
+                               Scalar*, Scalar* weights, size_t count) {
+    for (size_t i = 0; i<count; i++){
+        Accumulator delta = (step.gradientScale * gradients[i]) + (step.momentum * moments[i]);
+        moments[i] = delta;
+        weights[i] = step.decay*weights[i] + delta;
+    }
+}
+
+// nesterov moves the weights by the change they are about to make rather than the one they just made
+template<typename Scalar, typename Accumulator>
+static void nesterovStepScalar(const OptimizerStep<Accumulator>& step, const Accumulator* gradients, Scalar* moments,
+                               Scalar*, Scalar* weights, size_t count) {
+    for (size_t i = 0; i<count; i++){
+        Accumulator gradient = step.gradientScale * gradients[i];
+        Accumulator delta = gradient + step.momentum * moments[i];
+        moments[i] = delta;
+        weights[i] = step.decay*weights[i] + (step.momentum*delta + gradient);
+    }
+}
+
+template<typename Scalar, typename Accumulator>
+static void adamStepScalar(const OptimizerStep<Accumulator>& step, const Accumulator* gradients, Scalar* moments,
+                           Scalar* squares, Scalar* weights, size_t count) {
+    for (size_t i = 0; i<count; i++){
+        Accumulator gradient = step.gradientScale * gradients[i];
+        Accumulator moment = step.beta1*moments[i] + (1-step.beta1)*gradient;
+        Accumulator square = step.beta2*squares[i] + (1-step.beta2)*(gradient*gradient);
+        moments[i] = moment;
+        squares[i] = square;
+        weights[i] = step.decay*weights[i] + step.learningRate*(moment/(std::sqrt(square)+step.epsilon));
+    }
+}
+
+template<typename Scalar, typename Accumulator>
+static void rmspropStepScalar(const OptimizerStep<Accumulator>& step, const Accumulator* gradients, Scalar*,
+                              Scalar* squares, Scalar* weights, size_t count) {
+    for (size_t i = 0; i<count; i++){
+        Accumulator gradient = step.gradientScale * gradients[i];
+        Accumulator square = step.beta2*squares[i] + (1-step.beta2)*(gradient*gradient);
+        squares[i] = square;
+        weights[i] = step.decay*weights[i] + step.learningRate*(gradient/(std::sqrt(square)+step.epsilon));
+    }
+}
+
+static int32_t dotInt8Scalar(const int8_t* a, const int8_t* b, size_t count) {
+    int32_t sum = 0;
+    for (size_t i = 0; i<count; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+static double dotSparseScalar(const double* values, const uint32_t* columns, const double* inputs, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i<count; i++)
+        sum += values[i] * inputs[columns[i]];
+    return sum;
+}
+
+#ifdef KERNELS_X86
+
+// coefficients 1/n! of the taylor series of e^r, accurate to double precision for |r| <= ln(2)/2
+static constexpr double expCoefficients[] = {
+        1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040, 1.0/40320, 1.0/362880, 1.0/3628800,
+        1.0/39916800, 1.0/479001600
+};
+static constexpr int expDegree = sizeof(expCoefficients)/sizeof(double)-1;
+// ln(2) split in two so k*ln(2) can be subtracted without losing precision
+static constexpr double ln2High = 6.93147180369123816490e-01, ln2Low = 1.90821492927058770002e-10;
+// adding this to a whole number below 2^51 leaves the number in the low bits of the double
+static constexpr double roundingMagic = 6755399441055744.0;
+
+// the same for floats, the taylor series only needs to reach float precision and tanh rounds to +-1 sooner
+static constexpr float expCoefficientsFloat[] = {
+        1.0f, 1.0f, 1.0f/2, 1.0f/6, 1.0f/24, 1.0f/120, 1.0f/720, 1.0f/5040
+};
+static constexpr int expDegreeFloat = sizeof(expCoefficientsFloat)/sizeof(float)-1;
+static constexpr float ln2HighFloat = 0.693359375f, ln2LowFloat = -2.12194440e-4f;
+static constexpr float tanhLimitFloat = 10.0f;
+
+/*
+ * AVX2 kernels
+ */
+
+__attribute__((target("avx2,fma")))
+static double dotAVX2(const double* a, const double* b, size_t count) {
+    // four independent sums so the additions can overlap
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i), sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i+4), _mm256_loadu_pd(b+i+4), sum1);
+        sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i+8), _mm256_loadu_pd(b+i+8), sum2);
+        sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i+12), _mm256_loadu_pd(b+i+12), sum3);
+    }
+    for (; i+4<=count; i += 4)
+        sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i), sum0);
+    __m256d sum = _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3));
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+    double total = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; i<count; i++)
+        total += a[i] * b[i];
+    return total;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpyAVX2(double scale, const double* x, double* y, size_t count) {
+    __m256d factor = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i+4<=count; i += 4)
+        _mm256_storeu_pd(y+i, _mm256_fmadd_pd(_mm256_loadu_pd(x+i), factor, _mm256_loadu_pd(y+i)));
+    for (; i<count; i++)
+        y[i] += x[i] * scale;
+}
+
+// tanh(x) = sign(x) * (1 - 2/(e^(2|x|)+1)) with e^y = 2^k * e^r where k = round(y/ln(2))
+__attribute__((target("avx2,fma")))
+static __m256d tanhVectorAVX2(__m256d x) {
+    __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d magnitude = _mm256_min_pd(_mm256_andnot_pd(signBit, x), _mm256_set1_pd(tanhLimit));
+    __m256d y = _mm256_add_pd(magnitude, magnitude);
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(y, _mm256_set1_pd(1.0/M_LN2)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(ln2High), y);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(ln2Low), r);
+    __m256d poly = _mm256_set1_pd(expCoefficients[expDegree]);
+    for (int term = expDegree-1; term>=0; term--)
+        poly = _mm256_fmadd_pd(poly, r, _mm256_set1_pd(expCoefficients[term]));
+    // build 2^k straight from the bits of the exponent
+    __m256i exponent = _mm256_castpd_si256(_mm256_add_pd(k, _mm256_set1_pd(roundingMagic)));
+    exponent = _mm256_slli_epi64(_mm256_add_epi64(exponent, _mm256_set1_epi64x(1023)), 52);
+    __m256d exp = _mm256_mul_pd(poly, _mm256_castsi256_pd(exponent));
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d result = _mm256_sub_pd(one, _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(exp, one)));
+    return _mm256_or_pd(result, _mm256_and_pd(signBit, x));
+}
+
+__attribute__((target("avx2,fma")))
+static void tanhAVX2(double* values, size_t count) {
+    size_t i = 0;
+    for (; i+4<=count; i += 4)
+        _mm256_storeu_pd(values+i, tanhVectorAVX2(_mm256_loadu_pd(values+i)));
+    for (; i<count; i++)
+        values[i] = std::tanh(values[i]);
+}
+
+// sigmoid(x) = (1 + tanh(x/2)) / 2 so it shares the vector tanh
+__attribute__((target("avx2,fma")))
+static void sigmoidAVX2(double* values, size_t count) {
+    __m256d half = _mm256_set1_pd(0.5);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d tanh = tanhVectorAVX2(_mm256_mul_pd(_mm256_loadu_pd(values+i), half));
+        _mm256_storeu_pd(values+i, _mm256_fmadd_pd(tanh, half, half));
+    }
+    sigmoidScalar(values+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void tanhDerivativeAVX2(const double* outputs, double* gradients, size_t count) {
+    __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d output = _mm256_loadu_pd(outputs+i);
+        __m256d derivative = _mm256_fnmadd_pd(output, output, one);
+        _mm256_storeu_pd(gradients+i, _mm256_mul_pd(_mm256_loadu_pd(gradients+i), derivative));
+    }
+    for (; i<count; i++)
+        gradients[i] *= 1-outputs[i]*outputs[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void momentumUpdateAVX2(double scale, const double* gradients, double alpha, double* deltas,
+                               double* weights, size_t count) {
+    __m256d scaleVector = _mm256_set1_pd(scale), alphaVector = _mm256_set1_pd(alpha);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d newDelta = _mm256_fmadd_pd(scaleVector, _mm256_loadu_pd(gradients+i),
+                                           _mm256_mul_pd(alphaVector, _mm256_loadu_pd(deltas+i)));
+        _mm256_storeu_pd(deltas+i, newDelta);
+        _mm256_storeu_pd(weights+i, _mm256_add_pd(_mm256_loadu_pd(weights+i), newDelta));
+    }
+    momentumUpdateScalar(scale, gradients+i, alpha, deltas+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void momentumStepAVX2(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                             double* squares, double* weights, size_t count) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale), momentum = _mm256_set1_pd(step.momentum);
+    __m256d decay = _mm256_set1_pd(step.decay);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d delta = _mm256_fmadd_pd(scale, _mm256_loadu_pd(gradients+i),
+                                        _mm256_mul_pd(momentum, _mm256_loadu_pd(moments+i)));
+        _mm256_storeu_pd(moments+i, delta);
+        _mm256_storeu_pd(weights+i, _mm256_fmadd_pd(decay, _mm256_loadu_pd(weights+i), delta));
+    }
+    momentumStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void nesterovStepAVX2(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                             double* squares, double* weights, size_t count) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale), momentum = _mm256_set1_pd(step.momentum);
+    __m256d decay = _mm256_set1_pd(step.decay);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d gradient = _mm256_mul_pd(scale, _mm256_loadu_pd(gradients+i));
+        __m256d delta = _mm256_fmadd_pd(momentum, _mm256_loadu_pd(moments+i), gradient);
+        _mm256_storeu_pd(moments+i, delta);
+        _mm256_storeu_pd(weights+i, _mm256_fmadd_pd(decay, _mm256_loadu_pd(weights+i),
+                                                    _mm256_fmadd_pd(momentum, delta, gradient)));
+    }
+    nesterovStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void adamStepAVX2(const OptimizerStep<double>& step, const double* gradients, double* moments, double* squares,
+                         double* weights, size_t count) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale), learningRate = _mm256_set1_pd(step.learningRate);
+    __m256d decay = _mm256_set1_pd(step.decay);
+    __m256d beta1 = _mm256_set1_pd(step.beta1), beta2 = _mm256_set1_pd(step.beta2);
+    __m256d epsilon = _mm256_set1_pd(step.epsilon);
+    __m256d oneMinusBeta1 = _mm256_set1_pd(1-step.beta1), oneMinusBeta2 = _mm256_set1_pd(1-step.beta2);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d gradient = _mm256_mul_pd(scale, _mm256_loadu_pd(gradients+i));
+        __m256d moment = _mm256_fmadd_pd(beta1, _mm256_loadu_pd(moments+i), _mm256_mul_pd(oneMinusBeta1, gradient));
+        __m256d square = _mm256_fmadd_pd(beta2, _mm256_loadu_pd(squares+i),
+                                         _mm256_mul_pd(oneMinusBeta2, _mm256_mul_pd(gradient, gradient)));
+        _mm256_storeu_pd(moments+i, moment);
+        _mm256_storeu_pd(squares+i, square);
+        __m256d change = _mm256_mul_pd(learningRate,
+                                       _mm256_div_pd(moment, _mm256_add_pd(_mm256_sqrt_pd(square), epsilon)));
+        _mm256_storeu_pd(weights+i, _mm256_fmadd_pd(decay, _mm256_loadu_pd(weights+i), change));
+    }
+    adamStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void rmspropStepAVX2(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                            double* squares, double* weights, size_t count) {
+    __m256d scale = _mm256_set1_pd(step.gradientScale), learningRate = _mm256_set1_pd(step.learningRate);
+    __m256d decay = _mm256_set1_pd(step.decay);
+    __m256d beta2 = _mm256_set1_pd(step.beta2), oneMinusBeta2 = _mm256_set1_pd(1-step.beta2);
+    __m256d epsilon = _mm256_set1_pd(step.epsilon);
+    size_t i = 0;
+    for (; i+4<=count; i += 4){
+        __m256d gradient = _mm256_mul_pd(scale, _mm256_loadu_pd(gradients+i));
+        __m256d square = _mm256_fmadd_pd(beta2, _mm256_loadu_pd(squares+i),
+                                         _mm256_mul_pd(oneMinusBeta2, _mm256_mul_pd(gradient, gradient)));
+        _mm256_storeu_pd(squares+i, square);
+        __m256d change = _mm256_mul_pd(learningRate,
+                                       _mm256_div_pd(gradient, _mm256_add_pd(_mm256_sqrt_pd(square), epsilon)));
+        _mm256_storeu_pd(weights+i, _mm256_fmadd_pd(decay, _mm256_loadu_pd(weights+i), change));
+    }
+    rmspropStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+/*
+ * AVX2 float kernels and the float kernels summing into doubles
+ */
+
+__attribute__((target("avx2,fma")))
+static float dotFloatAVX2(const float* a, const float* b, size_t count) {
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps(), sum3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i+32<=count; i += 32){
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+8), _mm256_loadu_ps(b+i+8), sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+16), _mm256_loadu_ps(b+i+16), sum2);
+        sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i+24), _mm256_loadu_ps(b+i+24), sum3);
+    }
+    for (; i+8<=count; i += 8)
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i), sum0);
+    __m256 sum = _mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3));
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    float total = _mm_cvtss_f32(_mm_add_ss(half, _mm_movehdup_ps(half)));
+    for (; i<count; i++)
+        total += a[i] * b[i];
+    return total;
+}
+
+// the floats are widened to doubles before they are multiplied so the sum is as exact as the double kernel's
+__attribute__((target("avx2,fma")))
+static double dotMixedAVX2(const float* a, const float* b, size_t count) {
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        sum0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a+i)), _mm256_cvtps_pd(_mm_loadu_ps(b+i)), sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a+i+4)), _mm256_cvtps_pd(_mm_loadu_ps(b+i+4)), sum1);
+        sum2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a+i+8)), _mm256_cvtps_pd(_mm_loadu_ps(b+i+8)), sum2);
+        sum3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a+i+12)), _mm256_cvtps_pd(_mm_loadu_ps(b+i+12)), sum3);
+    }
+    for (; i+4<=count; i += 4)
+        sum0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a+i)), _mm256_cvtps_pd(_mm_loadu_ps(b+i)), sum0);
+    __m256d sum = _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3));
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+    double total = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; i<count; i++)
+        total += (double)a[i] * b[i];
+    return total;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpyFloatAVX2(float scale, const float* x, float* y, size_t count) {
+    __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i+8<=count; i += 8)
+        _mm256_storeu_ps(y+i, _mm256_fmadd_ps(_mm256_loadu_ps(x+i), factor, _mm256_loadu_ps(y+i)));
+    for (; i<count; i++)
+        y[i] += x[i] * scale;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpyMixedAVX2(double scale, const float* x, double* y, size_t count) {
+    __m256d factor = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i+4<=count; i += 4)
+        _mm256_storeu_pd(y+i, _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x+i)), factor, _mm256_loadu_pd(y+i)));
+    for (; i<count; i++)
+        y[i] += x[i] * scale;
+}
+
+// the float version of tanhVectorAVX2 with a shorter series
+__attribute__((target("avx2,fma")))
+static __m256 tanhVectorFloatAVX2(__m256 x) {
+    __m256 signBit = _mm256_set1_ps(-0.0f);
+    __m256 magnitude = _mm256_min_ps(_mm256_andnot_ps(signBit, x), _mm256_set1_ps(tanhLimitFloat));
+    __m256 y = _mm256_add_ps(magnitude, magnitude);
+    __m256 k = _mm256_round_ps(_mm256_mul_ps(y, _mm256_set1_ps((float)(1.0/M_LN2))),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(ln2HighFloat), y);
+    r = _mm256_fnmadd_ps(k, _mm256_set1_ps(ln2LowFloat), r);
+    __m256 poly = _mm256_set1_ps(expCoefficientsFloat[expDegreeFloat]);
+    for (int term = expDegreeFloat-1; term>=0; term--)
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(expCoefficientsFloat[term]));
+    __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+    __m256 exp = _mm256_mul_ps(poly, _mm256_castsi256_ps(exponent));
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 result = _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(exp, one)));
+    return _mm256_or_ps(result, _mm256_and_ps(signBit, x));
+}
+
+__attribute__((target("avx2,fma")))
+static void tanhFloatAVX2(float* values, size_t count) {
+    size_t i = 0;
+    for (; i+8<=count; i += 8)
+        _mm256_storeu_ps(values+i, tanhVectorFloatAVX2(_mm256_loadu_ps(values+i)));
+    for (; i<count; i++)
+        values[i] = std::tanh(values[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void sigmoidFloatAVX2(float* values, size_t count) {
+    __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 tanh = tanhVectorFloatAVX2(_mm256_mul_ps(_mm256_loadu_ps(values+i), half));
+        _mm256_storeu_ps(values+i, _mm256_fmadd_ps(tanh, half, half));
+    }
+    sigmoidScalar(values+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void tanhDerivativeFloatAVX2(const float* outputs, float* gradients, size_t count) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 output = _mm256_loadu_ps(outputs+i);
+        __m256 derivative = _mm256_fnmadd_ps(output, output, one);
+        _mm256_storeu_ps(gradients+i, _mm256_mul_ps(_mm256_loadu_ps(gradients+i), derivative));
+    }
+    for (; i<count; i++)
+        gradients[i] *= 1-outputs[i]*outputs[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void momentumUpdateFloatAVX2(float scale, const float* gradients, float alpha, float* deltas,
+                                    float* weights, size_t count) {
+    __m256 scaleVector = _mm256_set1_ps(scale), alphaVector = _mm256_set1_ps(alpha);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 newDelta = _mm256_fmadd_ps(scaleVector, _mm256_loadu_ps(gradients+i),
+                                          _mm256_mul_ps(alphaVector, _mm256_loadu_ps(deltas+i)));
+        _mm256_storeu_ps(deltas+i, newDelta);
+        _mm256_storeu_ps(weights+i, _mm256_add_ps(_mm256_loadu_ps(weights+i), newDelta));
+    }
+    momentumUpdateScalar(scale, gradients+i, alpha, deltas+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void momentumStepFloatAVX2(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                  float* squares, float* weights, size_t count) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale), momentum = _mm256_set1_ps(step.momentum);
+    __m256 decay = _mm256_set1_ps(step.decay);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 delta = _mm256_fmadd_ps(scale, _mm256_loadu_ps(gradients+i),
+                                       _mm256_mul_ps(momentum, _mm256_loadu_ps(moments+i)));
+        _mm256_storeu_ps(moments+i, delta);
+        _mm256_storeu_ps(weights+i, _mm256_fmadd_ps(decay, _mm256_loadu_ps(weights+i), delta));
+    }
+    momentumStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void nesterovStepFloatAVX2(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                  float* squares, float* weights, size_t count) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale), momentum = _mm256_set1_ps(step.momentum);
+    __m256 decay = _mm256_set1_ps(step.decay);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 gradient = _mm256_mul_ps(scale, _mm256_loadu_ps(gradients+i));
+        __m256 delta = _mm256_fmadd_ps(momentum, _mm256_loadu_ps(moments+i), gradient);
+        _mm256_storeu_ps(moments+i, delta);
+        _mm256_storeu_ps(weights+i, _mm256_fmadd_ps(decay, _mm256_loadu_ps(weights+i),
+                                                    _mm256_fmadd_ps(momentum, delta, gradient)));
+    }
+    nesterovStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void adamStepFloatAVX2(const OptimizerStep<float>& step, const float* gradients, float* moments, float* squares,
+                              float* weights, size_t count) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale), learningRate = _mm256_set1_ps(step.learningRate);
+    __m256 decay = _mm256_set1_ps(step.decay);
+    __m256 beta1 = _mm256_set1_ps(step.beta1), beta2 = _mm256_set1_ps(step.beta2);
+    __m256 epsilon = _mm256_set1_ps(step.epsilon);
+    __m256 oneMinusBeta1 = _mm256_set1_ps(1-step.beta1), oneMinusBeta2 = _mm256_set1_ps(1-step.beta2);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 gradient = _mm256_mul_ps(scale, _mm256_loadu_ps(gradients+i));
+        __m256 moment = _mm256_fmadd_ps(beta1, _mm256_loadu_ps(moments+i), _mm256_mul_ps(oneMinusBeta1, gradient));
+        __m256 square = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(squares+i),
+                                        _mm256_mul_ps(oneMinusBeta2, _mm256_mul_ps(gradient, gradient)));
+        _mm256_storeu_ps(moments+i, moment);
+        _mm256_storeu_ps(squares+i, square);
+        __m256 change = _mm256_mul_ps(learningRate,
+                                      _mm256_div_ps(moment, _mm256_add_ps(_mm256_sqrt_ps(square), epsilon)));
+        _mm256_storeu_ps(weights+i, _mm256_fmadd_ps(decay, _mm256_loadu_ps(weights+i), change));
+    }
+    adamStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx2,fma")))
+static void rmspropStepFloatAVX2(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                 float* squares, float* weights, size_t count) {
+    __m256 scale = _mm256_set1_ps(step.gradientScale), learningRate = _mm256_set1_ps(step.learningRate);
+    __m256 decay = _mm256_set1_ps(step.decay);
+    __m256 beta2 = _mm256_set1_ps(step.beta2), oneMinusBeta2 = _mm256_set1_ps(1-step.beta2);
+    __m256 epsilon = _mm256_set1_ps(step.epsilon);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256 gradient = _mm256_mul_ps(scale, _mm256_loadu_ps(gradients+i));
+        __m256 square = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(squares+i),
+                                        _mm256_mul_ps(oneMinusBeta2, _mm256_mul_ps(gradient, gradient)));
+        _mm256_storeu_ps(squares+i, square);
+        __m256 change = _mm256_mul_ps(learningRate,
+                                      _mm256_div_ps(gradient, _mm256_add_ps(_mm256_sqrt_ps(square), epsilon)));
+        _mm256_storeu_ps(weights+i, _mm256_fmadd_ps(decay, _mm256_loadu_ps(weights+i), change));
+    }
+    rmspropStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+/*
+ * AVX2 int8 kernels
+ */
+
+// the bytes are widened to 16 bits and multiplied in pairs which are added into 32 bit sums, a pair of products is
+// at most 2*127*128 so nothing can overflow before the sums are widened
+__attribute__((target("avx2")))
+static int32_t dotInt8AVX2(const int8_t* a, const int8_t* b, size_t count) {
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i+32<=count; i += 32){
+        __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a+i)));
+        __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b+i)));
+        __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a+i+16)));
+        __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b+i+16)));
+        sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(a0, b0));
+        sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(a1, b1));
+    }
+    for (; i+16<=count; i += 16){
+        __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a+i)));
+        __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b+i)));
+        sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(a0, b0));
+    }
+    __m256i sum = _mm256_add_epi32(sum0, sum1);
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    int32_t total = _mm_cvtsi128_si32(half);
+    for (; i<count; i++)
+        total += a[i] * b[i];
+    return total;
+}
+
+/*
+ * AVX2 sparse kernels
+ */
+
+// the inputs of four weights are gathered by their columns at once, two sums hide the latency of the gathers
+__attribute__((target("avx2,fma")))
+static double dotSparseAVX2(const double* values, const uint32_t* columns, const double* inputs, size_t count) {
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m256d x0 = _mm256_i32gather_pd(inputs, _mm_loadu_si128((const __m128i*)(columns+i)), 8);
+        __m256d x1 = _mm256_i32gather_pd(inputs, _mm_loadu_si128((const __m128i*)(columns+i+4)), 8);
+        sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(values+i), x0, sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(values+i+4), x1, sum1);
+    }
+    for (; i+4<=count; i += 4){
+        __m256d x0 = _mm256_i32gather_pd(inputs, _mm_loadu_si128((const __m128i*)(columns+i)), 8);
+        sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(values+i), x0, sum0);
+    }
+    __m256d sum = _mm256_add_pd(sum0, sum1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+    double total = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; i<count; i++)
+        total += values[i] * inputs[columns[i]];
+    return total;
+}
+
+/*
+ * AVX-512 kernels
+ */
+
+__attribute__((target("avx512f")))
+static double dotAVX512(const double* a, const double* b, size_t count) {
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d sum2 = _mm512_setzero_pd(), sum3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i+32<=count; i += 32){
+        sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i), sum0);
+        sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i+8), _mm512_loadu_pd(b+i+8), sum1);
+        sum2 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i+16), _mm512_loadu_pd(b+i+16), sum2);
+        sum3 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i+24), _mm512_loadu_pd(b+i+24), sum3);
+    }
+    for (; i+8<=count; i += 8)
+        sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i), sum0);
+    // the remainder is loaded through a mask so short rows like the ones of tiny networks stay vectorized
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        sum1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a+i), _mm512_maskz_loadu_pd(mask, b+i), sum1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+}
+
+__attribute__((target("avx512f")))
+static void axpyAVX512(double scale, const double* x, double* y, size_t count) {
+    __m512d factor = _mm512_set1_pd(scale);
+    size_t i = 0;
+    for (; i+8<=count; i += 8)
+        _mm512_storeu_pd(y+i, _mm512_fmadd_pd(_mm512_loadu_pd(x+i), factor, _mm512_loadu_pd(y+i)));
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        __m512d result = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x+i), factor, _mm512_maskz_loadu_pd(mask, y+i));
+        _mm512_mask_storeu_pd(y+i, mask, result);
+    }
+}
+
+__attribute__((target("avx512f")))
+static __m512d tanhVectorAVX512(__m512d x) {
+    __m512i signBit = _mm512_set1_epi64((long long)0x8000000000000000ULL);
+    __m512i bits = _mm512_castpd_si512(x);
+    __m512d magnitude = _mm512_min_pd(_mm512_castsi512_pd(_mm512_andnot_si512(signBit, bits)),
+                                      _mm512_set1_pd(tanhLimit));
+    __m512d y = _mm512_add_pd(magnitude, magnitude);
+    __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(y, _mm512_set1_pd(1.0/M_LN2)), _MM_FROUND_TO_NEAREST_INT);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(ln2High), y);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(ln2Low), r);
+    __m512d poly = _mm512_set1_pd(expCoefficients[expDegree]);
+    for (int term = expDegree-1; term>=0; term--)
+        poly = _mm512_fmadd_pd(poly, r, _mm512_set1_pd(expCoefficients[term]));
+    __m512i exponent = _mm512_castpd_si512(_mm512_add_pd(k, _mm512_set1_pd(roundingMagic)));
+    exponent = _mm512_slli_epi64(_mm512_add_epi64(exponent, _mm512_set1_epi64(1023)), 52);
+    __m512d exp = _mm512_mul_pd(poly, _mm512_castsi512_pd(exponent));
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d result = _mm512_sub_pd(one, _mm512_div_pd(_mm512_set1_pd(2.0), _mm512_add_pd(exp, one)));
+    return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(result), _mm512_and_si512(signBit, bits)));
+}
+
+__attribute__((target("avx512f")))
+static void tanhAVX512(double* values, size_t count) {
+    size_t i = 0;
+    for (; i+8<=count; i += 8)
+        _mm512_storeu_pd(values+i, tanhVectorAVX512(_mm512_loadu_pd(values+i)));
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        _mm512_mask_storeu_pd(values+i, mask, tanhVectorAVX512(_mm512_maskz_loadu_pd(mask, values+i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void sigmoidAVX512(double* values, size_t count) {
+    __m512d half = _mm512_set1_pd(0.5);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d tanh = tanhVectorAVX512(_mm512_mul_pd(_mm512_loadu_pd(values+i), half));
+        _mm512_storeu_pd(values+i, _mm512_fmadd_pd(tanh, half, half));
+    }
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        __m512d tanh = tanhVectorAVX512(_mm512_mul_pd(_mm512_maskz_loadu_pd(mask, values+i), half));
+        _mm512_mask_storeu_pd(values+i, mask, _mm512_fmadd_pd(tanh, half, half));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void tanhDerivativeAVX512(const double* outputs, double* gradients, size_t count) {
+    __m512d one = _mm512_set1_pd(1.0);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d output = _mm512_loadu_pd(outputs+i);
+        __m512d derivative = _mm512_fnmadd_pd(output, output, one);
+        _mm512_storeu_pd(gradients+i, _mm512_mul_pd(_mm512_loadu_pd(gradients+i), derivative));
+    }
+    for (; i<count; i++)
+        gradients[i] *= 1-outputs[i]*outputs[i];
+}
+
+__attribute__((target("avx512f")))
+static void momentumUpdateAVX512(double scale, const double* gradients, double alpha, double* deltas,
+                                 double* weights, size_t count) {
+    __m512d scaleVector = _mm512_set1_pd(scale), alphaVector = _mm512_set1_pd(alpha);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d newDelta = _mm512_fmadd_pd(scaleVector, _mm512_loadu_pd(gradients+i),
+                                           _mm512_mul_pd(alphaVector, _mm512_loadu_pd(deltas+i)));
+        _mm512_storeu_pd(deltas+i, newDelta);
+        _mm512_storeu_pd(weights+i, _mm512_add_pd(_mm512_loadu_pd(weights+i), newDelta));
+    }
+    momentumUpdateScalar(scale, gradients+i, alpha, deltas+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void momentumStepAVX512(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                               double* squares, double* weights, size_t count) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale), momentum = _mm512_set1_pd(step.momentum);
+    __m512d decay = _mm512_set1_pd(step.decay);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d delta = _mm512_fmadd_pd(scale, _mm512_loadu_pd(gradients+i),
+                                        _mm512_mul_pd(momentum, _mm512_loadu_pd(moments+i)));
+        _mm512_storeu_pd(moments+i, delta);
+        _mm512_storeu_pd(weights+i, _mm512_fmadd_pd(decay, _mm512_loadu_pd(weights+i), delta));
+    }
+    momentumStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void nesterovStepAVX512(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                               double* squares, double* weights, size_t count) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale), momentum = _mm512_set1_pd(step.momentum);
+    __m512d decay = _mm512_set1_pd(step.decay);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d gradient = _mm512_mul_pd(scale, _mm512_loadu_pd(gradients+i));
+        __m512d delta = _mm512_fmadd_pd(momentum, _mm512_loadu_pd(moments+i), gradient);
+        _mm512_storeu_pd(moments+i, delta);
+        _mm512_storeu_pd(weights+i, _mm512_fmadd_pd(decay, _mm512_loadu_pd(weights+i),
+                                                    _mm512_fmadd_pd(momentum, delta, gradient)));
+    }
+    nesterovStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void adamStepAVX512(const OptimizerStep<double>& step, const double* gradients, double* moments, double* squares,
+                           double* weights, size_t count) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale), learningRate = _mm512_set1_pd(step.learningRate);
+    __m512d decay = _mm512_set1_pd(step.decay);
+    __m512d beta1 = _mm512_set1_pd(step.beta1), beta2 = _mm512_set1_pd(step.beta2);
+    __m512d epsilon = _mm512_set1_pd(step.epsilon);
+    __m512d oneMinusBeta1 = _mm512_set1_pd(1-step.beta1), oneMinusBeta2 = _mm512_set1_pd(1-step.beta2);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d gradient = _mm512_mul_pd(scale, _mm512_loadu_pd(gradients+i));
+        __m512d moment = _mm512_fmadd_pd(beta1, _mm512_loadu_pd(moments+i), _mm512_mul_pd(oneMinusBeta1, gradient));
+        __m512d square = _mm512_fmadd_pd(beta2, _mm512_loadu_pd(squares+i),
+                                         _mm512_mul_pd(oneMinusBeta2, _mm512_mul_pd(gradient, gradient)));
+        _mm512_storeu_pd(moments+i, moment);
+        _mm512_storeu_pd(squares+i, square);
+        __m512d change = _mm512_mul_pd(learningRate,
+                                       _mm512_div_pd(moment, _mm512_add_pd(_mm512_sqrt_pd(square), epsilon)));
+        _mm512_storeu_pd(weights+i, _mm512_fmadd_pd(decay, _mm512_loadu_pd(weights+i), change));
+    }
+    adamStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void rmspropStepAVX512(const OptimizerStep<double>& step, const double* gradients, double* moments,
+                              double* squares, double* weights, size_t count) {
+    __m512d scale = _mm512_set1_pd(step.gradientScale), learningRate = _mm512_set1_pd(step.learningRate);
+    __m512d decay = _mm512_set1_pd(step.decay);
+    __m512d beta2 = _mm512_set1_pd(step.beta2), oneMinusBeta2 = _mm512_set1_pd(1-step.beta2);
+    __m512d epsilon = _mm512_set1_pd(step.epsilon);
+    size_t i = 0;
+    for (; i+8<=count; i += 8){
+        __m512d gradient = _mm512_mul_pd(scale, _mm512_loadu_pd(gradients+i));
+        __m512d square = _mm512_fmadd_pd(beta2, _mm512_loadu_pd(squares+i),
+                                         _mm512_mul_pd(oneMinusBeta2, _mm512_mul_pd(gradient, gradient)));
+        _mm512_storeu_pd(squares+i, square);
+        __m512d change = _mm512_mul_pd(learningRate,
+                                       _mm512_div_pd(gradient, _mm512_add_pd(_mm512_sqrt_pd(square), epsilon)));
+        _mm512_storeu_pd(weights+i, _mm512_fmadd_pd(decay, _mm512_loadu_pd(weights+i), change));
+    }
+    rmspropStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+/*
+ * AVX-512 float kernels and the float kernels summing into doubles
+ */
+
+__attribute__((target("avx512f")))
+static float dotFloatAVX512(const float* a, const float* b, size_t count) {
+    __m512 sum0 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps();
+    __m512 sum2 = _mm512_setzero_ps(), sum3 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i+64<=count; i += 64){
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a+i), _mm512_loadu_ps(b+i), sum0);
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(a+i+16), _mm512_loadu_ps(b+i+16), sum1);
+        sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(a+i+32), _mm512_loadu_ps(b+i+32), sum2);
+        sum3 = _mm512_fmadd_ps(_mm512_loadu_ps(a+i+48), _mm512_loadu_ps(b+i+48), sum3);
+    }
+    for (; i+16<=count; i += 16)
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a+i), _mm512_loadu_ps(b+i), sum0);
+    if (i<count){
+        __mmask16 mask = (__mmask16)((1u<<(count-i))-1);
+        sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a+i), _mm512_maskz_loadu_ps(mask, b+i), sum1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(sum0, sum1), _mm512_add_ps(sum2, sum3)));
+}
+
+__attribute__((target("avx512f")))
+static double dotMixedAVX512(const float* a, const float* b, size_t count) {
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d sum2 = _mm512_setzero_pd(), sum3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i+32<=count; i += 32){
+        sum0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a+i)), _mm512_cvtps_pd(_mm256_loadu_ps(b+i)), sum0);
+        sum1 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a+i+8)), _mm512_cvtps_pd(_mm256_loadu_ps(b+i+8)),
+                               sum1);
+        sum2 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a+i+16)), _mm512_cvtps_pd(_mm256_loadu_ps(b+i+16)),
+                               sum2);
+        sum3 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a+i+24)), _mm512_cvtps_pd(_mm256_loadu_ps(b+i+24)),
+                               sum3);
+    }
+    for (; i+8<=count; i += 8)
+        sum0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(a+i)), _mm512_cvtps_pd(_mm256_loadu_ps(b+i)), sum0);
+    // the remainder is loaded through a mask of a full register and its lower half widened
+    if (i<count){
+        __mmask16 mask = (__mmask16)((1u<<(count-i))-1);
+        __m256 x = _mm512_castps512_ps256(_mm512_maskz_loadu_ps(mask, a+i));
+        __m256 w = _mm512_castps512_ps256(_mm512_maskz_loadu_ps(mask, b+i));
+        sum1 = _mm512_fmadd_pd(_mm512_cvtps_pd(x), _mm512_cvtps_pd(w), sum1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3)));
+}
+
+__attribute__((target("avx512f")))
+static void axpyFloatAVX512(float scale, const float* x, float* y, size_t count) {
+    __m512 factor = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i+16<=count; i += 16)
+        _mm512_storeu_ps(y+i, _mm512_fmadd_ps(_mm512_loadu_ps(x+i), factor, _mm512_loadu_ps(y+i)));
+    if (i<count){
+        __mmask16 mask = (__mmask16)((1u<<(count-i))-1);
+        __m512 result = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x+i), factor, _mm512_maskz_loadu_ps(mask, y+i));
+        _mm512_mask_storeu_ps(y+i, mask, result);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void axpyMixedAVX512(double scale, const float* x, double* y, size_t count) {
+    __m512d factor = _mm512_set1_pd(scale);
+    size_t i = 0;
+    for (; i+8<=count; i += 8)
+        _mm512_storeu_pd(y+i, _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x+i)), factor, _mm512_loadu_pd(y+i)));
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        __m256 values = _mm512_castps512_ps256(_mm512_maskz_loadu_ps((__mmask16)mask, x+i));
+        __m512d result = _mm512_fmadd_pd(_mm512_cvtps_pd(values), factor, _mm512_maskz_loadu_pd(mask, y+i));
+        _mm512_mask_storeu_pd(y+i, mask, result);
+    }
+}
+
+__attribute__((target("avx512f")))
+static __m512 tanhVectorFloatAVX512(__m512 x) {
+    __m512i signBit = _mm512_set1_epi32((int)0x80000000u);
+    __m512i bits = _mm512_castps_si512(x);
+    __m512 magnitude = _mm512_min_ps(_mm512_castsi512_ps(_mm512_andnot_si512(signBit, bits)),
+                                     _mm512_set1_ps(tanhLimitFloat));
+    __m512 y = _mm512_add_ps(magnitude, magnitude);
+    __m512 k = _mm512_roundscale_ps(_mm512_mul_ps(y, _mm512_set1_ps((float)(1.0/M_LN2))), _MM_FROUND_TO_NEAREST_INT);
+    __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(ln2HighFloat), y);
+    r = _mm512_fnmadd_ps(k, _mm512_set1_ps(ln2LowFloat), r);
+    __m512 poly = _mm512_set1_ps(expCoefficientsFloat[expDegreeFloat]);
+    for (int term = expDegreeFloat-1; term>=0; term--)
+        poly = _mm512_fmadd_ps(poly, r, _mm512_set1_ps(expCoefficientsFloat[term]));
+    __m512i exponent = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(k), _mm512_set1_epi32(127)), 23);
+    __m512 exp = _mm512_mul_ps(poly, _mm512_castsi512_ps(exponent));
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 result = _mm512_sub_ps(one, _mm512_div_ps(_mm512_set1_ps(2.0f), _mm512_add_ps(exp, one)));
+    return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(result), _mm512_and_si512(signBit, bits)));
+}
+
+__attribute__((target("avx512f")))
+static void tanhFloatAVX512(float* values, size_t count) {
+    size_t i = 0;
+    for (; i+16<=count; i += 16)
+        _mm512_storeu_ps(values+i, tanhVectorFloatAVX512(_mm512_loadu_ps(values+i)));
+    if (i<count){
+        __mmask16 mask = (__mmask16)((1u<<(count-i))-1);
+        _mm512_mask_storeu_ps(values+i, mask, tanhVectorFloatAVX512(_mm512_maskz_loadu_ps(mask, values+i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void sigmoidFloatAVX512(float* values, size_t count) {
+    __m512 half = _mm512_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 tanh = tanhVectorFloatAVX512(_mm512_mul_ps(_mm512_loadu_ps(values+i), half));
+        _mm512_storeu_ps(values+i, _mm512_fmadd_ps(tanh, half, half));
+    }
+    if (i<count){
+        __mmask16 mask = (__mmask16)((1u<<(count-i))-1);
+        __m512 tanh = tanhVectorFloatAVX512(_mm512_mul_ps(_mm512_maskz_loadu_ps(mask, values+i), half));
+        _mm512_mask_storeu_ps(values+i, mask, _mm512_fmadd_ps(tanh, half, half));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void tanhDerivativeFloatAVX512(const float* outputs, float* gradients, size_t count) {
+    __m512 one = _mm512_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 output = _mm512_loadu_ps(outputs+i);
+        __m512 derivative = _mm512_fnmadd_ps(output, output, one);
+        _mm512_storeu_ps(gradients+i, _mm512_mul_ps(_mm512_loadu_ps(gradients+i), derivative));
+    }
+    for (; i<count; i++)
+        gradients[i] *= 1-outputs[i]*outputs[i];
+}
+
+__attribute__((target("avx512f")))
+static void momentumUpdateFloatAVX512(float scale, const float* gradients, float alpha, float* deltas,
+                                      float* weights, size_t count) {
+    __m512 scaleVector = _mm512_set1_ps(scale), alphaVector = _mm512_set1_ps(alpha);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 newDelta = _mm512_fmadd_ps(scaleVector, _mm512_loadu_ps(gradients+i),
+                                          _mm512_mul_ps(alphaVector, _mm512_loadu_ps(deltas+i)));
+        _mm512_storeu_ps(deltas+i, newDelta);
+        _mm512_storeu_ps(weights+i, _mm512_add_ps(_mm512_loadu_ps(weights+i), newDelta));
+    }
+    momentumUpdateScalar(scale, gradients+i, alpha, deltas+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void momentumStepFloatAVX512(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                    float* squares, float* weights, size_t count) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale), momentum = _mm512_set1_ps(step.momentum);
+    __m512 decay = _mm512_set1_ps(step.decay);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 delta = _mm512_fmadd_ps(scale, _mm512_loadu_ps(gradients+i),
+                                       _mm512_mul_ps(momentum, _mm512_loadu_ps(moments+i)));
+        _mm512_storeu_ps(moments+i, delta);
+        _mm512_storeu_ps(weights+i, _mm512_fmadd_ps(decay, _mm512_loadu_ps(weights+i), delta));
+    }
+    momentumStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void nesterovStepFloatAVX512(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                    float* squares, float* weights, size_t count) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale), momentum = _mm512_set1_ps(step.momentum);
+    __m512 decay = _mm512_set1_ps(step.decay);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 gradient = _mm512_mul_ps(scale, _mm512_loadu_ps(gradients+i));
+        __m512 delta = _mm512_fmadd_ps(momentum, _mm512_loadu_ps(moments+i), gradient);
+        _mm512_storeu_ps(moments+i, delta);
+        _mm512_storeu_ps(weights+i, _mm512_fmadd_ps(decay, _mm512_loadu_ps(weights+i),
+                                                    _mm512_fmadd_ps(momentum, delta, gradient)));
+    }
+    nesterovStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void adamStepFloatAVX512(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                float* squares, float* weights, size_t count) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale), learningRate = _mm512_set1_ps(step.learningRate);
+    __m512 decay = _mm512_set1_ps(step.decay);
+    __m512 beta1 = _mm512_set1_ps(step.beta1), beta2 = _mm512_set1_ps(step.beta2);
+    __m512 epsilon = _mm512_set1_ps(step.epsilon);
+    __m512 oneMinusBeta1 = _mm512_set1_ps(1-step.beta1), oneMinusBeta2 = _mm512_set1_ps(1-step.beta2);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 gradient = _mm512_mul_ps(scale, _mm512_loadu_ps(gradients+i));
+        __m512 moment = _mm512_fmadd_ps(beta1, _mm512_loadu_ps(moments+i), _mm512_mul_ps(oneMinusBeta1, gradient));
+        __m512 square = _mm512_fmadd_ps(beta2, _mm512_loadu_ps(squares+i),
+                                        _mm512_mul_ps(oneMinusBeta2, _mm512_mul_ps(gradient, gradient)));
+        _mm512_storeu_ps(moments+i, moment);
+        _mm512_storeu_ps(squares+i, square);
+        __m512 change = _mm512_mul_ps(learningRate,
+                                      _mm512_div_ps(moment, _mm512_add_ps(_mm512_sqrt_ps(square), epsilon)));
+        _mm512_storeu_ps(weights+i, _mm512_fmadd_ps(decay, _mm512_loadu_ps(weights+i), change));
+    }
+    adamStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+__attribute__((target("avx512f")))
+static void rmspropStepFloatAVX512(const OptimizerStep<float>& step, const float* gradients, float* moments,
+                                   float* squares, float* weights, size_t count) {
+    __m512 scale = _mm512_set1_ps(step.gradientScale), learningRate = _mm512_set1_ps(step.learningRate);
+    __m512 decay = _mm512_set1_ps(step.decay);
+    __m512 beta2 = _mm512_set1_ps(step.beta2), oneMinusBeta2 = _mm512_set1_ps(1-step.beta2);
+    __m512 epsilon = _mm512_set1_ps(step.epsilon);
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512 gradient = _mm512_mul_ps(scale, _mm512_loadu_ps(gradients+i));
+        __m512 square = _mm512_fmadd_ps(beta2, _mm512_loadu_ps(squares+i),
+                                        _mm512_mul_ps(oneMinusBeta2, _mm512_mul_ps(gradient, gradient)));
+        _mm512_storeu_ps(squares+i, square);
+        __m512 change = _mm512_mul_ps(learningRate,
+                                      _mm512_div_ps(gradient, _mm512_add_ps(_mm512_sqrt_ps(square), epsilon)));
+        _mm512_storeu_ps(weights+i, _mm512_fmadd_ps(decay, _mm512_loadu_ps(weights+i), change));
+    }
+    rmspropStepScalar(step, gradients+i, moments+i, squares+i, weights+i, count-i);
+}
+
+/*
+ * AVX-512 int8 kernels, these need the byte and word instructions of AVX-512BW on top of AVX-512F
+ */
+
+__attribute__((target("avx512f,avx512bw")))
+static int32_t dotInt8AVX512(const int8_t* a, const int8_t* b, size_t count) {
+    __m512i sum0 = _mm512_setzero_si512(), sum1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i+64<=count; i += 64){
+        __m512i a0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(a+i)));
+        __m512i b0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(b+i)));
+        __m512i a1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(a+i+32)));
+        __m512i b1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(b+i+32)));
+        sum0 = _mm512_add_epi32(sum0, _mm512_madd_epi16(a0, b0));
+        sum1 = _mm512_add_epi32(sum1, _mm512_madd_epi16(a1, b1));
+    }
+    for (; i+32<=count; i += 32){
+        __m512i a0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(a+i)));
+        __m512i b0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(b+i)));
+        sum0 = _mm512_add_epi32(sum0, _mm512_madd_epi16(a0, b0));
+    }
+    // the remainder is loaded through a mask of a full register and its lower half widened
+    if (i<count){
+        __mmask64 mask = ((__mmask64)1<<(count-i))-1;
+        __m512i a0 = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, a+i)));
+        __m512i b0 = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, b+i)));
+        sum1 = _mm512_add_epi32(sum1, _mm512_madd_epi16(a0, b0));
+    }
+    return _mm512_reduce_add_epi32(_mm512_add_epi32(sum0, sum1));
+}
+
+
+/*
+ * AVX-512 sparse kernels
+ */
+
+// the remainder is gathered through a mask so no column past the end of the row is read
+__attribute__((target("avx512f")))
+static double dotSparseAVX512(const double* values, const uint32_t* columns, const double* inputs, size_t count) {
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i+16<=count; i += 16){
+        __m512d x0 = _mm512_i32gather_pd(_mm256_loadu_si256((const __m256i*)(columns+i)), inputs, 8);
+        __m512d x1 = _mm512_i32gather_pd(_mm256_loadu_si256((const __m256i*)(columns+i+8)), inputs, 8);
+        sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(values+i), x0, sum0);
+        sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(values+i+8), x1, sum1);
+    }
+    for (; i+8<=count; i += 8){
+        __m512d x0 = _mm512_i32gather_pd(_mm256_loadu_si256((const __m256i*)(columns+i)), inputs, 8);
+        sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(values+i), x0, sum0);
+    }
+    if (i<count){
+        __mmask8 mask = (__mmask8)((1u<<(count-i))-1);
+        __m256i index = _mm512_castsi512_si256(_mm512_maskz_loadu_epi32((__mmask16)mask, columns+i));
+        __m512d x0 = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, index, inputs, 8);
+        sum1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, values+i), x0, sum1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+}
+
+#endif
+
+// the activations of every instruction set in the order of the Activation enum, only tanh and sigmoid have vector
+// versions as the rest are cheap next to the dot products feeding them
+#define ACTIVATIONS(Scalar, tanh, sigmoid) \
+        {tanh, reluScalar<Scalar>, leakyReluScalar<Scalar>, sigmoid, linearScalar<Scalar>, softmaxScalar<Scalar>}
+#define ACTIVATION_DERIVATIVES(Scalar, Accumulator, tanhDerivative) \
+        {tanhDerivative, reluDerivativeScalar<Scalar, Accumulator>, leakyReluDerivativeScalar<Scalar, Accumulator>, \
+         sigmoidDerivativeScalar<Scalar, Accumulator>, identityDerivativeScalar<Scalar, Accumulator>, \
+         identityDerivativeScalar<Scalar, Accumulator>}
+// the optimizers in the order of the OptimizerType enum
+#define SCALAR_OPTIMIZERS(Scalar, Accumulator) \
+        {momentumStepScalar<Scalar, Accumulator>, nesterovStepScalar<Scalar, Accumulator>, \
+         adamStepScalar<Scalar, Accumulator>, rmspropStepScalar<Scalar, Accumulator>}
+
+// the kernel tables of every instruction set for each precision, indexed by their KernelLevel
+template<typename Scalar, typename Accumulator>
+struct KernelTables;
+
+template<>
+struct KernelTables<double, double> {
+    static constexpr BasicKernelTable<double> levels[] = {
+            {KernelLevel::SCALAR, dotScalar<double, double>, axpyScalar<double, double>,
+             ACTIVATIONS(double, tanhScalar<double>, sigmoidScalar<double>),
+             ACTIVATION_DERIVATIVES(double, double, (tanhDerivativeScalar<double, double>)),
+             SCALAR_OPTIMIZERS(double, double), momentumUpdateScalar<double, double, double>},
+#ifdef KERNELS_X86
+            {KernelLevel::AVX2, dotAVX2, axpyAVX2, ACTIVATIONS(double, tanhAVX2, sigmoidAVX2),
+             ACTIVATION_DERIVATIVES(double, double, tanhDerivativeAVX2),
+             {momentumStepAVX2, nesterovStepAVX2, adamStepAVX2, rmspropStepAVX2}, momentumUpdateAVX2},
+            {KernelLevel::AVX512, dotAVX512, axpyAVX512, ACTIVATIONS(double, tanhAVX512, sigmoidAVX512),
+             ACTIVATION_DERIVATIVES(double, double, tanhDerivativeAVX512),
+             {momentumStepAVX512, nesterovStepAVX512, adamStepAVX512, rmspropStepAVX512}, momentumUpdateAVX512},
+#endif
+    };
+};
+
+template<>
+struct KernelTables<float, float> {
+    static constexpr BasicKernelTable<float> levels[] = {
+            {KernelLevel::SCALAR, dotScalar<float, float>, axpyScalar<float, float>,
+             ACTIVATIONS(float, tanhScalar<float>, sigmoidScalar<float>),
+             ACTIVATION_DERIVATIVES(float, float, (tanhDerivativeScalar<float, float>)),
+             SCALAR_OPTIMIZERS(float, float), momentumUpdateScalar<float, float, float>},
+#ifdef KERNELS_X86
+            {KernelLevel::AVX2, dotFloatAVX2, axpyFloatAVX2, ACTIVATIONS(float, tanhFloatAVX2, sigmoidFloatAVX2),
+             ACTIVATION_DERIVATIVES(float, float, tanhDerivativeFloatAVX2),
+             {momentumStepFloatAVX2, nesterovStepFloatAVX2, adamStepFloatAVX2, rmspropStepFloatAVX2},
+             momentumUpdateFloatAVX2},
+            {KernelLevel::AVX512, dotFloatAVX512, axpyFloatAVX512,
+             ACTIVATIONS(float, tanhFloatAVX512, sigmoidFloatAVX512),
+             ACTIVATION_DERIVATIVES(float, float, tanhDerivativeFloatAVX512),
+             {momentumStepFloatAVX512, nesterovStepFloatAVX512, adamStepFloatAVX512, rmspropStepFloatAVX512},
+             momentumUpdateFloatAVX512},
+#endif
+    };
+};
+
+// only the sums that run over whole rows are vectorized when the precisions are mixed, the rest is elementwise work
+// on short vectors
+template<>
+struct KernelTables<float, double> {
+    static constexpr BasicKernelTable<float, double> levels[] = {
+            {KernelLevel::SCALAR, dotScalar<float, double>, axpyScalar<float, double>,
+             ACTIVATIONS(float, tanhScalar<float>, sigmoidScalar<float>),
+             ACTIVATION_DERIVATIVES(float, double, (tanhDerivativeScalar<float, double>)),
+             SCALAR_OPTIMIZERS(float, double), momentumUpdateScalar<float, double, float>},
+#ifdef KERNELS_X86
+            {KernelLevel::AVX2, dotMixedAVX2, axpyMixedAVX2, ACTIVATIONS(float, tanhFloatAVX2, sigmoidFloatAVX2),
+             ACTIVATION_DERIVATIVES(float, double, (tanhDerivativeScalar<float, double>)),
+             SCALAR_OPTIMIZERS(float, double), momentumUpdateScalar<float, double, float>},
+            {KernelLevel::AVX512, dotMixedAVX512, axpyMixedAVX512,
+             ACTIVATIONS(float, tanhFloatAVX512, sigmoidFloatAVX512),
+             ACTIVATION_DERIVATIVES(float, double, (tanhDerivativeScalar<float, double>)),
+             SCALAR_OPTIMIZERS(float, double), momentumUpdateScalar<float, double, float>},
+#endif
+    };
+};
+
+static const QuantizedKernelTable quantizedKernels[] = {
+        {KernelLevel::SCALAR, dotInt8Scalar},
+#ifdef KERNELS_X86
+        {KernelLevel::AVX2, dotInt8AVX2},
+        {KernelLevel::AVX512, dotInt8AVX512},
+#endif
+};
+
+static const SparseKernelTable sparseKernels[] = {
+        {KernelLevel::SCALAR, dotSparseScalar},
+#ifdef KERNELS_X86
+        {KernelLevel::AVX2, dotSparseAVX2},
+        {KernelLevel::AVX512, dotSparseAVX512},
+#endif
+};
+
+// check the cpu for the fastest instruction set it supports
+KernelLevel bestKernelLevel() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return KernelLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return KernelLevel::AVX2;
+#endif
+    return KernelLevel::SCALAR;
+}
+
+// the instruction set in use, picked for the cpu the first time it is asked for which the static below makes happen
+// when the program starts. It is atomic since setKernelLevel can change it while other threads are running kernels
+static std::atomic<KernelLevel>& currentLevel() {
+    static std::atomic<KernelLevel> level(bestKernelLevel());
+    return level;
+}
+
+template<typename Scalar, typename Accumulator>
+const BasicKernelTable<Scalar, Accumulator>& getKernels() {
+    return KernelTables<Scalar, Accumulator>::levels[(int)currentLevel().load(std::memory_order_relaxed)];
+}
+
+const QuantizedKernelTable& getQuantizedKernels() {
+    KernelLevel level = getKernels().level;
+#ifdef KERNELS_X86
+    // a cpu can have AVX-512 without the byte instructions in which case the AVX2 kernels are used
+    static const bool hasBytes = __builtin_cpu_supports("avx512bw");
+    if (level == KernelLevel::AVX512 && !hasBytes)
+        level = KernelLevel::AVX2;
+#endif
+    return quantizedKernels[(int)level];
+}
+
+const SparseKernelTable& getSparseKernels() {
+    return sparseKernels[(int)getKernels().level];
+}
+
+bool setKernelLevel(KernelLevel level) {
+    // only allow instruction sets the cpu can actually run
+    if (level>bestKernelLevel()) return false;
+    currentLevel().store(level, std::memory_order_relaxed);
+    return true;
+}
+
+const char* kernelLevelName(KernelLevel level) {
+    switch (level) {
+        case KernelLevel::AVX512: return "AVX-512";
+        case KernelLevel::AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+// pick the kernels when the program starts rather than on the first call from the hot loops
+static const bool kernelsPicked = (getKernels(), true);
+
+// the precisions the network is built for
+template const BasicKernelTable<double>& getKernels<double, double>();
+template const BasicKernelTable<float>& getKernels<float, float>();
+template const BasicKernelTable<float, double>& getKernels<float, double>();
@@ -0,0 +1,87 @@
+
+#ifndef NEURALNETWORK_KERNELS_H
+#define NEURALNETWORK_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "Activation.h"
+#include "Optimizer.h"
+
+/**********************************************************
+ * Program	:  Kernels
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: The vectorized loops that do the actual math of the network. Every kernel has a scalar, AVX2 and
+ *                  AVX-512 version and the fastest one the cpu supports is picked when the program starts. The kernels
+ *                  come in three precisions: double, float, and float values summed into double accumulators. Tanh
+ *                  and sigmoid are vectorized by hand, the other activations are plain loops without branches
+ *
+ *                  Tolerance: the scalar kernels give exactly the same results as the plain loops they replace. The
+ *                  vector kernels add in a different order so dot products differ by at most
+ *                  count * eps * sum(|a[i]*b[i]|) where eps is 2^-52 for double sums and 2^-23 for float sums. The
+ *                  vector tanh and sigmoid are within 1e-15 of the exact values for doubles and within 1e-6 for
+ *                  floats. The int8 kernels of the quantized model are exact and the sparse dot products of the
+ *                  pruned model are within the same bound as the dense ones
+ ***********************************************************/
+
+// the instruction sets the kernels are written for from slowest to fastest
+enum class KernelLevel { SCALAR, AVX2, AVX512 };
+
+// table of the kernels for a single instruction set, the values of the network are stored as Scalar while sums and
+// gradients are kept as Accumulator
+template<typename Scalar, typename Accumulator = Scalar>
+struct BasicKernelTable {
+    KernelLevel level;
+    // sum of a[i]*b[i]
+    Accumulator (*dot)(const Scalar* a, const Scalar* b, size_t count);
+    // y[i] += scale*x[i]
+    void (*axpy)(Accumulator scale, const Scalar* x, Accumulator* y, size_t count);
+    // values[i] = activation(values[i]) for every activation, softmax normalizes all of the values together
+    void (*activate[numActivations])(Scalar* values, size_t count);
+    // gradients[i] *= the derivative of the activation given its output, such as 1 - outputs[i]^2 for tanh
+    void (*activationDerivative[numActivations])(const Scalar* outputs, Accumulator* gradients, size_t count);
+    // one step of every optimizer over a layer in a single pass. The moments and squares are the running averages of
+    // the gradients and squared gradients laid out like the weights, momentum and nesterov keep the last change to
+    // every weight in the moments instead
+    void (*optimizerUpdate[numOptimizers])(const OptimizerStep<Accumulator>& step, const Accumulator* gradients,
+                                           Scalar* moments, Scalar* squares, Scalar* weights, size_t count);
+    // deltas[i] = scale*gradients[i] + alpha*deltas[i] then weights[i] += deltas[i], the momentum update of a single
+    // sample where the gradients are the stored values of the sample
+    void (*momentumRow)(Accumulator scale, const Scalar* gradients, Accumulator alpha, Scalar* deltas,
+                        Scalar* weights, size_t count);
+};
+
+// the kernels of the full precision network
+typedef BasicKernelTable<double> KernelTable;
+
+// the kernels of the quantized model whose values are stored in 8 bits and summed in 32
+struct QuantizedKernelTable {
+    KernelLevel level;
+    // sum of a[i]*b[i]
+    int32_t (*dot)(const int8_t* a, const int8_t* b, size_t count);
+};
+
+// the kernels of the sparse model whose rows only hold the weights left after pruning
+struct SparseKernelTable {
+    KernelLevel level;
+    // sum of values[i]*inputs[columns[i]]
+    double (*dot)(const double* values, const uint32_t* columns, const double* inputs, size_t count);
+};
+
+// get the kernels currently in use for a precision, picked for the cpu the first time they are asked for. Tables
+// exist for <double>, <float> and <float, double>
+template<typename Scalar = double, typename Accumulator = Scalar>
+const BasicKernelTable<Scalar, Accumulator>& getKernels();
+// get the quantized kernels for the instruction set currently in use
+const QuantizedKernelTable& getQuantizedKernels();
+// get the sparse kernels for the instruction set currently in use
+const SparseKernelTable& getSparseKernels();
+// the fastest instruction set supported by the cpu
+KernelLevel bestKernelLevel();
+// switch every precision to the kernels of a given instruction set, returns false if the cpu does not support it. Safe
+// to call while other threads are training, each picks up the new kernels the next time it looks them up
+bool setKernelLevel(KernelLevel level);
+// the name of an instruction set for printing
+const char* kernelLevelName(KernelLevel level);
+
+#endif //NEURALNETWORK_KERNELS_H
@@ -0,0 +1,81 @@
+
+#include "LoadGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+bool generateLoad(const std::string &path, size_t numRequests, size_t numConnections, size_t pipelineDepth,
+                  LoadReport &report) {
+    numConnections = std::max<size_t>(1, numConnections);
+    pipelineDepth = std::max<size_t>(1, pipelineDepth);
+    std::vector<std::vector<double>> latencies(numConnections);
+    std::atomic<bool> failed(false);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (size_t client = 0; client<numConnections; client++)
+        clients.emplace_back([&, client]{
+            uint32_t numInputs = 0, numOutputs = 0;
+            int connection = connectToServer(path, numInputs, numOutputs);
+            if (connection<0){
+                failed = true;
+                return;
+            }
+            // every client sends its own share of the requests with inputs from its own generator
+            size_t count = numRequests*(client+1)/numConnections-numRequests*client/numConnections;
+            std::mt19937 generator((unsigned)client);
+            std::uniform_real_distribution<double> distribution(0.0, 1.0);
+            std::vector<double> inputs(numInputs), outputs;
+            std::deque<std::chrono::steady_clock::time_point> sent;
+            size_t numSent = 0, numAnswered = 0;
+            while (numAnswered<count){
+                // keep the pipeline full and then wait for the oldest answer
+                while (numSent<count && sent.size()<pipelineDepth){
+                    for (double& input:inputs)
+                        input = distribution(generator);
+                    sent.push_back(std::chrono::steady_clock::now());
+                    if (!writeFrame(connection, inputs.data(), numInputs)) break;
+                    numSent++;
+                }
+                if (!readFrame(connection, outputs, numOutputs) || outputs.size() != numOutputs){
+                    failed = true;
+                    break;
+                }
+                latencies[client].push_back(
+                        std::chrono::duration<double>(std::chrono::steady_clock::now()-sent.front()).count());
+                sent.pop_front();
+                numAnswered++;
+            }
+            close(connection);
+        });
+    for (std::thread& client:clients)
+        client.join();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    // put the latencies of every client together for the percentiles
+    std::vector<double> all;
+    for (const std::vector<double>& clientLatencies:latencies)
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    std::sort(all.begin(), all.end());
+    report.requests = all.size();
+    report.requestsPerSecond = report.seconds>0 ? all.size()/report.seconds : 0;
+    report.p50Latency = all.empty() ? 0 : all[all.size()/2];
+    report.p99Latency = all.empty() ? 0 : all[all.size()*99/100];
+
+    // ask the server how it saw the load
+    report.server = InferenceStatistics{};
+    uint32_t numInputs, numOutputs;
+    int connection = connectToServer(path, numInputs, numOutputs);
+    std::vector<double> statistics;
+    if (connection>=0 && writeFrame(connection, nullptr, 0) &&
+        readFrame(connection, statistics, inferenceStatisticsSize) && statistics.size() == inferenceStatisticsSize)
+        report.server = InferenceStatistics{(size_t)statistics[0], (size_t)statistics[1], statistics[2],
+                                            statistics[3], statistics[4], statistics[5]};
+    if (connection>=0)
+        close(connection);
+    return !failed;
+}
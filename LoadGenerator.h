@@ -0,0 +1,31 @@
+
+#ifndef NEURALNETWORK_LOADGENERATOR_H
+#define NEURALNETWORK_LOADGENERATOR_H
+
+#include <string>
+#include "InferenceServer.h"
+
+/**********************************************************
+ * Program	:  Load Generator
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A client for the inference server that sends it random samples from many connections at once and
+ *                  times every answer, so the batching of the server can be tried out and tuned on one machine
+ ***********************************************************/
+
+// how the server held up under the load as seen by the clients, along with the server's own statistics
+struct LoadReport {
+    size_t requests;
+    double seconds, requestsPerSecond;
+    // the time from sending a request to reading its answer in seconds
+    double p50Latency, p99Latency;
+    InferenceStatistics server;
+};
+
+// send the requests spread over the given number of connections, each keeping up to pipelineDepth requests in flight
+// at a time, returns false if a connection could not be made or was closed before every answer came back
+bool generateLoad(const std::string& path, size_t numRequests, size_t numConnections, size_t pipelineDepth,
+                  LoadReport& report);
+
+
+#endif //NEURALNETWORK_LOADGENERATOR_H
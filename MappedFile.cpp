@@ -0,0 +1,25 @@
+
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::shared_ptr<const void> mapFile(const std::string &fileName, size_t &size) {
+    int descriptor = open(fileName.c_str(), O_RDONLY);
+    if (descriptor<0)
+        return nullptr;
+    struct stat status = {};
+    void* data = MAP_FAILED;
+    size_t mappedSize = 0;
+    if (fstat(descriptor, &status) == 0 && status.st_size>0){
+        mappedSize = (size_t)status.st_size;
+        data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    // the mapping stays valid after the file is closed
+    close(descriptor);
+    if (data == MAP_FAILED)
+        return nullptr;
+    size = mappedSize;
+    return std::shared_ptr<const void>(data, [mappedSize](const void* mapped){ munmap((void*)mapped, mappedSize); });
+}
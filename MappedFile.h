@@ -0,0 +1,19 @@
+
+#ifndef NEURALNETWORK_MAPPEDFILE_H
+#define NEURALNETWORK_MAPPEDFILE_H
+
+#include <string>
+#include <memory>
+
+/**********************************************************
+ * Program	:  Mapped File
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Maps a whole file read only into memory so the binary files of the network can be used in place
+ *                  without reading them. The mapping is released when the last pointer to it goes away
+ ***********************************************************/
+
+// map the file and set its size, returns nullptr if the file cannot be opened, is empty or cannot be mapped
+std::shared_ptr<const void> mapFile(const std::string& fileName, size_t& size);
+
+#endif //NEURALNETWORK_MAPPEDFILE_H
@@ -0,0 +1,161 @@
+
+#include "Model.h"
+#include "Kernels.h"
+
+// size both buffers for the widest layer of the model
+template<typename Scalar, typename Accumulator>
+BasicWorkspace<Scalar, Accumulator>::BasicWorkspace(const BasicModel<Scalar, Accumulator> &model) {
+    current.resize(model.getMaxWidth());
+    next.resize(model.getMaxWidth());
+}
+
+// copy every layer's weights into one block of memory owned by the model
+template<typename Scalar, typename Accumulator>
+BasicModel<Scalar, Accumulator>::BasicModel(const BasicNeuralNetwork<Scalar, Accumulator> &network) : maxWidth(0) {
+    typedef typename BasicNeuralNetwork<Scalar, Accumulator>::PackedLayer PackedLayer;
+    const std::vector<PackedLayer>& packedLayers = network.getPackedLayers();
+    size_t numWeights = 0;
+    for (const PackedLayer& layer:packedLayers)
+        numWeights += layer.weights.size();
+    std::shared_ptr<std::vector<Scalar>> weights = std::make_shared<std::vector<Scalar>>();
+    weights->reserve(numWeights);
+
+    for (const PackedLayer& packed:packedLayers){
+        const Scalar* layerWeights = weights->data()+weights->size();
+        weights->insert(weights->end(), packed.weights.begin(), packed.weights.end());
+        layers.push_back(Layer{packed.numNeurons, packed.numInputs, packed.weights.empty() ? nullptr : layerWeights,
+                               packed.outputs.back(), packed.activation});
+    }
+    storage = weights;
+    maxWidth = getMaxWidth();
+}
+
+template<typename Scalar, typename Accumulator>
+BasicModel<Scalar, Accumulator>::BasicModel(std::vector<Layer> layers, std::shared_ptr<const void> storage) :
+        layers(std::move(layers)), maxWidth(0), storage(std::move(storage)) {
+    maxWidth = getMaxWidth();
+}
+
+// run the inputs through every layer bouncing between the two buffers of the workspace
+template<typename Scalar, typename Accumulator>
+void BasicModel<Scalar, Accumulator>::predict(const Scalar *inputs, Scalar *outputs, Workspace &workspace) const {
+    // a default workspace is sized on its first use, after that predicting never allocates
+    if (workspace.current.size()<maxWidth){
+        workspace.current.resize(maxWidth);
+        workspace.next.resize(maxWidth);
+    }
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    Scalar* current = workspace.current.data();
+    Scalar* next = workspace.next.data();
+
+    // the input layer followed by its bias
+    std::copy(inputs, inputs+layers[0].numNeurons, current);
+    current[layers[0].numNeurons] = layers[0].bias;
+
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const Layer& layer = layers[layerNumber];
+        forEachTile(layer, 1, workspace, [&](size_t firstNeuron, size_t lastNeuron){
+            for (size_t neuron = firstNeuron; neuron<lastNeuron; neuron++)
+                next[neuron] = kernels.dot(current, layer.weights+neuron*layer.numInputs, layer.numInputs);
+        });
+        kernels.activate[(size_t)layer.activation](next, layer.numNeurons);
+        next[layer.numNeurons] = layer.bias;
+        std::swap(current, next);
+    }
+    std::copy(current, current+layers.back().numNeurons, outputs);
+}
+
+// run a batch through every layer with the rows of every sample stored one after another in the workspace, the
+// neurons are taken a tile at a time so their weights stay in the cache while every sample streams past them
+template<typename Scalar, typename Accumulator>
+void BasicModel<Scalar, Accumulator>::predictBatch(const Scalar *inputs, size_t count, Scalar *outputs,
+                                                   Workspace &workspace) const {
+    if (workspace.current.size()<count*maxWidth){
+        workspace.current.resize(count*maxWidth);
+        workspace.next.resize(count*maxWidth);
+    }
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    Scalar* current = workspace.current.data();
+    Scalar* next = workspace.next.data();
+
+    // the inputs of every sample followed by the input layer's bias
+    size_t numInputs = layers[0].numNeurons;
+    for (size_t sample = 0; sample<count; sample++){
+        std::copy(inputs+sample*numInputs, inputs+(sample+1)*numInputs, current+sample*(numInputs+1));
+        current[sample*(numInputs+1)+numInputs] = layers[0].bias;
+    }
+
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const Layer& layer = layers[layerNumber];
+        size_t stride = layer.numNeurons+1;
+        forEachTile(layer, count, workspace, [&](size_t firstNeuron, size_t lastNeuron){
+            for (size_t sample = 0; sample<count; sample++)
+                for (size_t neuron = firstNeuron; neuron<lastNeuron; neuron++)
+                    next[sample*stride+neuron] = kernels.dot(current+sample*layer.numInputs,
+                                                             layer.weights+neuron*layer.numInputs, layer.numInputs);
+        });
+        auto activate = kernels.activate[(size_t)layer.activation];
+        for (size_t sample = 0; sample<count; sample++){
+            activate(next+sample*stride, layer.numNeurons);
+            next[sample*stride+layer.numNeurons] = layer.bias;
+        }
+        std::swap(current, next);
+    }
+
+    // drop the bias from the rows of the output layer
+    size_t numOutputs = layers.back().numNeurons;
+    for (size_t sample = 0; sample<count; sample++)
+        std::copy(current+sample*(numOutputs+1), current+sample*(numOutputs+1)+numOutputs, outputs+sample*numOutputs);
+}
+
+// split the neurons of a layer into tiles whose weights fit in the cache and run them in order, or on every thread of
+// the workspace's pool when the layer is wide enough to be worth waking them
+template<typename Scalar, typename Accumulator>
+template<typename Function>
+void BasicModel<Scalar, Accumulator>::forEachTile(const Layer &layer, size_t count, Workspace &workspace,
+                                                  const Function &function) {
+    size_t tile = std::max<size_t>(1, tileSize/layer.numInputs);
+    size_t numTiles = (layer.numNeurons+tile-1)/tile;
+    if (workspace.pool && workspace.pool->getNumThreads()>1 && numTiles>1 &&
+        layer.numNeurons*layer.numInputs*count>=workspace.parallelThreshold){
+        workspace.pool->run(numTiles, [&](size_t index){
+            function(index*tile, std::min((index+1)*tile, layer.numNeurons));
+        });
+        return;
+    }
+    for (size_t firstNeuron = 0; firstNeuron<layer.numNeurons; firstNeuron += tile)
+        function(firstNeuron, std::min(firstNeuron+tile, layer.numNeurons));
+}
+
+template<typename Scalar, typename Accumulator>
+size_t BasicModel<Scalar, Accumulator>::getNumInputs() const {
+    return layers.front().numNeurons;
+}
+
+template<typename Scalar, typename Accumulator>
+size_t BasicModel<Scalar, Accumulator>::getNumOutputs() const {
+    return layers.back().numNeurons;
+}
+
+// the widest layer is worked out once when the model is made and cached from then on
+template<typename Scalar, typename Accumulator>
+size_t BasicModel<Scalar, Accumulator>::getMaxWidth() const {
+    if (maxWidth) return maxWidth;
+    size_t width = 0;
+    for (const Layer& layer:layers)
+        width = std::max(width, layer.numNeurons+1);
+    return width;
+}
+
+template<typename Scalar, typename Accumulator>
+const std::vector<typename BasicModel<Scalar, Accumulator>::Layer> &BasicModel<Scalar, Accumulator>::getLayers() const {
+    return layers;
+}
+
+// the precisions the model is built for
+template struct BasicWorkspace<double>;
+template struct BasicWorkspace<float>;
+template struct BasicWorkspace<float, double>;
+template class BasicModel<double>;
+template class BasicModel<float>;
+template class BasicModel<float, double>;
@@ -0,0 +1,98 @@
+
+#ifndef NEURALNETWORK_MODEL_H
+#define NEURALNETWORK_MODEL_H
+
+#include <vector>
+#include <memory>
+#include "NeuralNetwork.h"
+#include "WorkStealingPool.h"
+
+/**********************************************************
+ * Program	:  Model
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: The weights of a trained network frozen into an immutable object. Nothing in a model changes after it
+ *                  is made so any number of threads can run it at once, each bringing its own workspace to hold the
+ *                  values passing through the layers. A workspace given a pool runs every wide layer on all of the
+ *                  pool's threads, each taking tiles of the layer's neurons whose weights fit in its cache, so a single
+ *                  request through a large network uses every core. Every sum is taken exactly as it is on one thread
+ *                  so the outputs are the same either way
+ ***********************************************************/
+
+template<typename Scalar, typename Accumulator>
+class BasicModel;
+
+// the scratch space one caller needs to run a model, sized for the model it is made for so predicting never allocates
+template<typename Scalar, typename Accumulator = Scalar>
+struct BasicWorkspace {
+    BasicWorkspace() = default;
+    explicit BasicWorkspace(const BasicModel<Scalar, Accumulator>& model);
+    // two buffers big enough for the widest layer of every sample in the largest batch run so far, each layer reads
+    // from one and writes to the other
+    std::vector<Scalar> current, next;
+    // the threads splitting the neurons of a layer between them, only used for layers taking at least the threshold
+    // of multiply-adds over every sample of the call so tiny layers never pay for waking the threads
+    std::shared_ptr<WorkStealingPool> pool;
+    size_t parallelThreshold = 64*1024;
+};
+
+// a model whose weights and values are stored as Scalar and whose sums are taken in Accumulator, built for the same
+// precisions as the network
+template<typename Scalar, typename Accumulator = Scalar>
+class BasicModel {
+public:
+    typedef BasicWorkspace<Scalar, Accumulator> Workspace;
+
+    // a layer of the model pointing into the model's weight storage
+    struct Layer {
+        // the number of neurons in the layer and the number of inputs into each, including the bias
+        size_t numNeurons, numInputs;
+        // row major matrix of the weights feeding into the layer
+        const Scalar* weights;
+        // the value of the layer's bias neuron which is fed into the next layer
+        Scalar bias;
+        // the activation function applied to the layer's sums
+        Activation activation;
+    };
+
+    // freeze a copy of the network's current weights
+    explicit BasicModel(const BasicNeuralNetwork<Scalar, Accumulator>& network);
+    // a model over weights stored elsewhere, the storage is kept alive for as long as the model is
+    BasicModel(std::vector<Layer> layers, std::shared_ptr<const void> storage);
+
+    // feed the inputs forward and write the outputs, safe to call from many threads as long as each has its own
+    // workspace
+    void predict(const Scalar* inputs, Scalar* outputs, Workspace& workspace) const;
+    // feed forward a batch of samples stored one after another as one matrix-matrix product per layer, the workspace
+    // grows to fit the largest batch it is used for
+    void predictBatch(const Scalar* inputs, size_t count, Scalar* outputs, Workspace& workspace) const;
+
+    // the number of inputs and outputs of the model and the size of the widest layer including its bias
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+    size_t getMaxWidth() const;
+    // the layers of the model with the input layer first
+    const std::vector<Layer>& getLayers() const;
+
+private:
+    // call the function with the first and last neuron of every tile of the layer for a call over count samples
+    template<typename Function>
+    static void forEachTile(const Layer& layer, size_t count, Workspace& workspace, const Function& function);
+
+    std::vector<Layer> layers;
+    // the size of the widest layer including its bias
+    size_t maxWidth;
+    // the number of a layer's weights that are processed together so they stay in the cache (32KiB of them)
+    constexpr static size_t tileSize = 32*1024/sizeof(Scalar);
+    // owner of the memory the weights of the layers point into
+    std::shared_ptr<const void> storage;
+};
+
+// the model in double precision, and in single precision with and without double sums
+typedef BasicModel<double> Model;
+typedef BasicWorkspace<double> Workspace;
+typedef BasicModel<float> FloatModel;
+typedef BasicModel<float, double> MixedModel;
+
+
+#endif //NEURALNETWORK_MODEL_H
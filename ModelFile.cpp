@@ -0,0 +1,527 @@
+
+#include "ModelFile.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// the magic bytes every model file starts with
+static const char modelFileMagic[8] = {'N', 'N', 'M', 'O', 'D', 'E', 'L', '\0'};
+
+// round an offset up to the alignment of the weight blocks
+static uint64_t align(uint64_t offset) {
+    return (offset+modelFileAlignment-1)/modelFileAlignment*modelFileAlignment;
+}
+
+// write zeros to the file until it reaches the given offset
+static void padTo(std::fstream& file, uint64_t& position, uint64_t offset) {
+    static const char zeros[modelFileAlignment] = {};
+    file.write(zeros, offset-position);
+    position = offset;
+}
+
+// copy weights stored in the file as float32 or float64 onto the end of a vector of any precision
+template<typename T>
+static void appendValues(const char* from, uint32_t scalarSize, size_t count, std::vector<T>& to) {
+    if (scalarSize == sizeof(float))
+        to.insert(to.end(), (const float*)from, (const float*)from+count);
+    else
+        to.insert(to.end(), (const double*)from, (const double*)from+count);
+}
+
+template<typename Scalar, typename Accumulator>
+bool saveModelFile(const BasicNeuralNetwork<Scalar, Accumulator> &network, const std::string &fileName,
+                   bool includeTrainingState, const TrainingProgress* progress) {
+    typedef typename BasicNeuralNetwork<Scalar, Accumulator>::PackedLayer PackedLayer;
+    const std::vector<PackedLayer>& layers = network.getPackedLayers();
+
+    // fill in the header and lay out the blocks of weights one after another after the layer table
+    ModelFileHeader header = {};
+    std::memcpy(header.magic, modelFileMagic, sizeof(modelFileMagic));
+    header.version = modelFileVersion;
+    header.numLayers = (uint32_t)layers.size();
+    header.scalarSize = sizeof(Scalar);
+    // the progress is part of the training state so it is only saved along with it
+    if (!includeTrainingState)
+        progress = nullptr;
+    header.flags = includeTrainingState ? MODEL_FILE_TRAINING_STATE | MODEL_FILE_OPTIMIZER_STATE : 0;
+    if (progress)
+        header.flags |= MODEL_FILE_PROGRESS;
+    header.errorRate = network.getErrorRate();
+    header.averageError = network.getAverageError();
+    header.averageSmoothingFactor = network.getAverageSmoothingFactor();
+    const OptimizerSettings& settings = network.getOptimizer();
+    header.learningRate = settings.learningRate;
+    header.alpha = settings.momentum;
+
+    // the optimizer is saved with the training state so it can carry on exactly where it stopped
+    ModelFileOptimizer optimizer = {(uint32_t)settings.type, (uint32_t)settings.schedule, settings.learningRate,
+                                    settings.momentum, settings.beta1, settings.beta2, settings.epsilon,
+                                    settings.weightDecay, settings.decayRate, settings.decaySteps,
+                                    settings.warmupSteps, network.getOptimizerStep()};
+    std::vector<ModelFileOptimizerLayer> optimizerTable(includeTrainingState ? layers.size() : 0);
+
+    std::vector<ModelFileLayer> table(layers.size());
+    uint64_t tablesSize = sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*layers.size();
+    if (includeTrainingState)
+        tablesSize += sizeof(ModelFileOptimizer)+sizeof(ModelFileOptimizerLayer)*layers.size();
+    if (progress)
+        tablesSize += sizeof(ModelFileProgress);
+    uint64_t offset = tablesSize;
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        table[layer] = ModelFileLayer{(uint32_t)layers[layer].numNeurons, (uint32_t)layers[layer].numInputs,
+                                      (uint32_t)layers[layer].activation, 0, layers[layer].outputs.back(), 0, 0};
+        if (layers[layer].weights.empty()) continue;
+        uint64_t blockSize = layers[layer].weights.size()*sizeof(Scalar);
+        table[layer].weightsOffset = offset = align(offset);
+        offset += blockSize;
+        if (!includeTrainingState) continue;
+        table[layer].deltaWeightsOffset = offset = align(offset);
+        offset += blockSize;
+        // the running averages are only there once an optimizer has needed them
+        if (layers[layer].moments.size() == layers[layer].weights.size()){
+            optimizerTable[layer].momentsOffset = offset = align(offset);
+            offset += blockSize;
+        }
+        if (layers[layer].squares.size() == layers[layer].weights.size()){
+            optimizerTable[layer].squaresOffset = offset = align(offset);
+            offset += blockSize;
+        }
+    }
+    // the state of the random engine and the path of the best network are text of any length so they go after every
+    // block
+    ModelFileProgress saved = {};
+    if (progress){
+        saved = ModelFileProgress{progress->epoch, progress->sample, progress->samplesTrained, progress->bestError,
+                                  progress->epochsWithoutImprovement, 0, progress->randomState.size(), 0,
+                                  progress->bestModelFile.size(), progress->numEpochs, progress->patience,
+                                  progress->batchSize, progress->validationFraction};
+        if (!progress->randomState.empty()){
+            saved.randomStateOffset = offset;
+            offset += progress->randomState.size();
+        }
+        if (!progress->bestModelFile.empty()){
+            saved.bestModelFileOffset = offset;
+            offset += progress->bestModelFile.size();
+        }
+    }
+    header.fileSize = offset;
+
+    // write the header, the layer table, the optimizer and then every block at its offset
+    std::fstream file;
+    file.open(fileName, std::fstream::out | std::fstream::binary);
+    if (!file)
+        return false;
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)table.data(), sizeof(ModelFileLayer)*table.size());
+    if (includeTrainingState){
+        file.write((const char*)&optimizer, sizeof(optimizer));
+        file.write((const char*)optimizerTable.data(), sizeof(ModelFileOptimizerLayer)*optimizerTable.size());
+    }
+    if (progress)
+        file.write((const char*)&saved, sizeof(saved));
+    uint64_t position = tablesSize;
+    auto writeBlock = [&](uint64_t blockOffset, const std::vector<Scalar>& values){
+        if (!blockOffset) return;
+        padTo(file, position, blockOffset);
+        file.write((const char*)values.data(), values.size()*sizeof(Scalar));
+        position += values.size()*sizeof(Scalar);
+    };
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        writeBlock(table[layer].weightsOffset, layers[layer].weights);
+        writeBlock(table[layer].deltaWeightsOffset, layers[layer].deltaWeights);
+        if (!includeTrainingState) continue;
+        writeBlock(optimizerTable[layer].momentsOffset, layers[layer].moments);
+        writeBlock(optimizerTable[layer].squaresOffset, layers[layer].squares);
+    }
+    if (saved.randomStateOffset){
+        padTo(file, position, saved.randomStateOffset);
+        file.write(progress->randomState.data(), progress->randomState.size());
+        position += progress->randomState.size();
+    }
+    if (saved.bestModelFileOffset){
+        padTo(file, position, saved.bestModelFileOffset);
+        file.write(progress->bestModelFile.data(), progress->bestModelFile.size());
+    }
+    file.close();
+    return !file.fail();
+}
+
+// the optimizer and its table of layers stored after the layer table of a file with the training state
+static const ModelFileOptimizer* optimizerOf(const char* data) {
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    return (const ModelFileOptimizer*)(data+sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*header->numLayers);
+}
+
+static const ModelFileOptimizerLayer* optimizerLayersOf(const char* data) {
+    return (const ModelFileOptimizerLayer*)(optimizerOf(data)+1);
+}
+
+// the progress of the run stored after the optimizer tables of a checkpoint
+static const ModelFileProgress* progressOf(const char* data) {
+    return (const ModelFileProgress*)(optimizerLayersOf(data)+((const ModelFileHeader*)data)->numLayers);
+}
+
+// whether a block read from a file lies inside it, the offset is checked first so one near the top of the range
+// cannot wrap around past the end of the file
+static bool insideFile(uint64_t offset, uint64_t blockSize, uint64_t size) {
+    return offset<=size && blockSize<=size-offset;
+}
+
+// check the header and layer table of a mapped file describe a network that fits inside the file and is the kind of
+// model the caller expects, a network (zero), a quantized model (MODEL_FILE_QUANTIZED) or a sparse one
+// (MODEL_FILE_SPARSE)
+static bool validModelFile(const std::string& fileName, const char* data, size_t size, uint32_t kind) {
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    const ModelFileLayer* table = (const ModelFileLayer*)(data+sizeof(ModelFileHeader));
+    bool quantized = kind == MODEL_FILE_QUANTIZED, sparse = kind == MODEL_FILE_SPARSE;
+    uint32_t fileKind = size>=sizeof(ModelFileHeader) ? header->flags & (MODEL_FILE_QUANTIZED | MODEL_FILE_SPARSE) : 0;
+    std::string error;
+    if (size<sizeof(ModelFileHeader) || std::memcmp(header->magic, modelFileMagic, sizeof(modelFileMagic)) != 0)
+        error = "not a model file";
+    else if (header->version != modelFileVersion)
+        error = "unsupported version "+std::to_string(header->version);
+    else if (fileKind != kind)
+        error = quantized ? "not a quantized model" : sparse ? "not a sparse model" :
+                fileKind & MODEL_FILE_QUANTIZED ? "quantized models can only be loaded as quantized models" :
+                "sparse models can only be loaded as sparse models";
+    else if (quantized ? header->scalarSize != sizeof(int8_t) || (header->flags & MODEL_FILE_TRAINING_STATE) :
+             sparse ? header->scalarSize != sizeof(double) || (header->flags & MODEL_FILE_TRAINING_STATE) :
+                      header->scalarSize != sizeof(float) && header->scalarSize != sizeof(double))
+        error = "unsupported weight size "+std::to_string(header->scalarSize);
+    else if (header->fileSize != size || header->numLayers<(kind ? 2 : 1) ||
+             sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*(uint64_t)header->numLayers>size ||
+             ((header->flags & MODEL_FILE_OPTIMIZER_STATE) &&
+              sizeof(ModelFileHeader)+(sizeof(ModelFileLayer)+sizeof(ModelFileOptimizerLayer))*
+                                      (uint64_t)header->numLayers+sizeof(ModelFileOptimizer)>size))
+        error = "file is truncated";
+    else if ((header->flags & MODEL_FILE_OPTIMIZER_STATE) &&
+             (kind || !(header->flags & MODEL_FILE_TRAINING_STATE) ||
+              optimizerOf(data)->type>=numOptimizers || optimizerOf(data)->schedule>=numSchedules))
+        error = "unsupported optimizer";
+    else if ((header->flags & MODEL_FILE_PROGRESS) &&
+             (!(header->flags & MODEL_FILE_OPTIMIZER_STATE) ||
+              (const char*)(progressOf(data)+1)>data+size ||
+              !insideFile(progressOf(data)->randomStateOffset, progressOf(data)->randomStateSize, size) ||
+              (progressOf(data)->randomStateSize && !progressOf(data)->randomStateOffset) ||
+              !insideFile(progressOf(data)->bestModelFileOffset, progressOf(data)->bestModelFileSize, size) ||
+              (progressOf(data)->bestModelFileSize && !progressOf(data)->bestModelFileOffset)))
+        error = "progress of the run is outside the file";
+    else if ((header->flags & MODEL_FILE_PROGRESS) &&
+             (progressOf(data)->batchSize == 0 || !(progressOf(data)->validationFraction>=0) ||
+              progressOf(data)->validationFraction>=1))
+        error = "settings of the run are invalid";
+    for (uint32_t layer = 0; error.empty() && layer<header->numLayers; layer++){
+        uint64_t numWeights = (uint64_t)table[layer].numNeurons*table[layer].numInputs;
+        // a sparse layer only stores the weights it kept, a layer with more than fit in the file is rejected before
+        // the size of its block can overflow
+        uint64_t storedWeights = sparse ? table[layer].numWeights : numWeights;
+        uint64_t blockSize = storedWeights*header->scalarSize;
+        // the second block holds either the delta weights, the scales of a quantized layer or the rows of a sparse one
+        bool hasSecondBlock = header->flags & (MODEL_FILE_TRAINING_STATE | MODEL_FILE_QUANTIZED | MODEL_FILE_SPARSE);
+        uint64_t secondBlockSize = quantized ? (table[layer].numNeurons+1)*(uint64_t)sizeof(float) :
+                                   sparse ? (table[layer].numNeurons+1+(uint64_t)table[layer].numWeights)*
+                                            sizeof(uint32_t) : blockSize;
+        // every layer but the input layer takes the previous layer and its bias as input
+        if (layer>0 && table[layer].numInputs != table[layer-1].numNeurons+1)
+            error = "layer "+std::to_string(layer)+" does not match the previous layer";
+        // softmax can only be used by the output layer
+        else if (table[layer].activation>=numActivations ||
+                 (table[layer].activation == (uint32_t)Activation::SOFTMAX && layer+1 != header->numLayers))
+            error = "layer "+std::to_string(layer)+" has an unsupported activation";
+        else if (sparse && table[layer].numWeights>(layer == 0 ? 0 : numWeights))
+            error = "layer "+std::to_string(layer)+" keeps more weights than it has";
+        else if (layer>0 && (storedWeights>size/header->scalarSize ||
+                             table[layer].weightsOffset%modelFileAlignment ||
+                             !insideFile(table[layer].weightsOffset, blockSize, size) ||
+                             (hasSecondBlock && (table[layer].deltaWeightsOffset%modelFileAlignment ||
+                                                 !insideFile(table[layer].deltaWeightsOffset, secondBlockSize,
+                                                             size)))))
+            error = "weights of layer "+std::to_string(layer)+" are outside the file";
+        else if (layer>0 && (header->flags & MODEL_FILE_OPTIMIZER_STATE)){
+            const ModelFileOptimizerLayer& averages = optimizerLayersOf(data)[layer];
+            for (uint64_t offset:{averages.momentsOffset, averages.squaresOffset})
+                if (offset && (offset%modelFileAlignment || !insideFile(offset, blockSize, size)))
+                    error = "optimizer state of layer "+std::to_string(layer)+" is outside the file";
+        }
+        else if (layer>0 && sparse){
+            // the rows are used straight from the file so every one must stay inside the weights and inputs
+            const uint32_t* rowStarts = (const uint32_t*)(data+table[layer].deltaWeightsOffset);
+            const uint32_t* columns = rowStarts+table[layer].numNeurons+1;
+            bool valid = rowStarts[0] == 0 && rowStarts[table[layer].numNeurons] == table[layer].numWeights;
+            for (uint32_t neuron = 0; valid && neuron<table[layer].numNeurons; neuron++)
+                valid = rowStarts[neuron]<=rowStarts[neuron+1];
+            for (uint32_t weight = 0; valid && weight<table[layer].numWeights; weight++)
+                valid = columns[weight]<table[layer].numInputs;
+            if (!valid)
+                error = "rows of layer "+std::to_string(layer)+" are invalid";
+        }
+    }
+    if (!error.empty())
+        std::cerr<<fileName<<": "<<error<<std::endl;
+    return error.empty();
+}
+
+template<typename Scalar, typename Accumulator>
+std::shared_ptr<const BasicModel<Scalar, Accumulator>> loadModelFile(const std::string &fileName) {
+    typedef BasicModel<Scalar, Accumulator> Model;
+    size_t size = 0;
+    std::shared_ptr<const void> mapping = mapFile(fileName, size);
+    if (!mapping || !validModelFile(fileName, (const char*)mapping.get(), size, 0))
+        return nullptr;
+
+    const char* data = (const char*)mapping.get();
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    const ModelFileLayer* table = (const ModelFileLayer*)(data+sizeof(ModelFileHeader));
+    std::vector<typename Model::Layer> layers;
+    // weights of the precision asked for are used straight from the mapping, otherwise they are converted into one
+    // block of memory owned by the model which is sized up front so the layers can point into it
+    std::shared_ptr<std::vector<Scalar>> converted;
+    if (header->scalarSize != sizeof(Scalar)){
+        size_t numWeights = 0;
+        for (uint32_t layer = 1; layer<header->numLayers; layer++)
+            numWeights += (size_t)table[layer].numNeurons*table[layer].numInputs;
+        converted = std::make_shared<std::vector<Scalar>>();
+        converted->reserve(numWeights);
+    }
+    for (uint32_t layer = 0; layer<header->numLayers; layer++){
+        const Scalar* weights = nullptr;
+        if (layer>0 && converted){
+            weights = converted->data()+converted->size();
+            appendValues(data+table[layer].weightsOffset, header->scalarSize,
+                         (size_t)table[layer].numNeurons*table[layer].numInputs, *converted);
+        } else if (layer>0)
+            weights = (const Scalar*)(data+table[layer].weightsOffset);
+        layers.push_back(typename Model::Layer{table[layer].numNeurons, table[layer].numInputs, weights,
+                                               (Scalar)table[layer].bias, (Activation)table[layer].activation});
+    }
+    if (converted)
+        return std::make_shared<const Model>(std::move(layers), std::move(converted));
+    return std::make_shared<const Model>(std::move(layers), std::move(mapping));
+}
+
+template<typename Scalar, typename Accumulator>
+bool loadNetworkFile(const std::string &fileName, BasicNeuralNetwork<Scalar, Accumulator> &network,
+                     TrainingProgress* progress) {
+    typedef typename BasicNeuralNetwork<Scalar, Accumulator>::PackedLayer PackedLayer;
+    size_t size = 0;
+    std::shared_ptr<const void> mapping = mapFile(fileName, size);
+    if (!mapping || !validModelFile(fileName, (const char*)mapping.get(), size, 0))
+        return false;
+
+    // copy the weights out of the mapping into layers the network can change
+    const char* data = (const char*)mapping.get();
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    const ModelFileLayer* table = (const ModelFileLayer*)(data+sizeof(ModelFileHeader));
+    std::vector<PackedLayer> layers(header->numLayers);
+    for (uint32_t layer = 0; layer<header->numLayers; layer++){
+        PackedLayer& packed = layers[layer];
+        packed.numNeurons = table[layer].numNeurons;
+        packed.numInputs = layer == 0 ? 0 : table[layer].numInputs;
+        packed.activation = (Activation)table[layer].activation;
+        packed.outputs.assign(packed.numNeurons+1, 0.0);
+        packed.outputs.back() = table[layer].bias;
+        packed.gradients.assign(packed.numNeurons+1, 0.0);
+        if (layer == 0) continue;
+        size_t numWeights = packed.numNeurons*packed.numInputs;
+        appendValues(data+table[layer].weightsOffset, header->scalarSize, numWeights, packed.weights);
+        if (header->flags & MODEL_FILE_TRAINING_STATE)
+            appendValues(data+table[layer].deltaWeightsOffset, header->scalarSize, numWeights, packed.deltaWeights);
+        else
+            packed.deltaWeights.assign(numWeights, 0.0);
+        if (!(header->flags & MODEL_FILE_OPTIMIZER_STATE)) continue;
+        const ModelFileOptimizerLayer& averages = optimizerLayersOf(data)[layer];
+        if (averages.momentsOffset)
+            appendValues(data+averages.momentsOffset, header->scalarSize, numWeights, packed.moments);
+        if (averages.squaresOffset)
+            appendValues(data+averages.squaresOffset, header->scalarSize, numWeights, packed.squares);
+    }
+    network = BasicNeuralNetwork<Scalar, Accumulator>(std::move(layers), header->errorRate, header->averageError,
+                                                      header->averageSmoothingFactor);
+    // files saved without the optimizer keep training with momentum at the rate they were saved with
+    OptimizerSettings settings;
+    settings.learningRate = header->learningRate;
+    settings.momentum = header->alpha;
+    if (header->flags & MODEL_FILE_OPTIMIZER_STATE){
+        const ModelFileOptimizer* optimizer = optimizerOf(data);
+        settings = OptimizerSettings{(OptimizerType)optimizer->type, optimizer->learningRate, optimizer->momentum,
+                                     optimizer->beta1, optimizer->beta2, optimizer->epsilon, optimizer->weightDecay,
+                                     (LearningRateSchedule)optimizer->schedule, optimizer->decayRate,
+                                     optimizer->decaySteps, optimizer->warmupSteps};
+        network.setOptimizerStep(optimizer->step);
+    }
+    network.setOptimizer(settings);
+    // a file that is not a checkpoint starts its run from the beginning
+    if (progress){
+        *progress = TrainingProgress();
+        if (header->flags & MODEL_FILE_PROGRESS){
+            const ModelFileProgress* saved = progressOf(data);
+            progress->epoch = saved->epoch;
+            progress->sample = saved->sample;
+            progress->samplesTrained = saved->samplesTrained;
+            progress->bestError = saved->bestError;
+            progress->epochsWithoutImprovement = saved->epochsWithoutImprovement;
+            progress->randomState.assign(data+saved->randomStateOffset, saved->randomStateSize);
+            progress->bestModelFile.assign(data+saved->bestModelFileOffset, saved->bestModelFileSize);
+            progress->numEpochs = saved->numEpochs;
+            progress->patience = saved->patience;
+            progress->batchSize = saved->batchSize;
+            progress->validationFraction = saved->validationFraction;
+        }
+    }
+    return true;
+}
+
+bool saveQuantizedModelFile(const QuantizedModel &model, const OptimizerSettings &settings,
+                            const std::string &fileName) {
+    const std::vector<QuantizedModel::Layer>& layers = model.getLayers();
+
+    // the same layout as a network's file with the scales of every layer where the delta weights would be
+    ModelFileHeader header = {};
+    std::memcpy(header.magic, modelFileMagic, sizeof(modelFileMagic));
+    header.version = modelFileVersion;
+    header.numLayers = (uint32_t)layers.size();
+    header.scalarSize = sizeof(int8_t);
+    header.flags = MODEL_FILE_QUANTIZED;
+    header.learningRate = settings.learningRate;
+    header.alpha = settings.momentum;
+
+    std::vector<ModelFileLayer> table(layers.size());
+    uint64_t offset = sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*layers.size();
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        table[layer] = ModelFileLayer{(uint32_t)layers[layer].numNeurons, (uint32_t)layers[layer].numInputs,
+                                      (uint32_t)layers[layer].activation, 0, layers[layer].bias, 0, 0};
+        if (!layers[layer].weights) continue;
+        table[layer].weightsOffset = offset = align(offset);
+        offset += layers[layer].numNeurons*layers[layer].numInputs;
+        table[layer].deltaWeightsOffset = offset = align(offset);
+        offset += (layers[layer].numNeurons+1)*sizeof(float);
+    }
+    header.fileSize = offset;
+
+    std::fstream file;
+    file.open(fileName, std::fstream::out | std::fstream::binary);
+    if (!file)
+        return false;
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)table.data(), sizeof(ModelFileLayer)*table.size());
+    uint64_t position = sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*table.size();
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        if (!table[layer].weightsOffset) continue;
+        uint64_t weightsSize = layers[layer].numNeurons*layers[layer].numInputs;
+        uint64_t scalesSize = (layers[layer].numNeurons+1)*sizeof(float);
+        padTo(file, position, table[layer].weightsOffset);
+        file.write((const char*)layers[layer].weights, weightsSize);
+        position += weightsSize;
+        padTo(file, position, table[layer].deltaWeightsOffset);
+        file.write((const char*)layers[layer].scales, scalesSize);
+        position += scalesSize;
+    }
+    file.close();
+    return !file.fail();
+}
+
+std::shared_ptr<const QuantizedModel> loadQuantizedModelFile(const std::string &fileName) {
+    size_t size = 0;
+    std::shared_ptr<const void> mapping = mapFile(fileName, size);
+    if (!mapping || !validModelFile(fileName, (const char*)mapping.get(), size, MODEL_FILE_QUANTIZED))
+        return nullptr;
+
+    // point the layers of the model straight at the weights and scales in the mapping
+    const char* data = (const char*)mapping.get();
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    const ModelFileLayer* table = (const ModelFileLayer*)(data+sizeof(ModelFileHeader));
+    std::vector<QuantizedModel::Layer> layers;
+    for (uint32_t layer = 0; layer<header->numLayers; layer++)
+        layers.push_back(QuantizedModel::Layer{
+                table[layer].numNeurons, table[layer].numInputs,
+                layer == 0 ? nullptr : (const int8_t*)(data+table[layer].weightsOffset),
+                layer == 0 ? nullptr : (const float*)(data+table[layer].deltaWeightsOffset), table[layer].bias,
+                (Activation)table[layer].activation});
+    return std::make_shared<const QuantizedModel>(std::move(layers), std::move(mapping));
+}
+
+bool saveSparseModelFile(const SparseModel &model, const OptimizerSettings &settings, const std::string &fileName) {
+    const std::vector<SparseModel::Layer>& layers = model.getLayers();
+
+    // the same layout as a quantized model's file with the rows of every layer where the scales would be
+    ModelFileHeader header = {};
+    std::memcpy(header.magic, modelFileMagic, sizeof(modelFileMagic));
+    header.version = modelFileVersion;
+    header.numLayers = (uint32_t)layers.size();
+    header.scalarSize = sizeof(double);
+    header.flags = MODEL_FILE_SPARSE;
+    header.learningRate = settings.learningRate;
+    header.alpha = settings.momentum;
+
+    std::vector<ModelFileLayer> table(layers.size());
+    uint64_t offset = sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*layers.size();
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        table[layer] = ModelFileLayer{(uint32_t)layers[layer].numNeurons, (uint32_t)layers[layer].numInputs,
+                                      (uint32_t)layers[layer].activation, (uint32_t)layers[layer].numWeights,
+                                      layers[layer].bias, 0, 0};
+        if (!layers[layer].rowStarts) continue;
+        table[layer].weightsOffset = offset = align(offset);
+        offset += layers[layer].numWeights*sizeof(double);
+        table[layer].deltaWeightsOffset = offset = align(offset);
+        offset += (layers[layer].numNeurons+1+layers[layer].numWeights)*sizeof(uint32_t);
+    }
+    header.fileSize = offset;
+
+    std::fstream file;
+    file.open(fileName, std::fstream::out | std::fstream::binary);
+    if (!file)
+        return false;
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)table.data(), sizeof(ModelFileLayer)*table.size());
+    uint64_t position = sizeof(ModelFileHeader)+sizeof(ModelFileLayer)*table.size();
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        if (!table[layer].weightsOffset) continue;
+        uint64_t valuesSize = layers[layer].numWeights*sizeof(double);
+        uint64_t rowStartsSize = (layers[layer].numNeurons+1)*sizeof(uint32_t);
+        uint64_t columnsSize = layers[layer].numWeights*sizeof(uint32_t);
+        padTo(file, position, table[layer].weightsOffset);
+        file.write((const char*)layers[layer].values, valuesSize);
+        position += valuesSize;
+        padTo(file, position, table[layer].deltaWeightsOffset);
+        file.write((const char*)layers[layer].rowStarts, rowStartsSize);
+        file.write((const char*)layers[layer].columns, columnsSize);
+        position += rowStartsSize+columnsSize;
+    }
+    file.close();
+    return !file.fail();
+}
+
+std::shared_ptr<const SparseModel> loadSparseModelFile(const std::string &fileName) {
+    size_t size = 0;
+    std::shared_ptr<const void> mapping = mapFile(fileName, size);
+    if (!mapping || !validModelFile(fileName, (const char*)mapping.get(), size, MODEL_FILE_SPARSE))
+        return nullptr;
+
+    // point the layers of the model straight at the rows in the mapping
+    const char* data = (const char*)mapping.get();
+    const ModelFileHeader* header = (const ModelFileHeader*)data;
+    const ModelFileLayer* table = (const ModelFileLayer*)(data+sizeof(ModelFileHeader));
+    std::vector<SparseModel::Layer> layers;
+    for (uint32_t layer = 0; layer<header->numLayers; layer++){
+        const uint32_t* rowStarts = layer == 0 ? nullptr : (const uint32_t*)(data+table[layer].deltaWeightsOffset);
+        layers.push_back(SparseModel::Layer{
+                table[layer].numNeurons, table[layer].numInputs, table[layer].numWeights,
+                layer == 0 ? nullptr : (const double*)(data+table[layer].weightsOffset),
+                layer == 0 ? nullptr : rowStarts+table[layer].numNeurons+1, rowStarts, table[layer].bias,
+                (Activation)table[layer].activation});
+    }
+    return std::make_shared<const SparseModel>(std::move(layers), std::move(mapping));
+}
+
+// every precision of network can be saved, and any file loaded into every precision of network or model
+template bool saveModelFile(const BasicNeuralNetwork<double>&, const std::string&, bool, const TrainingProgress*);
+template bool saveModelFile(const BasicNeuralNetwork<float>&, const std::string&, bool, const TrainingProgress*);
+template bool saveModelFile(const BasicNeuralNetwork<float, double>&, const std::string&, bool,
+                            const TrainingProgress*);
+template std::shared_ptr<const BasicModel<double>> loadModelFile<double, double>(const std::string&);
+template std::shared_ptr<const BasicModel<float>> loadModelFile<float, float>(const std::string&);
+template std::shared_ptr<const BasicModel<float, double>> loadModelFile<float, double>(const std::string&);
+template bool loadNetworkFile(const std::string&, BasicNeuralNetwork<double>&, TrainingProgress*);
+template bool loadNetworkFile(const std::string&, BasicNeuralNetwork<float>&, TrainingProgress*);
+template bool loadNetworkFile(const std::string&, BasicNeuralNetwork<float, double>&, TrainingProgress*);
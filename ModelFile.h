@@ -0,0 +1,166 @@
+
+#ifndef NEURALNETWORK_MODELFILE_H
+#define NEURALNETWORK_MODELFILE_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <memory>
+#include "NeuralNetwork.h"
+#include "Model.h"
+#include "QuantizedModel.h"
+#include "SparseModel.h"
+
+/**********************************************************
+ * Program	:  Model File
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A compact binary file for saving networks. The file starts with a header and a table of the layers
+ *                  followed by the weights of every layer stored exactly as they are laid out in memory and aligned to
+ *                  a cache line, so a model can be memory mapped and used straight from the file without reading or
+ *                  copying anything. The weights are stored as float32 or float64, whichever the network was trained
+ *                  in, and are converted when loaded into a model of the other precision. Quantized models store int8
+ *                  weights followed by float32 scales. Sparse models store the float64 weights each layer kept
+ *                  followed by where every row starts and the column of every weight, and the number of weights
+ *                  kept by each layer in its entry of the layer table. Saving the training state adds the optimizer
+ *                  and its running averages so training can carry on exactly. All values are stored little endian as
+ *                  the machines running the models are
+ ***********************************************************/
+
+// the header at the start of every model file
+struct ModelFileHeader {
+    // "NNMODEL" followed by a zero
+    char magic[8];
+    // the version of the format the file was written with
+    uint32_t version;
+    // the number of layers including the input layer
+    uint32_t numLayers;
+    // the size in bytes of every stored weight, 1 for int8, 4 for float32 and 8 for float64
+    uint32_t scalarSize;
+    // combination of the ModelFileFlags
+    uint32_t flags;
+    // the error rates of the network and the training settings it was trained with
+    double errorRate, averageError, averageSmoothingFactor, learningRate, alpha;
+    // the total size of the file used to check it was not cut short
+    uint64_t fileSize;
+};
+
+// an entry of the layer table which comes straight after the header
+struct ModelFileLayer {
+    // the number of neurons in the layer not counting the bias and the number of inputs into each
+    uint32_t numNeurons, numInputs;
+    // the activation function of the layer
+    uint32_t activation;
+    // the number of weights a layer of a sparse model kept, zero in any other model
+    uint32_t numWeights;
+    // the value of the layer's bias neuron
+    double bias;
+    // where in the file the weights and delta weights of the layer start, zero if the layer has none. In a quantized
+    // model the second block holds the layer's input scale followed by the scale of every neuron's weights instead,
+    // in a sparse model it holds the start of every row followed by the column of every weight as uint32
+    uint64_t weightsOffset, deltaWeightsOffset;
+};
+
+// the optimizer of a network saved with its training state, stored straight after the layer table
+struct ModelFileOptimizer {
+    // the OptimizerType and LearningRateSchedule
+    uint32_t type, schedule;
+    double learningRate, momentum, beta1, beta2, epsilon, weightDecay, decayRate;
+    uint64_t decaySteps, warmupSteps;
+    // the number of steps the optimizer has taken
+    uint64_t step;
+};
+
+// an entry for every layer following the optimizer, where in the file the running averages of the layer's gradients
+// and squared gradients start, zero if the optimizer has not needed them
+struct ModelFileOptimizerLayer {
+    uint64_t momentsOffset, squaresOffset;
+};
+
+// how far a training run had got when it was saved, stored after the optimizer tables of a checkpoint
+struct ModelFileProgress {
+    uint64_t epoch, sample, samplesTrained;
+    // the lowest validation error of a pass so far and the passes since it was reached
+    double bestError;
+    uint64_t epochsWithoutImprovement;
+    // where the state of the random engine of the run is stored as text and its length, zero if it has none
+    uint64_t randomStateOffset, randomStateSize;
+    // where the path of the model file holding the best network of the run is stored and its length, zero if it has
+    // not saved one
+    uint64_t bestModelFileOffset, bestModelFileSize;
+    // the settings the run was started with
+    uint64_t numEpochs, patience, batchSize;
+    double validationFraction;
+};
+
+// how far a training run has got through its data, saved with the network so the run can carry on from the sample
+// after the last one it trained on
+struct TrainingProgress {
+    // the pass over the data and the first sample of it not trained on yet
+    uint64_t epoch = 0, sample = 0;
+    // the samples trained on over every pass so far
+    uint64_t samplesTrained = 0;
+    // the lowest error on the held back samples after any pass so far, infinite before the first, and the number of
+    // passes since that one which is used to stop training early
+    double bestError = std::numeric_limits<double>::infinity();
+    uint64_t epochsWithoutImprovement = 0;
+    // the state of the random engine of the run as written by its << operator
+    std::string randomState;
+    // the model file the run saved its best network to, empty until a pass improves on the ones before it
+    std::string bestModelFile;
+    // the settings the run was started with, kept with it so a resumed run makes the same passes over the same
+    // batches and holds back the same samples
+    uint64_t numEpochs = 1, patience = 0, batchSize = 1;
+    double validationFraction = 0;
+};
+
+// flags stored in the header
+enum ModelFileFlags : uint32_t {
+    // the delta weights needed to keep training the network are stored after the weights
+    MODEL_FILE_TRAINING_STATE = 1,
+    // the weights are quantized to int8 and the scales of every layer are stored after its weights
+    MODEL_FILE_QUANTIZED = 2,
+    // the optimizer and its state are stored after the layer table, always set along with the training state
+    MODEL_FILE_OPTIMIZER_STATE = 4,
+    // the progress of the training run is stored after the optimizer, only set along with the optimizer state
+    MODEL_FILE_PROGRESS = 8,
+    // only the weights kept by pruning are stored, as compressed sparse rows
+    MODEL_FILE_SPARSE = 16
+};
+
+// the current version of the format and the alignment of every block of weights
+constexpr uint32_t modelFileVersion = 1;
+constexpr uint64_t modelFileAlignment = 64;
+
+// save the network to a binary model file, the delta weights and the state of the optimizer are only saved when asked
+// for so the network can be trained further after loading it, along with the progress of the run when given. Returns
+// false if the file could not be written
+template<typename Scalar, typename Accumulator>
+bool saveModelFile(const BasicNeuralNetwork<Scalar, Accumulator>& network, const std::string& fileName,
+                   bool includeTrainingState = false, const TrainingProgress* progress = nullptr);
+// memory map a model file and use its weights in place, weights stored in another precision are converted into a copy
+// owned by the model, returns nullptr if the file is missing or invalid
+template<typename Scalar = double, typename Accumulator = Scalar>
+std::shared_ptr<const BasicModel<Scalar, Accumulator>> loadModelFile(const std::string& fileName);
+// read a model file back into a network that can be trained and the progress of its run if it has one, returns false
+// if the file is missing or invalid
+template<typename Scalar, typename Accumulator>
+bool loadNetworkFile(const std::string& fileName, BasicNeuralNetwork<Scalar, Accumulator>& network,
+                     TrainingProgress* progress = nullptr);
+
+// save a quantized model to a model file along with the learning rate and momentum of the network it was made from,
+// returns false if the file could not be written
+bool saveQuantizedModelFile(const QuantizedModel& model, const OptimizerSettings& settings,
+                            const std::string& fileName);
+// memory map a quantized model file and use its weights and scales in place, returns nullptr if the file is missing,
+// invalid or not quantized
+std::shared_ptr<const QuantizedModel> loadQuantizedModelFile(const std::string& fileName);
+
+// save a sparse model to a model file along with the learning rate and momentum of the network it was pruned from,
+// returns false if the file could not be written
+bool saveSparseModelFile(const SparseModel& model, const OptimizerSettings& settings, const std::string& fileName);
+// memory map a sparse model file and use its rows in place, returns nullptr if the file is missing, invalid or not
+// sparse
+std::shared_ptr<const SparseModel> loadSparseModelFile(const std::string& fileName);
+
+#endif //NEURALNETWORK_MODELFILE_H
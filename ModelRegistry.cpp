@@ -0,0 +1,151 @@
+
+#include "ModelRegistry.h"
+#include <fstream>
+#include <iostream>
+#include <json/json.h>
+#include <sys/stat.h>
+#include "ModelFile.h"
+
+ModelRegistry::ModelRegistry(size_t memoryLimit, double checkInterval) : memoryLimit(memoryLimit),
+                                                                        checkInterval(checkInterval) {
+    if (checkInterval>0)
+        watcher = std::thread(&ModelRegistry::watchLoop, this);
+}
+
+ModelRegistry::~ModelRegistry() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopped.notify_all();
+    if (watcher.joinable())
+        watcher.join();
+}
+
+bool ModelRegistry::fileVersion(const std::string &fileName, FileVersion &version) {
+    struct stat status = {};
+    if (stat(fileName.c_str(), &status) != 0)
+        return false;
+    version.modified = (int64_t)status.st_mtim.tv_sec*1000000000+status.st_mtim.tv_nsec;
+    version.size = (uint64_t)status.st_size;
+    return true;
+}
+
+std::shared_ptr<const Model> ModelRegistry::loadModel(const std::string &fileName, size_t &bytes) {
+    // binary models are read into a network rather than mapped, a mapping would change under the running model if
+    // the file was written again in place
+    NeuralNetwork network(std::vector<int>{});
+    if (fileName.size()>=4 && fileName.compare(fileName.size()-4, 4, ".net") == 0){
+        std::ifstream file(fileName);
+        Json::Value json;
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        if (!file || !Json::parseFromStream(builder, file, &json, &errors) || !json.isObject() ||
+            !json["Layers"].isArray())
+            return nullptr;
+        network = NeuralNetwork(json);
+    }
+    else if (!loadNetworkFile(fileName, network))
+        return nullptr;
+    if (network.getPackedLayers().size()<2)
+        return nullptr;
+
+    std::shared_ptr<const Model> model = std::make_shared<const Model>(network);
+    bytes = 0;
+    for (const Model::Layer& layer:model->getLayers())
+        bytes += layer.numNeurons*layer.numInputs*sizeof(double);
+    return model;
+}
+
+std::shared_ptr<const Model> ModelRegistry::get(const std::string &fileName) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<std::string, Entry>::iterator found = entries.find(fileName);
+        if (found != entries.end()){
+            recent.splice(recent.begin(), recent, found->second.position);
+            statistics.hits++;
+            return found->second.model;
+        }
+    }
+
+    // the model is loaded without holding the lock so callers of other models never wait on it, the version is read
+    // first so a change made while loading is still seen by the next check
+    FileVersion version;
+    size_t bytes = 0;
+    std::shared_ptr<const Model> model;
+    if (!fileVersion(fileName, version) || !(model = loadModel(fileName, bytes))){
+        std::cerr<<fileName<<": could not be loaded"<<std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    statistics.misses++;
+    // another caller may have loaded it at the same time
+    std::unordered_map<std::string, Entry>::iterator found = entries.find(fileName);
+    if (found != entries.end()){
+        recent.splice(recent.begin(), recent, found->second.position);
+        return found->second.model;
+    }
+    recent.push_front(fileName);
+    entries[fileName] = Entry{model, bytes, version, recent.begin()};
+    statistics.bytes += bytes;
+    evict();
+    return model;
+}
+
+void ModelRegistry::evict() {
+    while (statistics.bytes>memoryLimit && entries.size()>1){
+        std::unordered_map<std::string, Entry>::iterator oldest = entries.find(recent.back());
+        statistics.bytes -= oldest->second.bytes;
+        entries.erase(oldest);
+        recent.pop_back();
+        statistics.evictions++;
+    }
+}
+
+void ModelRegistry::checkFiles() {
+    std::vector<std::pair<std::string, FileVersion>> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::pair<const std::string, Entry>& entry:entries)
+            cached.emplace_back(entry.first, entry.second.version);
+    }
+    for (const std::pair<std::string, FileVersion>& file:cached){
+        // a file that was deleted keeps being served as it was
+        FileVersion version;
+        if (!fileVersion(file.first, version) || version == file.second)
+            continue;
+        size_t bytes = 0;
+        std::shared_ptr<const Model> model = loadModel(file.first, bytes);
+        if (!model)
+            continue;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<std::string, Entry>::iterator found = entries.find(file.first);
+        if (found == entries.end())
+            continue;
+        // callers running the old version hold their own pointer to it so it is freed once the last of them is done
+        statistics.bytes += bytes;
+        statistics.bytes -= found->second.bytes;
+        found->second.model = std::move(model);
+        found->second.bytes = bytes;
+        found->second.version = version;
+        statistics.reloads++;
+        evict();
+    }
+}
+
+RegistryStatistics ModelRegistry::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    RegistryStatistics current = statistics;
+    current.models = entries.size();
+    return current;
+}
+
+void ModelRegistry::watchLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopped.wait_for(lock, checkInterval, [&]{ return stopping; })){
+        lock.unlock();
+        checkFiles();
+        lock.lock();
+    }
+}
@@ -0,0 +1,97 @@
+
+#ifndef NEURALNETWORK_MODELREGISTRY_H
+#define NEURALNETWORK_MODELREGISTRY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "Model.h"
+
+/**********************************************************
+ * Program	:  Model Registry
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Serves many models by the name of their file, loading each one the first time it is asked for and
+ *                  keeping the ones used most recently in memory up to a limit. A model is handed out as a shared
+ *                  pointer to an immutable Model so any number of threads can run it at once. A background thread
+ *                  watches the files of the cached models and loads a new version when one changes, swapping it in
+ *                  for the next caller while anyone still running the old version keeps it until they let it go.
+ *                  A file that is part way through being written fails to load and is tried again at the next check
+ ***********************************************************/
+
+// how the registry has done since it was made
+struct RegistryStatistics {
+    // the models found in the cache, loaded because they were not and evicted to stay within the memory limit
+    size_t hits = 0, misses = 0, evictions = 0;
+    // the new versions of changed files swapped in
+    size_t reloads = 0;
+    // the models in the cache and the bytes of weights they hold
+    size_t models = 0, bytes = 0;
+};
+
+class ModelRegistry {
+public:
+    // keep up to memoryLimit bytes of weights in the cache and check the files of the cached models for changes every
+    // checkInterval seconds, zero never checks
+    ModelRegistry(size_t memoryLimit, double checkInterval = 1);
+    // stops the thread watching the files
+    ~ModelRegistry();
+    // the watching thread holds a pointer to the registry so it cannot be copied
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    // the model saved in the file, a json network (.net) or a binary model file (anything else), loaded if it is not
+    // in the cache. Returns nullptr if it is missing or invalid
+    std::shared_ptr<const Model> get(const std::string& fileName);
+    // look at the file of every cached model now and swap in the ones that changed, the watching thread calls this
+    // every interval
+    void checkFiles();
+    RegistryStatistics getStatistics() const;
+
+private:
+    // when a file was last changed and its size, any difference means it was written again
+    struct FileVersion {
+        int64_t modified = 0;
+        uint64_t size = 0;
+        bool operator==(const FileVersion& other) const { return modified == other.modified && size == other.size; }
+    };
+    // a cached model and where it is in the order of use
+    struct Entry {
+        std::shared_ptr<const Model> model;
+        size_t bytes;
+        FileVersion version;
+        std::list<std::string>::iterator position;
+    };
+
+    // read the version of a file, returns false if it does not exist
+    static bool fileVersion(const std::string& fileName, FileVersion& version);
+    // load a model into memory owned by the model and set the bytes its weights take up, returns nullptr if it could
+    // not be loaded
+    static std::shared_ptr<const Model> loadModel(const std::string& fileName, size_t& bytes);
+    // drop the least recently used models until the cache fits in the memory limit, the most recent is always kept.
+    // Called with the mutex held
+    void evict();
+    // check the files every interval until the registry is destroyed
+    void watchLoop();
+
+    size_t memoryLimit;
+    std::chrono::duration<double> checkInterval;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    // the names of the cached models from the most recently used to the least
+    std::list<std::string> recent;
+    RegistryStatistics statistics;
+
+    std::condition_variable stopped;
+    bool stopping = false;
+    std::thread watcher;
+};
+
+
+#endif //NEURALNETWORK_MODELREGISTRY_H
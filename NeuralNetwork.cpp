@@ -1,111 +1,539 @@
 
 #include "NeuralNetwork.h"
+#include "Kernels.h"
+#include "Profiler.h"
 
 // constructor for the network given the topology of the network
-NeuralNetwork::NeuralNetwork(const std::vector<int> topology) {
-    // zero the error rate
+template<typename Scalar, typename Accumulator>
+BasicNeuralNetwork<Scalar, Accumulator>::BasicNeuralNetwork(const std::vector<int> topology) {
+    // zero the error rates, the average error is smoothed over roughly the last hundred samples
     this->errorRate = 0;
+    this->averageError = 0;
+    this->averageSmoothingFactor = 100;
     // get the number of layers for the network
     size_t numLayers = topology.size();
+    // the neurons of every layer which are packed into the network once they are all created
+    std::vector<Layer> neuronLayers;
 
     // for every layer to be created
     for (int layerNumber = 0; layerNumber<numLayers; layerNumber++) {
         // create a new layer
-        layers.emplace_back(Layer());
+        neuronLayers.emplace_back(Layer());
 
         // add the number of neurons to the newly created layer ensuring there are no connections forward if it is the
         // last layer
         for (int numNeurons = 0; numNeurons<=topology[layerNumber]; numNeurons++)
-            layers.back().push_back(Neuron(layerNumber == topology.size()-1?0:topology[layerNumber+1], numNeurons));
+            neuronLayers.back().push_back(Neuron(layerNumber == topology.size()-1?0:topology[layerNumber+1], numNeurons));
 
         // forces bias of node the node to 1.0
-        layers.back().back().setOutputVal(1.0);
+        neuronLayers.back().back().setOutputVal(1.0);
     }
 
+    // move the neurons into the contiguous layers
+    packLayers(neuronLayers);
 }
 
 // intialize a neural network from the json file
-NeuralNetwork::NeuralNetwork(Json::Value input) {
+template<typename Scalar, typename Accumulator>
+BasicNeuralNetwork<Scalar, Accumulator>::BasicNeuralNetwork(Json::Value input) {
     // read in the private fields for the network
     this->errorRate = input["Error Rate"].asDouble();
     this->averageError = input["Average Error"].asDouble();
     this->averageSmoothingFactor = input["Average Smoothing Factor"].asDouble();
+    // the neurons of every layer which are packed into the network once they are all read
+    std::vector<Layer> neuronLayers;
 
     // read in each layer for the network in the json data
     for (Json::Value::ArrayIndex layerIndex = 0; layerIndex!=input["Layers"].size(); layerIndex++){
         // make a new layer
-        this->layers.emplace_back(Layer());
+        neuronLayers.emplace_back(Layer());
         // read in the neuron for the layer for each neuron
         for (Json::Value::ArrayIndex neuronIndex = 0; neuronIndex!=input["Layers"][layerIndex].size(); neuronIndex++)
-            this->layers.back().push_back(Neuron(input["Layers"][layerIndex][neuronIndex]));
+            neuronLayers.back().push_back(Neuron(input["Layers"][layerIndex][neuronIndex]));
+    }
+
+    // move the neurons into the contiguous layers
+    packLayers(neuronLayers);
+    // networks saved before there was a choice of optimizer were all trained with momentum
+    const Json::Value& settings = input["Optimizer"];
+    if (settings.isObject()){
+        parseOptimizer(settings["Type"].asString(), optimizer.type);
+        parseSchedule(settings["Schedule"].asString(), optimizer.schedule);
+        optimizer.learningRate = settings.get("Learning Rate", optimizer.learningRate).asDouble();
+        optimizer.momentum = settings.get("Momentum", optimizer.momentum).asDouble();
+        optimizer.beta1 = settings.get("Beta1", optimizer.beta1).asDouble();
+        optimizer.beta2 = settings.get("Beta2", optimizer.beta2).asDouble();
+        optimizer.epsilon = settings.get("Epsilon", optimizer.epsilon).asDouble();
+        optimizer.weightDecay = settings.get("Weight Decay", optimizer.weightDecay).asDouble();
+        optimizer.decayRate = settings.get("Decay Rate", optimizer.decayRate).asDouble();
+        optimizer.decaySteps = settings.get("Decay Steps", (Json::UInt64)optimizer.decaySteps).asUInt64();
+        optimizer.warmupSteps = settings.get("Warmup Steps", (Json::UInt64)optimizer.warmupSteps).asUInt64();
+        optimizerStep = settings.get("Step", 0).asUInt64();
+    }
+    // networks saved before layers had a choice of activation all used tanh
+    const Json::Value& activations = input["Activations"];
+    for (Json::Value::ArrayIndex layerIndex = 1; layerIndex<activations.size() && layerIndex<layers.size(); layerIndex++){
+        Activation activation;
+        if (parseActivation(activations[layerIndex].asString(), activation))
+            setActivation(layerIndex, activation);
+    }
+}
+
+// make a network from layers which are already packed
+template<typename Scalar, typename Accumulator>
+BasicNeuralNetwork<Scalar, Accumulator>::BasicNeuralNetwork(std::vector<PackedLayer> layers, double errorRate,
+                                                            double averageError, double averageSmoothingFactor) :
+        layers(std::move(layers)) {
+    this->errorRate = errorRate;
+    this->averageError = averageError;
+    this->averageSmoothingFactor = averageSmoothingFactor;
+}
+
+// copy the neurons of every layer into the packed layers of the network
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::packLayers(const std::vector<Layer> &neuronLayers) {
+    layers.clear();
+    for (size_t layer = 0; layer<neuronLayers.size(); layer++){
+        const Layer& neurons = neuronLayers[layer];
+        layers.emplace_back(PackedLayer());
+        PackedLayer& packed = layers.back();
+        // every layer has a bias neuron at the end which is not counted as a neuron of the layer
+        packed.numNeurons = neurons.size()-1;
+        packed.numInputs = layer == 0 ? 0 : neuronLayers[layer-1].size();
+        packed.outputs.resize(neurons.size());
+        packed.gradients.resize(neurons.size());
+        for (size_t neuron = 0; neuron<neurons.size(); neuron++){
+            packed.outputs[neuron] = neurons[neuron].outputValue;
+            packed.gradients[neuron] = neurons[neuron].gradient;
+        }
+
+        // the input layer has nothing feeding into it
+        if (layer == 0) continue;
+        // the connections are stored on the neuron they come from so transpose them into one row per neuron they
+        // feed into
+        packed.weights.resize(packed.numNeurons*packed.numInputs);
+        packed.deltaWeights.resize(packed.numNeurons*packed.numInputs);
+        const Layer& previous = neuronLayers[layer-1];
+        for (size_t neuron = 0; neuron<packed.numNeurons; neuron++)
+            for (size_t input = 0; input<packed.numInputs; input++){
+                const Connection& connection = previous[input].outputWeights[neuron];
+                packed.weights[neuron*packed.numInputs+input] = connection.weight;
+                packed.deltaWeights[neuron*packed.numInputs+input] = connection.deltaWeight;
+            }
     }
 }
 
 // calculate the results of the neural network given the input
-void NeuralNetwork::feedForward(const std::vector<double> &inputValues) {
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::feedForward(const std::vector<Scalar> &inputValues) {
     // if the input size does not equal the expected size then return
-    if (inputValues.size() != layers[0].size() - 1) return;
+    if (inputValues.size() != layers[0].numNeurons) return;
+    PROFILE_PHASE(ProfilePhase::FORWARD);
     // set the input layers output values to be the input into the network
-    for (size_t input = 0; input<inputValues.size(); input++)
-        layers[0][input].setOutputVal(inputValues[input]);
-
-    // for every neuron in every layer calculate the feed forward information given the output of the previous neuron
-    // and the weight of the connection
-    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++)
-        for (size_t neuronNumber = 0; neuronNumber<layers[layerNumber].size()-1; neuronNumber++)
-            layers[layerNumber][neuronNumber].feedForward(layers[layerNumber-1]);
+    std::copy(inputValues.begin(), inputValues.end(), layers[0].outputs.begin());
 
+    // for every neuron in every layer sum the outputs of the previous layer multiplied by the neuron's row of weights
+    // and pass the sums through the activation function
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        PackedLayer& layer = layers[layerNumber];
+        const Scalar* previousOutputs = layers[layerNumber-1].outputs.data();
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+            layer.outputs[neuron] = kernels.dot(previousOutputs, layer.weights.data()+neuron*layer.numInputs,
+                                                layer.numInputs);
+        kernels.activate[(size_t)layer.activation](layer.outputs.data(), layer.numNeurons);
+        PROFILE_COUNT(ProfilePhase::FORWARD, layerNumber, 2.0*layer.weights.size(), layer.weights.size()*sizeof(Scalar));
+    }
 }
 
 // back propagate the neural network by giving it the target values to correct the weights of the connections
-void NeuralNetwork::backPropogation(const std::vector<double> &targetValues) {
-    // zero the error rate
-    this->errorRate = 0;
-    // for every neuron in the output layer calculate the error rate using root mean squared of the difference between the
-    // expected value and the given value
-    for (size_t neuron = 0; neuron<layers.back().size()-1; neuron++)
-        errorRate+=pow(targetValues[neuron]-layers.back()[neuron].getOutputVal(), 2);
-    errorRate/=layers.back().size()-1;
-    errorRate = sqrt(errorRate);
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::backPropogation(const std::vector<Scalar> &targetValues) {
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    PackedLayer& outputLayer = layers.back();
+    {
+        PROFILE_PHASE(ProfilePhase::OUTPUT_GRADIENT);
+        // zero the error rate
+        this->errorRate = 0;
+        // for every neuron in the output layer calculate the error rate using root mean squared of the difference
+        // between the expected value and the given value
+        for (size_t neuron = 0; neuron<outputLayer.numNeurons; neuron++){
+            double difference = targetValues[neuron]-(double)outputLayer.outputs[neuron];
+            errorRate+=difference*difference;
+        }
+        errorRate/=outputLayer.numNeurons;
+        errorRate = sqrt(errorRate);
 
-    // calculate running average of error rates for the network to see how well it is performing/learning
-    averageError = (averageError*averageSmoothingFactor+errorRate)/(averageSmoothingFactor+1);
+        // calculate running average of error rates for the network to see how well it is performing/learning
+        averageError = (averageError*averageSmoothingFactor+errorRate)/(averageSmoothingFactor+1);
 
-    // calculate output layer gradient
-    for (size_t neuron = 0; neuron<layers.back().size()-1; neuron++)
-        layers.back()[neuron].calculateOutputGradients(targetValues[neuron]);
+        // calculate output layer gradient
+        for (size_t neuron = 0; neuron<outputLayer.numNeurons; neuron++)
+            outputLayer.gradients[neuron] = (Accumulator)targetValues[neuron]-outputLayer.outputs[neuron];
+        kernels.activationDerivative[(size_t)outputLayer.activation](outputLayer.outputs.data(),
+                                                                     outputLayer.gradients.data(),
+                                                                     outputLayer.numNeurons);
+    }
 
-    // calculate hidden layer gradients
-    for (size_t layer = layers.size()-2; layer>0; layer--)
-        for (size_t neuron = 0; neuron<layers[layer].size(); neuron++)
-            layers[layer][neuron].calculateHiddenGradients(layers[layer+1]);
+    {
+        PROFILE_PHASE(ProfilePhase::HIDDEN_GRADIENT);
+        // calculate hidden layer gradients, walking the rows of the next layer's weights and accumulating each row
+        // scaled by its neuron's gradient so the weights are read in order rather than a column at a time
+        for (size_t layerNumber = layers.size()-2; layerNumber>0; layerNumber--){
+            PackedLayer& layer = layers[layerNumber];
+            const PackedLayer& nextLayer = layers[layerNumber+1];
+            std::fill(layer.gradients.begin(), layer.gradients.end(), 0.0);
+            for (size_t neuron = 0; neuron<nextLayer.numNeurons; neuron++)
+                kernels.axpy(nextLayer.gradients[neuron], nextLayer.weights.data()+neuron*nextLayer.numInputs,
+                             layer.gradients.data(), nextLayer.numInputs);
+            kernels.activationDerivative[(size_t)layer.activation](layer.outputs.data(), layer.gradients.data(),
+                                                                   layer.gradients.size());
+            PROFILE_COUNT(ProfilePhase::HIDDEN_GRADIENT, layerNumber+1, 2.0*nextLayer.weights.size(),
+                          nextLayer.weights.size()*sizeof(Scalar));
+        }
+    }
+
+    // any other optimizer works from the gradients of every weight, which are the batch of one sample
+    if (optimizer.type != OptimizerType::MOMENTUM || optimizer.weightDecay != 0){
+        resizeWorkspace(batchWorkspace, 1);
+        {
+            PROFILE_PHASE(ProfilePhase::WEIGHT_GRADIENT);
+            for (size_t layerNumber = layers.size()-1; layerNumber>0; layerNumber--){
+                const PackedLayer& layer = layers[layerNumber];
+                for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+                    kernels.axpy(layer.gradients[neuron], layers[layerNumber-1].outputs.data(),
+                                 batchWorkspace.weightGradients[layerNumber].data()+neuron*layer.numInputs,
+                                 layer.numInputs);
+                PROFILE_COUNT(ProfilePhase::WEIGHT_GRADIENT, layerNumber, 2.0*layer.weights.size(),
+                              layer.weights.size()*2*sizeof(Accumulator));
+            }
+        }
+        applyGradients(batchWorkspace.weightGradients, 1);
+        PROFILE_PROGRESS(1, averageError);
+        return;
+    }
 
     // for all layers update connection weight using above gradient data
-    for (size_t layer = layers.size()-1; layer>0; layer--)
-        for (size_t neuron = 0; neuron<layers[layer].size()-1; neuron++)
-            layers[layer][neuron].updateInputWeights(layers[layer-1]);
+    PROFILE_PHASE(ProfilePhase::WEIGHT_UPDATE);
+    double learningRate = scheduledLearningRate(optimizer, optimizerStep++);
+    for (size_t layerNumber = layers.size()-1; layerNumber>0; layerNumber--){
+        PackedLayer& layer = layers[layerNumber];
+        const Scalar* previousOutputs = layers[layerNumber-1].outputs.data();
+        // the gradient of every weight in a row is the previous layer's output times the neuron's gradient, so the
+        // previous outputs are passed as the gradients with the neuron's gradient folded into the learning rate
+        // alpha = momentum or the magnitude of change of the last update
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+            kernels.momentumRow(learningRate*layer.gradients[neuron], previousOutputs, optimizer.momentum,
+                                layer.deltaWeights.data()+neuron*layer.numInputs,
+                                layer.weights.data()+neuron*layer.numInputs, layer.numInputs);
+        // every weight reads its delta and itself and writes both back
+        PROFILE_COUNT(ProfilePhase::WEIGHT_UPDATE, layerNumber, 4.0*layer.weights.size(),
+                      layer.weights.size()*4*sizeof(Scalar));
+    }
+    PROFILE_PROGRESS(1, averageError);
+}
+
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::getResults(std::vector<Scalar> &results) {
+    // copy the results of every neuron in the output layer
+    const PackedLayer& outputLayer = layers.back();
+    results.assign(outputLayer.outputs.begin(), outputLayer.outputs.begin()+outputLayer.numNeurons);
+}
+
+// train the network on a single batch of samples
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::trainBatch(const Scalar *inputs, const Scalar *targets,
+                                                         size_t batchSize) {
+    if (batchSize == 0) return;
+    // make sure the workspace can hold the batch and start with no gradients
+    resizeWorkspace(batchWorkspace, batchSize);
+    // sum the gradients of every sample in the batch and then apply them all at once
+    accumulateGradients(inputs, targets, batchSize, batchWorkspace);
+    recordErrors(batchWorkspace.errors.data(), batchSize);
+    applyGradients(batchWorkspace.weightGradients, batchSize);
+    PROFILE_PROGRESS(batchSize, averageError);
+}
+
+// train the network on all the given samples in batches
+template<typename Scalar, typename Accumulator>
+bool BasicNeuralNetwork<Scalar, Accumulator>::trainBatch(const std::vector<std::vector<double>> &inputs,
+                                                         const std::vector<std::vector<double>> &targets,
+                                                         size_t batchSize) {
+    // there must be a target for every input and every sample must match the topology of the network
+    if (inputs.size() != targets.size() || batchSize == 0) return false;
+    size_t numInputs = getNumInputs(), numOutputs = getNumOutputs();
+    for (size_t sample = 0; sample<inputs.size(); sample++)
+        if (inputs[sample].size() != numInputs || targets[sample].size() != numOutputs) return false;
+
+    // copy every batch into contiguous rows and train on it
+    std::vector<Scalar> batchInputs(batchSize*numInputs), batchTargets(batchSize*numOutputs);
+    for (size_t first = 0; first<inputs.size(); first += batchSize){
+        size_t count = std::min(batchSize, inputs.size()-first);
+        for (size_t sample = 0; sample<count; sample++){
+            std::copy(inputs[first+sample].begin(), inputs[first+sample].end(),
+                      batchInputs.begin()+sample*numInputs);
+            std::copy(targets[first+sample].begin(), targets[first+sample].end(),
+                      batchTargets.begin()+sample*numOutputs);
+        }
+        trainBatch(batchInputs.data(), batchTargets.data(), count);
+    }
+    return true;
+}
+
+// size every buffer of the workspace for the batch and zero the weight gradients
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::resizeWorkspace(BatchWorkspace &workspace, size_t batchSize) const {
+    workspace.batchSize = batchSize;
+    workspace.outputs.resize(layers.size());
+    workspace.gradients.resize(layers.size());
+    workspace.weightGradients.resize(layers.size());
+    workspace.errors.resize(batchSize);
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        workspace.outputs[layer].resize(batchSize*layers[layer].outputs.size());
+        workspace.gradients[layer].resize(batchSize*layers[layer].outputs.size());
+        workspace.weightGradients[layer].assign(layers[layer].weights.size(), 0.0);
+    }
+}
+
+// feed forward every sample of a batch as one matrix-matrix product per layer
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::feedForwardBatch(const Scalar *inputs, size_t count,
+                                                               BatchWorkspace &workspace) const {
+    PROFILE_PHASE(ProfilePhase::FORWARD);
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    // copy the inputs into the rows of the input layer followed by the bias neuron
+    size_t inputStride = layers[0].outputs.size();
+    Scalar* inputRows = workspace.outputs[0].data();
+    for (size_t sample = 0; sample<count; sample++){
+        std::copy(inputs+sample*layers[0].numNeurons, inputs+(sample+1)*layers[0].numNeurons,
+                  inputRows+sample*inputStride);
+        inputRows[sample*inputStride+layers[0].numNeurons] = layers[0].outputs.back();
+    }
+
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const PackedLayer& layer = layers[layerNumber];
+        const Scalar* previousRows = workspace.outputs[layerNumber-1].data();
+        Scalar* rows = workspace.outputs[layerNumber].data();
+        size_t stride = layer.outputs.size();
+        // take the neurons a tile at a time so their weights stay in the cache while every sample is streamed past them
+        size_t tile = std::max<size_t>(1, tileSize/layer.numInputs);
+        for (size_t firstNeuron = 0; firstNeuron<layer.numNeurons; firstNeuron += tile){
+            size_t lastNeuron = std::min(firstNeuron+tile, layer.numNeurons);
+            for (size_t sample = 0; sample<count; sample++){
+                const Scalar* previousOutputs = previousRows+sample*layer.numInputs;
+                for (size_t neuron = firstNeuron; neuron<lastNeuron; neuron++)
+                    rows[sample*stride+neuron] = kernels.dot(previousOutputs,
+                                                             layer.weights.data()+neuron*layer.numInputs,
+                                                             layer.numInputs);
+            }
+        }
+        // pass every row through the activation function and end it with the layer's bias neuron
+        auto activate = kernels.activate[(size_t)layer.activation];
+        for (size_t sample = 0; sample<count; sample++){
+            activate(rows+sample*stride, layer.numNeurons);
+            rows[sample*stride+layer.numNeurons] = layer.outputs.back();
+        }
+        // the weights are read once per tile of the batch and the rows of the samples go in and out
+        PROFILE_COUNT(ProfilePhase::FORWARD, layerNumber, 2.0*count*layer.weights.size(),
+                      (layer.weights.size()+count*(layer.numInputs+stride))*sizeof(Scalar));
+    }
+}
+
+// feed forward and back propagate a batch summing the gradients of the weights over every sample
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::accumulateGradients(const Scalar *inputs, const Scalar *targets,
+                                                                  size_t count, BatchWorkspace &workspace) const {
+    const BasicKernelTable<Scalar, Accumulator>& kernels = getKernels<Scalar, Accumulator>();
+    feedForwardBatch(inputs, count, workspace);
+
+    {
+        PROFILE_PHASE(ProfilePhase::OUTPUT_GRADIENT);
+        // calculate the error and the output layer gradients of every sample
+        const PackedLayer& outputLayer = layers.back();
+        size_t outputStride = outputLayer.outputs.size();
+        for (size_t sample = 0; sample<count; sample++){
+            const Scalar* outputs = workspace.outputs.back().data()+sample*outputStride;
+            Accumulator* gradients = workspace.gradients.back().data()+sample*outputStride;
+            const Scalar* target = targets+sample*outputLayer.numNeurons;
+            double error = 0;
+            for (size_t neuron = 0; neuron<outputLayer.numNeurons; neuron++){
+                gradients[neuron] = (Accumulator)target[neuron]-outputs[neuron];
+                error += gradients[neuron]*gradients[neuron];
+            }
+            kernels.activationDerivative[(size_t)outputLayer.activation](outputs, gradients, outputLayer.numNeurons);
+            workspace.errors[sample] = sqrt(error/outputLayer.numNeurons);
+        }
+    }
+
+    {
+        PROFILE_PHASE(ProfilePhase::HIDDEN_GRADIENT);
+        // calculate the hidden layer gradients, each row of the next layer's weights is used for every sample before
+        // moving on to the next row
+        for (size_t layerNumber = layers.size()-2; layerNumber>0; layerNumber--){
+            const PackedLayer& nextLayer = layers[layerNumber+1];
+            const Accumulator* nextGradients = workspace.gradients[layerNumber+1].data();
+            const Scalar* outputs = workspace.outputs[layerNumber].data();
+            Accumulator* gradients = workspace.gradients[layerNumber].data();
+            size_t stride = layers[layerNumber].outputs.size(), nextStride = nextLayer.outputs.size();
+            std::fill(gradients, gradients+count*stride, 0.0);
+            for (size_t neuron = 0; neuron<nextLayer.numNeurons; neuron++){
+                const Scalar* row = nextLayer.weights.data()+neuron*nextLayer.numInputs;
+                for (size_t sample = 0; sample<count; sample++)
+                    kernels.axpy(nextGradients[sample*nextStride+neuron], row, gradients+sample*stride,
+                                 nextLayer.numInputs);
+            }
+            kernels.activationDerivative[(size_t)layers[layerNumber].activation](outputs, gradients, count*stride);
+            PROFILE_COUNT(ProfilePhase::HIDDEN_GRADIENT, layerNumber+1, 2.0*count*nextLayer.weights.size(),
+                          nextLayer.weights.size()*sizeof(Scalar)+count*(stride+nextStride)*sizeof(Accumulator));
+        }
+    }
+
+    PROFILE_PHASE(ProfilePhase::WEIGHT_GRADIENT);
+    // sum the gradient of every weight over the batch, one row of weights at a time
+    for (size_t layerNumber = layers.size()-1; layerNumber>0; layerNumber--){
+        const PackedLayer& layer = layers[layerNumber];
+        const Scalar* previousRows = workspace.outputs[layerNumber-1].data();
+        const Accumulator* gradients = workspace.gradients[layerNumber].data();
+        size_t stride = layer.outputs.size();
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+            Accumulator* weightGradients = workspace.weightGradients[layerNumber].data()+neuron*layer.numInputs;
+            for (size_t sample = 0; sample<count; sample++)
+                kernels.axpy(gradients[sample*stride+neuron], previousRows+sample*layer.numInputs, weightGradients,
+                             layer.numInputs);
+        }
+        PROFILE_COUNT(ProfilePhase::WEIGHT_GRADIENT, layerNumber, 2.0*count*layer.weights.size(),
+                      layer.weights.size()*2*sizeof(Accumulator)+count*layer.numInputs*sizeof(Scalar));
+    }
+}
+
+// update every weight using the average gradient of the batch with one fused pass of the optimizer over every layer
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::applyGradients(
+        const std::vector<std::vector<Accumulator>> &weightGradients, size_t batchSize) {
+    PROFILE_PHASE(ProfilePhase::WEIGHT_UPDATE);
+    OptimizerStep<Accumulator> step = makeOptimizerStep<Accumulator>(optimizer, optimizerStep++, batchSize);
+    auto update = getKernels<Scalar, Accumulator>().optimizerUpdate[(size_t)optimizer.type];
+    bool adam = optimizer.type == OptimizerType::ADAM;
+    bool averagesSquares = adam || optimizer.type == OptimizerType::RMSPROP;
+    for (size_t layerNumber = layers.size()-1; layerNumber>0; layerNumber--){
+        PackedLayer& layer = layers[layerNumber];
+        // the running averages start at zero the first time they are needed
+        if (adam && layer.moments.size() != layer.weights.size())
+            layer.moments.assign(layer.weights.size(), 0.0);
+        if (averagesSquares && layer.squares.size() != layer.weights.size())
+            layer.squares.assign(layer.weights.size(), 0.0);
+        // momentum and nesterov carry on from the last change to every weight
+        update(step, weightGradients[layerNumber].data(), adam ? layer.moments.data() : layer.deltaWeights.data(),
+               layer.squares.data(), layer.weights.data(), layer.weights.size());
+        // the weights, their gradients and the one or two averages of the optimizer are read and written once
+        PROFILE_COUNT(ProfilePhase::WEIGHT_UPDATE, layerNumber, (averagesSquares ? 10.0 : 4.0)*layer.weights.size(),
+                      layer.weights.size()*(sizeof(Accumulator)+(adam ? 6 : 4)*sizeof(Scalar)));
+    }
+}
+
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::setOptimizer(const OptimizerSettings &settings) {
+    optimizer = settings;
+}
+
+template<typename Scalar, typename Accumulator>
+const OptimizerSettings &BasicNeuralNetwork<Scalar, Accumulator>::getOptimizer() const {
+    return optimizer;
+}
+
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::setOptimizerStep(uint64_t step) {
+    optimizerStep = step;
+}
+
+template<typename Scalar, typename Accumulator>
+uint64_t BasicNeuralNetwork<Scalar, Accumulator>::getOptimizerStep() const {
+    return optimizerStep;
 }
 
-void NeuralNetwork::getResults(std::vector<double> &results) {
-    // clear the results vector
-    results.clear();
-    // get the results of every neuron in the output layer
-    for (unsigned n = 0; n < layers.back().size() - 1; ++n) {
-        results.push_back(layers.back()[n].getOutputVal());
+// record the errors of a batch, the error rate becomes the mean error of the batch while the running average is
+// updated sample by sample so it means the same thing as when training one sample at a time
+template<typename Scalar, typename Accumulator>
+void BasicNeuralNetwork<Scalar, Accumulator>::recordErrors(const double *errors, size_t count) {
+    errorRate = 0;
+    for (size_t sample = 0; sample<count; sample++){
+        errorRate += errors[sample];
+        averageError = (averageError*averageSmoothingFactor+errors[sample])/(averageSmoothingFactor+1);
     }
+    errorRate /= count;
+}
+
+// the number of neurons in the input and output layers
+template<typename Scalar, typename Accumulator>
+size_t BasicNeuralNetwork<Scalar, Accumulator>::getNumInputs() const {
+    return layers.front().numNeurons;
+}
+
+template<typename Scalar, typename Accumulator>
+size_t BasicNeuralNetwork<Scalar, Accumulator>::getNumOutputs() const {
+    return layers.back().numNeurons;
+}
+
+template<typename Scalar, typename Accumulator>
+const std::vector<typename BasicNeuralNetwork<Scalar, Accumulator>::PackedLayer> &
+BasicNeuralNetwork<Scalar, Accumulator>::getPackedLayers() const {
+    return layers;
+}
+
+template<typename Scalar, typename Accumulator>
+bool BasicNeuralNetwork<Scalar, Accumulator>::setActivation(size_t layer, Activation activation) {
+    // softmax sums over the whole layer so it only makes sense for the outputs
+    if (layer == 0 || layer>=layers.size() || (size_t)activation>=numActivations ||
+        (activation == Activation::SOFTMAX && layer+1 != layers.size()))
+        return false;
+    layers[layer].activation = activation;
+    return true;
 }
 
 // getters for the error rates of the network
-double NeuralNetwork::getErrorRate() const {
+template<typename Scalar, typename Accumulator>
+double BasicNeuralNetwork<Scalar, Accumulator>::getErrorRate() const {
     return errorRate;
 }
 
-double NeuralNetwork::getAverageError() const {
+template<typename Scalar, typename Accumulator>
+double BasicNeuralNetwork<Scalar, Accumulator>::getAverageError() const {
     return averageError;
 }
 
+template<typename Scalar, typename Accumulator>
+double BasicNeuralNetwork<Scalar, Accumulator>::getAverageSmoothingFactor() const {
+    return averageSmoothingFactor;
+}
+
+// rebuild the neurons of every layer from the packed layers
+template<typename Scalar, typename Accumulator>
+std::vector<Layer> BasicNeuralNetwork<Scalar, Accumulator>::getLayers() const {
+    std::vector<Layer> neuronLayers;
+    for (size_t layer = 0; layer<layers.size(); layer++){
+        const PackedLayer& packed = layers[layer];
+        // the next layer holds the weights of the connections leaving this layer
+        const PackedLayer* next = layer+1<layers.size() ? &layers[layer+1] : nullptr;
+        neuronLayers.emplace_back(Layer());
+        for (size_t neuron = 0; neuron<packed.outputs.size(); neuron++){
+            neuronLayers.back().push_back(Neuron(0, (int)neuron));
+            Neuron& unpacked = neuronLayers.back().back();
+            unpacked.outputValue = packed.outputs[neuron];
+            unpacked.gradient = packed.gradients[neuron];
+            if (!next) continue;
+            for (size_t connection = 0; connection<next->numNeurons; connection++){
+                unpacked.outputWeights.emplace_back(Connection());
+                unpacked.outputWeights.back().weight = next->weights[connection*next->numInputs+neuron];
+                unpacked.outputWeights.back().deltaWeight = next->deltaWeights[connection*next->numInputs+neuron];
+            }
+        }
+    }
+    return neuronLayers;
+}
+
 // convert the network to json
-Json::Value NeuralNetwork::toJson() {
+template<typename Scalar, typename Accumulator>
+Json::Value BasicNeuralNetwork<Scalar, Accumulator>::toJson() {
     Json::Value ret;
     // set all the private fields of the network to be reused when read back in
     ret["Error Rate"] = this->errorRate;
@@ -115,19 +543,45 @@ Json::Value NeuralNetwork::toJson() {
     // create the arrays for the neurons and the layers
     Json::Value neuronsInLayer(Json::arrayValue);
     Json::Value jsonLayer(Json::arrayValue);
+    // unpack the network into its neurons which know how to convert themselves to json
+    std::vector<Layer> neuronLayers = getLayers();
 
     // for every layer in the network
-    for (size_t layer = 0; layer<layers.size(); layer++){
+    for (size_t layer = 0; layer<neuronLayers.size(); layer++){
         // clear the neuron container
         neuronsInLayer.clear();
         // populate the neuron container with the neurons in the layer
-        for (size_t neuron = 0; neuron<layers[layer].size(); neuron++)
-            neuronsInLayer.append(layers[layer][neuron].toJSON());
+        for (size_t neuron = 0; neuron<neuronLayers[layer].size(); neuron++)
+            neuronsInLayer.append(neuronLayers[layer][neuron].toJSON());
         // add the layer to the layer vector
         jsonLayer.append(neuronsInLayer);
     }
-    // store the layers
+    // store the layers and the activation function of each
     ret["Layers"] = jsonLayer;
+    Json::Value activations(Json::arrayValue);
+    for (const PackedLayer& layer:layers)
+        activations.append(activationName(layer.activation));
+    ret["Activations"] = activations;
+    // the optimizer and how far it has got, its running averages are only kept in model files
+    Json::Value settings;
+    settings["Type"] = optimizerName(optimizer.type);
+    settings["Learning Rate"] = optimizer.learningRate;
+    settings["Momentum"] = optimizer.momentum;
+    settings["Beta1"] = optimizer.beta1;
+    settings["Beta2"] = optimizer.beta2;
+    settings["Epsilon"] = optimizer.epsilon;
+    settings["Weight Decay"] = optimizer.weightDecay;
+    settings["Schedule"] = scheduleName(optimizer.schedule);
+    settings["Decay Rate"] = optimizer.decayRate;
+    settings["Decay Steps"] = (Json::UInt64)optimizer.decaySteps;
+    settings["Warmup Steps"] = (Json::UInt64)optimizer.warmupSteps;
+    settings["Step"] = (Json::UInt64)optimizerStep;
+    ret["Optimizer"] = settings;
     // return the network as a JSON object
     return ret;
-}
\ No newline at end of file
+}
+
+// the precisions the network is built for
+template class BasicNeuralNetwork<double>;
+template class BasicNeuralNetwork<float>;
+template class BasicNeuralNetwork<float, double>;
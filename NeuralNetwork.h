@@ -4,8 +4,11 @@
 #define BEGINNING_NEURALNETWORK_H
 
 #include <json/value.h>
+#include <algorithm>
 #include <ctgmath>
 #include <vector>
+#include "Activation.h"
+#include "Optimizer.h"
 #include "Neuron.h"
 
 /**********************************************************
@@ -18,31 +21,154 @@
 
 typedef std::vector<Neuron> Layer;
 
-class NeuralNetwork {
+// a single layer of the network packed into contiguous memory so the feed forward and back propagation loops stream
+// over flat arrays instead of chasing a pointer into every neuron's connections. The weights and outputs are stored
+// as Scalar while the gradients, which are sums over many values, are kept as Accumulator
+template<typename Scalar, typename Accumulator = Scalar>
+struct BasicPackedLayer {
+    BasicPackedLayer() = default;
+    // copy a layer of another precision converting all of its values
+    template<typename OtherScalar, typename OtherAccumulator>
+    explicit BasicPackedLayer(const BasicPackedLayer<OtherScalar, OtherAccumulator>& layer) :
+            numNeurons(layer.numNeurons), numInputs(layer.numInputs), activation(layer.activation),
+            weights(layer.weights.begin(), layer.weights.end()),
+            deltaWeights(layer.deltaWeights.begin(), layer.deltaWeights.end()),
+            moments(layer.moments.begin(), layer.moments.end()), squares(layer.squares.begin(), layer.squares.end()),
+            outputs(layer.outputs.begin(), layer.outputs.end()),
+            gradients(layer.gradients.begin(), layer.gradients.end()) {}
+
+    // the number of neurons in the layer not counting the bias neuron and the number of inputs into each of those
+    // neurons which includes the bias neuron of the previous layer
+    size_t numNeurons, numInputs;
+    // the activation function applied to the sums of the layer's neurons, unused by the input layer
+    Activation activation = Activation::TANH;
+    // row major matrix of the weights feeding into the layer, one row of numInputs weights per neuron
+    std::vector<Scalar> weights;
+    // the last change made to every weight used for the momentum, laid out the same way as the weights
+    std::vector<Scalar> deltaWeights;
+    // the running averages of the gradient and squared gradient of every weight kept by Adam and RMSProp, laid out the
+    // same way as the weights and empty until an optimizer needs them
+    std::vector<Scalar> moments, squares;
+    // the output values and gradients of every neuron in the layer with the bias neuron stored last
+    std::vector<Scalar> outputs;
+    std::vector<Accumulator> gradients;
+};
+
+// scratch space used to run a batch of samples through the network, kept apart from the network so that the weights
+// are only read while a batch is propagated
+template<typename Scalar, typename Accumulator = Scalar>
+struct BasicBatchWorkspace {
+    // the number of samples the workspace has room for
+    size_t batchSize = 0;
+    // for every layer the outputs and gradients of every sample, one row per sample with the bias neuron stored last
+    std::vector<std::vector<Scalar>> outputs;
+    std::vector<std::vector<Accumulator>> gradients;
+    // for every layer the gradients of its weights summed over the batch, laid out the same way as the weights
+    std::vector<std::vector<Accumulator>> weightGradients;
+    // the root mean squared error of every sample in the batch
+    std::vector<double> errors;
+};
+
+// a network computing with values of type Scalar and summing them in type Accumulator, built for double precision,
+// single precision and float weights with double sums. Training and inference in floats moves half the bytes
+// through the cache and fits twice as many values in every vector register
+template<typename Scalar, typename Accumulator = Scalar>
+class BasicNeuralNetwork {
 public:
+    typedef BasicPackedLayer<Scalar, Accumulator> PackedLayer;
+    typedef BasicBatchWorkspace<Scalar, Accumulator> BatchWorkspace;
+
     // constructors for the neural network
-    NeuralNetwork(const std::vector<int> topology);
-    NeuralNetwork(Json::Value input);
+    BasicNeuralNetwork(const std::vector<int> topology);
+    BasicNeuralNetwork(Json::Value input);
+    // make a network straight from its packed layers and the error rates it had
+    BasicNeuralNetwork(std::vector<PackedLayer> layers, double errorRate, double averageError,
+                       double averageSmoothingFactor);
+    // copy a network of another precision, converting its weights and training state
+    template<typename OtherScalar, typename OtherAccumulator>
+    explicit BasicNeuralNetwork(const BasicNeuralNetwork<OtherScalar, OtherAccumulator>& network) :
+            layers(network.getPackedLayers().begin(), network.getPackedLayers().end()),
+            errorRate(network.getErrorRate()), averageError(network.getAverageError()),
+            averageSmoothingFactor(network.getAverageSmoothingFactor()), optimizer(network.getOptimizer()),
+            optimizerStep(network.getOptimizerStep()) {}
     // feed forward to calculate the output values of the network given the input values
-    void feedForward(const std::vector<double> &inputValues);
+    void feedForward(const std::vector<Scalar> &inputValues);
     // back propagate the neural network using the given target values to adjust the weights using gradients and
     // the root mean squared as our algorithm
-    void backPropogation(const std::vector<double> &targetValues);
+    void backPropogation(const std::vector<Scalar> &targetValues);
     // get the output values of the neural network
-    void getResults(std::vector<double>& results);
+    void getResults(std::vector<Scalar>& results);
+
+    // train the network on one batch of samples stored one after another in the given arrays, accumulating the
+    // gradients of every sample and updating the weights once for the whole batch
+    void trainBatch(const Scalar* inputs, const Scalar* targets, size_t batchSize);
+    // train the network on every sample given splitting them into batches of the given size, returns false if a sample
+    // does not match the topology of the network
+    bool trainBatch(const std::vector<std::vector<double>>& inputs, const std::vector<std::vector<double>>& targets,
+                    size_t batchSize);
+
+    // size the workspace for the given number of samples and zero its weight gradients
+    void resizeWorkspace(BatchWorkspace& workspace, size_t batchSize) const;
+    // feed forward a batch of inputs through the network storing the outputs of every layer in the workspace
+    void feedForwardBatch(const Scalar* inputs, size_t count, BatchWorkspace& workspace) const;
+    // feed forward and back propagate a batch of samples adding the gradients of the weights to the workspace and
+    // storing the error of every sample
+    void accumulateGradients(const Scalar* inputs, const Scalar* targets, size_t count,
+                             BatchWorkspace& workspace) const;
+    // update the weights using gradients summed over the given number of samples
+    void applyGradients(const std::vector<std::vector<Accumulator>>& weightGradients, size_t batchSize);
+    // the optimizer used to update the weights and the number of updates it has made, which drives the learning rate
+    // schedule and Adam's correction of its averages. Setting it keeps the state of the last optimizer so training
+    // can carry on where it left off
+    void setOptimizer(const OptimizerSettings& settings);
+    const OptimizerSettings& getOptimizer() const;
+    void setOptimizerStep(uint64_t step);
+    uint64_t getOptimizerStep() const;
+    // fold the errors of a batch of samples into the error rates of the network
+    void recordErrors(const double* errors, size_t count);
+
+    // the number of inputs and outputs of the network
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+    // the packed layers of the network for reading its weights directly
+    const std::vector<PackedLayer>& getPackedLayers() const;
+    // set the activation function of a layer, returns false for the input layer or for softmax on any layer but the
+    // output layer
+    bool setActivation(size_t layer, Activation activation);
     // convert the neural network to json
     Json::Value toJson();
+    // unpack the network into its neurons, kept so the network can still be viewed neuron by neuron
+    std::vector<Layer> getLayers() const;
 
     // get the error rates for the network
     double getErrorRate() const;
     double getAverageError() const;
+    double getAverageSmoothingFactor() const;
 
 private:
+    // pack the neurons of every layer into the contiguous layers of the network
+    void packLayers(const std::vector<Layer>& neuronLayers);
+
     // layers of the network
-    std::vector<Layer> layers;
+    std::vector<PackedLayer> layers;
+    // workspace used when training the network in batches
+    BatchWorkspace batchWorkspace;
+    // the number of a layer's weights that are processed together so they stay in the cache (32KiB of them)
+    constexpr static size_t tileSize = 32*1024/sizeof(Scalar);
     // private fields for calculating the error rates of the network
     double errorRate, averageError, averageSmoothingFactor;
+    // the optimizer updating the weights and the number of steps it has taken
+    OptimizerSettings optimizer;
+    uint64_t optimizerStep = 0;
 };
 
+// the network in double precision that everything else is built on
+typedef BasicNeuralNetwork<double> NeuralNetwork;
+typedef BasicPackedLayer<double> PackedLayer;
+typedef BasicBatchWorkspace<double> BatchWorkspace;
+// the network in single precision and with float weights summed in doubles
+typedef BasicNeuralNetwork<float> FloatNeuralNetwork;
+typedef BasicNeuralNetwork<float, double> MixedNeuralNetwork;
+
 
 #endif //BEGINNING_NEURALNETWORK_H
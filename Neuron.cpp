@@ -12,7 +12,7 @@ double Neuron::activationFunction(double sum) {
 // back propagating
 double Neuron::activationFunctionDerivative(double sum) {
     // tanh derivative
-    return 1-(pow(sum, 2));
+    return 1-sum*sum;
 }
 
 // constructor for the neuron
@@ -20,8 +20,8 @@
 
 // structure of the connection between neurons
 struct Connection{
-    // the weight and delta weight of the connection
-    double weight, deltaWeight;
+    // the weight and delta weight of the connection, a new connection has not changed yet
+    double weight = 0, deltaWeight = 0;
 
     // connection constructor passing in the json value to read in the weight and delta weight
     explicit Connection(Json::Value connectionJSON){
@@ -42,8 +42,14 @@ struct Connection{
 };
 
 
+template<typename Scalar, typename Accumulator>
+class BasicNeuralNetwork;
+
 // neuron class
 class Neuron {
+    // the network packs the neurons into contiguous layers so it needs to read and rebuild their private fields
+    template<typename Scalar, typename Accumulator>
+    friend class BasicNeuralNetwork;
 public:
     // define a layer as a vector of neurons
     typedef std::vector<Neuron> Layer;
@@ -68,21 +74,22 @@ public:
     // convert the neuron to JSON
     Json::Value toJSON();
 
+    // learning rate ranges from 0...1
+    // alpha ranges from 0...n
+    constexpr static double learningRate = 0.15, alpha = 0.5;
+
 private:
     // activation functions and the derivative of the activation function, used for calculating the gradients
     static double activationFunction(double sum);
     static double activationFunctionDerivative(double sum);
     // generate a random weight
     static double randomWeight();
-    // learning rate ranges from 0...1
-    // alpha ranges from 0...n
-    constexpr static double learningRate = 0.15, alpha = 0.5;
 
     // get the sum of the derivatives of the weights of the next layer
     double sumOfDerivativeOfNextLayer(const Layer& layer) const;
 
     // the output value and gradient of the current neuron
-    double outputValue, gradient;
+    double outputValue = 0, gradient = 0;
     // the neuron's index in its layer
     int index;
     // a vector of all the connections between the neuron and all the other neurons in the next layer
@@ -0,0 +1,84 @@
+
+#include "Optimizer.h"
+#include <algorithm>
+#include <cmath>
+
+// the names of the optimizers and schedules in the order of their enums
+static const char* const optimizerNames[numOptimizers] = {"momentum", "nesterov", "adam", "rmsprop"};
+static const char* const scheduleNames[numSchedules] = {"constant", "step", "exponential", "cosine"};
+
+double scheduledLearningRate(const OptimizerSettings &settings, uint64_t step) {
+    // ramp up linearly during the warmup and run the schedule from the end of it
+    if (step<settings.warmupSteps)
+        return settings.learningRate*(step+1)/settings.warmupSteps;
+    step -= settings.warmupSteps;
+    double period = (double)std::max<uint64_t>(1, settings.decaySteps);
+    switch (settings.schedule){
+        case LearningRateSchedule::STEP:
+            return settings.learningRate*std::pow(settings.decayRate, std::floor(step/period));
+        case LearningRateSchedule::EXPONENTIAL:
+            return settings.learningRate*std::pow(settings.decayRate, step/period);
+        case LearningRateSchedule::COSINE:
+            return settings.learningRate*0.5*(1+std::cos(M_PI*std::min(1.0, step/period)));
+        default:
+            return settings.learningRate;
+    }
+}
+
+template<typename Accumulator>
+OptimizerStep<Accumulator> makeOptimizerStep(const OptimizerSettings &settings, uint64_t step, size_t batchSize) {
+    double learningRate = scheduledLearningRate(settings, step);
+    OptimizerStep<Accumulator> constants{};
+    constants.momentum = (Accumulator)settings.momentum;
+    constants.beta1 = (Accumulator)settings.beta1;
+    constants.beta2 = (Accumulator)settings.beta2;
+    constants.epsilon = (Accumulator)settings.epsilon;
+    constants.decay = (Accumulator)(1-learningRate*settings.weightDecay);
+    if (settings.type == OptimizerType::MOMENTUM || settings.type == OptimizerType::NESTEROV){
+        // the learning rate is folded into the averaging of the gradients
+        constants.gradientScale = (Accumulator)(learningRate/batchSize);
+        constants.learningRate = (Accumulator)learningRate;
+        return constants;
+    }
+    constants.gradientScale = (Accumulator)(1.0/batchSize);
+    constants.learningRate = (Accumulator)learningRate;
+    if (settings.type == OptimizerType::ADAM){
+        // both averages start at zero so early on they are scaled up by how much of them is still that zero, which is
+        // folded into the learning rate and epsilon rather than done to every weight
+        double firstCorrection = 1-std::pow(settings.beta1, (double)(step+1));
+        double secondCorrection = std::sqrt(1-std::pow(settings.beta2, (double)(step+1)));
+        constants.learningRate = (Accumulator)(learningRate*secondCorrection/firstCorrection);
+        constants.epsilon = (Accumulator)(settings.epsilon*secondCorrection);
+    }
+    return constants;
+}
+
+const char* optimizerName(OptimizerType type) {
+    return (size_t)type<numOptimizers ? optimizerNames[(size_t)type] : "unknown";
+}
+
+bool parseOptimizer(const std::string &name, OptimizerType &type) {
+    for (size_t index = 0; index<numOptimizers; index++)
+        if (name == optimizerNames[index]){
+            type = (OptimizerType)index;
+            return true;
+        }
+    return false;
+}
+
+const char* scheduleName(LearningRateSchedule schedule) {
+    return (size_t)schedule<numSchedules ? scheduleNames[(size_t)schedule] : "unknown";
+}
+
+bool parseSchedule(const std::string &name, LearningRateSchedule &schedule) {
+    for (size_t index = 0; index<numSchedules; index++)
+        if (name == scheduleNames[index]){
+            schedule = (LearningRateSchedule)index;
+            return true;
+        }
+    return false;
+}
+
+// the optimizers run with double and float sums
+template OptimizerStep<double> makeOptimizerStep<double>(const OptimizerSettings&, uint64_t, size_t);
+template OptimizerStep<float> makeOptimizerStep<float>(const OptimizerSettings&, uint64_t, size_t);
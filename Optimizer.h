@@ -0,0 +1,82 @@
+
+#ifndef NEURALNETWORK_OPTIMIZER_H
+#define NEURALNETWORK_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**********************************************************
+ * Program	:  Optimizer
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: The ways the network can turn the gradients of a batch into changes to its weights. Every optimizer
+ *                  keeps its state in buffers laid out the same as each layer's weights and updates a whole layer
+ *                  in a single pass over them, with the learning rate following a schedule as the steps go by
+ ***********************************************************/
+
+// the optimizers in the order they are numbered in model files, momentum is first as it was the only one
+enum class OptimizerType : uint32_t { MOMENTUM, NESTEROV, ADAM, RMSPROP };
+constexpr size_t numOptimizers = 4;
+
+// how the learning rate changes with the number of steps taken
+enum class LearningRateSchedule : uint32_t {
+    // the same learning rate for every step
+    CONSTANT,
+    // multiplied by decayRate every decaySteps steps
+    STEP,
+    // multiplied by decayRate over every decaySteps steps smoothly
+    EXPONENTIAL,
+    // follows half a cosine from the learning rate down to zero over decaySteps steps
+    COSINE
+};
+constexpr size_t numSchedules = 4;
+
+// everything that decides how an optimizer updates the weights
+struct OptimizerSettings {
+    OptimizerType type = OptimizerType::MOMENTUM;
+    // the defaults are the learning rate and momentum the network has always been trained with
+    double learningRate = 0.15;
+    // the fraction of the last change carried into the next for momentum and nesterov
+    double momentum = 0.5;
+    // the decay rates of the running averages of the gradients and squared gradients, RMSProp only keeps the second
+    double beta1 = 0.9, beta2 = 0.999;
+    // added to the root of the squared gradients so a weight that has seen no gradient does not divide by zero
+    double epsilon = 1e-8;
+    // every weight is shrunk by learningRate*weightDecay of itself each step, apart from the gradients
+    double weightDecay = 0;
+
+    LearningRateSchedule schedule = LearningRateSchedule::CONSTANT;
+    double decayRate = 0.5;
+    uint64_t decaySteps = 1000;
+    // the learning rate ramps up from zero over this many steps before the schedule starts
+    uint64_t warmupSteps = 0;
+};
+
+// the constants a single step of an optimizer passes to its update kernel, worked out once per batch
+template<typename Accumulator>
+struct OptimizerStep {
+    // the summed gradients are multiplied by this to average them, for momentum and nesterov it also holds the
+    // learning rate
+    Accumulator gradientScale;
+    // the learning rate of Adam and RMSProp, Adam's including the correction for its averages starting at zero
+    Accumulator learningRate;
+    Accumulator momentum, beta1, beta2, epsilon;
+    // every weight is multiplied by this before its change is added, one when there is no weight decay
+    Accumulator decay;
+};
+
+// the learning rate of the given step, counting from zero
+double scheduledLearningRate(const OptimizerSettings& settings, uint64_t step);
+// work out the constants of a step of the optimizer over a batch of the given size
+template<typename Accumulator>
+OptimizerStep<Accumulator> makeOptimizerStep(const OptimizerSettings& settings, uint64_t step, size_t batchSize);
+
+// the names of the optimizers and schedules for printing and saving, and reading them back
+const char* optimizerName(OptimizerType type);
+bool parseOptimizer(const std::string& name, OptimizerType& type);
+const char* scheduleName(LearningRateSchedule schedule);
+bool parseSchedule(const std::string& name, LearningRateSchedule& schedule);
+
+
+#endif //NEURALNETWORK_OPTIMIZER_H
@@ -0,0 +1,177 @@
+
+#include "ParallelTrainer.h"
+#include <algorithm>
+#include <chrono>
+#include "Profiler.h"
+
+// seconds since an arbitrary point used to time the workers
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// create the shards and start a thread for every worker but the first which is the calling thread
+ParallelTrainer::ParallelTrainer(NeuralNetwork &network, size_t numThreads) : network(network) {
+    if (numThreads == 0)
+        numThreads = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    shards.resize(numThreads);
+    for (size_t worker = 1; worker<numThreads; worker++)
+        threads.emplace_back(&ParallelTrainer::workerLoop, this, worker);
+}
+
+// tell the workers to stop and wait for them to exit
+ParallelTrainer::~ParallelTrainer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+    for (std::thread& thread:threads)
+        thread.join();
+}
+
+// wait for a job, run it and report back until the trainer is destroyed
+void ParallelTrainer::workerLoop(size_t worker) {
+    size_t lastGeneration = 0;
+    while (true){
+        const std::function<void(size_t)>* currentJob;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobStarted.wait(lock, [&]{ return stopping || generation != lastGeneration; });
+            if (stopping) return;
+            lastGeneration = generation;
+            currentJob = job;
+        }
+        (*currentJob)(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingWorkers == 0)
+                jobFinished.notify_one();
+        }
+    }
+}
+
+// hand the job to the worker threads, do the first worker's share and wait for the rest
+void ParallelTrainer::runOnWorkers(const std::function<void(size_t)> &work) {
+    // time every worker's part of the job so the scaling can be reported
+    std::function<void(size_t)> timedWork = [&](size_t worker){
+        double start = now();
+        work(worker);
+        shards[worker].busySeconds += now()-start;
+    };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &timedWork;
+        pendingWorkers = threads.size();
+        generation++;
+    }
+    jobStarted.notify_all();
+    timedWork(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [&]{ return pendingWorkers == 0; });
+}
+
+// give every shard an equal run of samples from the batch
+void ParallelTrainer::splitBatch(size_t batchSize) {
+    for (size_t worker = 0; worker<shards.size(); worker++){
+        shards[worker].first = batchSize*worker/shards.size();
+        shards[worker].count = batchSize*(worker+1)/shards.size()-shards[worker].first;
+        network.resizeWorkspace(shards[worker].workspace, std::max<size_t>(1, shards[worker].count));
+        shards[worker].busySeconds = 0;
+    }
+}
+
+// add the gradients of the shards together, each worker adds up the same slice of every layer's weights and always
+// adds the shards in order so the sums do not depend on which worker finished first
+void ParallelTrainer::reduceGradients(size_t worker) {
+    PROFILE_PHASE(ProfilePhase::GRADIENT_REDUCE);
+    std::vector<std::vector<double>>& total = shards[0].workspace.weightGradients;
+    for (size_t layer = 1; layer<total.size(); layer++){
+        size_t size = total[layer].size();
+        size_t first = size*worker/shards.size(), last = size*(worker+1)/shards.size();
+        for (size_t shard = 1; shard<shards.size(); shard++){
+            const double* gradients = shards[shard].workspace.weightGradients[layer].data();
+            for (size_t weight = first; weight<last; weight++)
+                total[layer][weight] += gradients[weight];
+        }
+        PROFILE_COUNT(ProfilePhase::GRADIENT_REDUCE, layer, (double)(shards.size()-1)*(last-first),
+                      shards.size()*(last-first)*sizeof(double));
+    }
+}
+
+// run the shards of a batch and update the weights with their combined gradients
+void ParallelTrainer::trainShards(size_t batchSize, const std::function<void(Shard &)> &computeShard) {
+    double start = now();
+    splitBatch(batchSize);
+    runOnWorkers([&](size_t worker){
+        if (shards[worker].count>0)
+            computeShard(shards[worker]);
+    });
+    // nothing to add up when there is a single shard
+    if (shards.size()>1)
+        runOnWorkers([&](size_t worker){ reduceGradients(worker); });
+
+    // record the errors in the order of the samples and update the weights once for the whole batch
+    errors.resize(batchSize);
+    for (Shard& shard:shards)
+        std::copy_n(shard.workspace.errors.data(), shard.count, errors.data()+shard.first);
+    network.recordErrors(errors.data(), batchSize);
+    network.applyGradients(shards[0].workspace.weightGradients, batchSize);
+
+    wallSeconds += now()-start;
+    for (Shard& shard:shards)
+        busySeconds += shard.busySeconds;
+    samplesTrained += batchSize;
+    PROFILE_PROGRESS(batchSize, network.getAverageError());
+}
+
+// train on a batch which is already stored in contiguous rows
+void ParallelTrainer::trainBatch(const double *inputs, const double *targets, size_t batchSize) {
+    if (batchSize == 0) return;
+    size_t numInputs = network.getNumInputs(), numOutputs = network.getNumOutputs();
+    trainShards(batchSize, [&](Shard& shard){
+        network.accumulateGradients(inputs+shard.first*numInputs, targets+shard.first*numOutputs, shard.count,
+                                    shard.workspace);
+    });
+}
+
+// train on the whole input, every worker copies its own slice of the batch into rows before running it
+bool ParallelTrainer::train(const NeuralNetworkInput &input, size_t batchSize) {
+    // there must be a target for every input and every sample must match the topology of the network
+    if (input.inputs.size() != input.outputs.size() || batchSize == 0) return false;
+    size_t numInputs = network.getNumInputs(), numOutputs = network.getNumOutputs();
+    for (size_t sample = 0; sample<input.inputs.size(); sample++)
+        if (input.inputs[sample].size() != numInputs || input.outputs[sample].size() != numOutputs) return false;
+
+    for (size_t batchStart = 0; batchStart<input.inputs.size(); batchStart += batchSize){
+        size_t count = std::min(batchSize, input.inputs.size()-batchStart);
+        trainShards(count, [&](Shard& shard){
+            shard.inputs.resize(shard.count*numInputs);
+            shard.targets.resize(shard.count*numOutputs);
+            for (size_t sample = 0; sample<shard.count; sample++){
+                const std::vector<double>& in = input.inputs[batchStart+shard.first+sample];
+                const std::vector<double>& out = input.outputs[batchStart+shard.first+sample];
+                std::copy(in.begin(), in.end(), shard.inputs.begin()+sample*numInputs);
+                std::copy(out.begin(), out.end(), shard.targets.begin()+sample*numOutputs);
+            }
+            network.accumulateGradients(shard.inputs.data(), shard.targets.data(), shard.count, shard.workspace);
+        });
+    }
+    return true;
+}
+
+size_t ParallelTrainer::getNumThreads() const {
+    return shards.size();
+}
+
+double ParallelTrainer::getSamplesPerSecond() const {
+    return wallSeconds>0 ? samplesTrained/wallSeconds : 0;
+}
+
+double ParallelTrainer::getScalingEfficiency() const {
+    return wallSeconds>0 ? busySeconds/(wallSeconds*shards.size()) : 0;
+}
+
+void ParallelTrainer::resetStatistics() {
+    wallSeconds = busySeconds = 0;
+    samplesTrained = 0;
+}
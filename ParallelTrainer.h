@@ -0,0 +1,89 @@
+
+#ifndef NEURALNETWORK_PARALLELTRAINER_H
+#define NEURALNETWORK_PARALLELTRAINER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "NeuralNetwork.h"
+#include "TrainingData.h"
+
+/**********************************************************
+ * Program	:  Parallel Trainer
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Trains a network on several threads at once by splitting every batch between a pool of workers. Each
+ *                  worker runs its slice of the batch against the same read only weights and sums the gradients
+ *                  into its own buffer, the buffers are then added together in a fixed order before the weights are
+ *                  updated so the result only depends on the number of threads and never on their timing
+ ***********************************************************/
+
+class ParallelTrainer {
+public:
+    // create a trainer for the network with the given number of threads, zero uses every core of the machine
+    explicit ParallelTrainer(NeuralNetwork& network, size_t numThreads = 0);
+    ~ParallelTrainer();
+    // the workers hold a reference to the trainer so it cannot be copied
+    ParallelTrainer(const ParallelTrainer&) = delete;
+    ParallelTrainer& operator=(const ParallelTrainer&) = delete;
+
+    // train the network on one batch of samples stored one after another in the given arrays
+    void trainBatch(const double* inputs, const double* targets, size_t batchSize);
+    // train the network on every sample of the input in batches of the given size, returns false if a sample does
+    // not match the topology of the network
+    bool train(const NeuralNetworkInput& input, size_t batchSize);
+
+    // the number of threads training the network including the calling thread
+    size_t getNumThreads() const;
+    // the number of samples trained per second of training
+    double getSamplesPerSecond() const;
+    // the fraction of the time the threads were busy while training, 1 means perfect scaling
+    double getScalingEfficiency() const;
+    // forget the timing of previous training
+    void resetStatistics();
+
+private:
+    // a worker's slice of the current batch and its private gradients
+    struct Shard {
+        BatchWorkspace workspace;
+        // the inputs and targets of the slice when they have to be gathered into contiguous rows
+        std::vector<double> inputs, targets;
+        // the first sample of the batch in the slice and the number of samples in it
+        size_t first = 0, count = 0;
+        // seconds the worker spent working on the current batch
+        double busySeconds = 0;
+    };
+
+    // split a batch between the shards
+    void splitBatch(size_t batchSize);
+    // run a job on every worker with the calling thread acting as the first worker and wait for all of them
+    void runOnWorkers(const std::function<void(size_t)>& job);
+    // loop run by every worker thread waiting for jobs
+    void workerLoop(size_t worker);
+    // add the gradients of every shard into the first shard, each worker adding its own slice of the weights
+    void reduceGradients(size_t worker);
+    // run a batch whose shards know how to produce their samples and update the network with the result
+    void trainShards(size_t batchSize, const std::function<void(Shard&)>& computeShard);
+
+    NeuralNetwork& network;
+    std::vector<Shard> shards;
+    std::vector<std::thread> threads;
+
+    // state shared with the workers to hand out jobs
+    std::mutex mutex;
+    std::condition_variable jobStarted, jobFinished;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t generation = 0, pendingWorkers = 0;
+    bool stopping = false;
+    // the errors of every shard gathered in the order of the samples so they are recorded for the batch as a whole
+    std::vector<double> errors;
+
+    // timing of the training so far
+    double wallSeconds = 0, busySeconds = 0;
+    size_t samplesTrained = 0;
+};
+
+
+#endif //NEURALNETWORK_PARALLELTRAINER_H
@@ -0,0 +1,235 @@
+
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <json/json.h>
+
+// the names of the phases in the order of their enum
+static const char* const phaseNames[numProfilePhases] = {"forward", "output gradient", "hidden gradient",
+                                                          "weight gradient", "gradient reduce", "weight update",
+                                                          "data load"};
+
+// the profile the calling thread records into and the reset it was made after
+static thread_local void* currentProfile = nullptr;
+static thread_local uint64_t currentGeneration = 0;
+
+const char* profilePhaseName(ProfilePhase phase) {
+    return (size_t)phase<numProfilePhases ? phaseNames[(size_t)phase] : "unknown";
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : started(std::chrono::steady_clock::now()), lastProgress(started) {}
+
+// find the calling thread's totals, adding them the first time the thread records anything
+Profiler::ThreadProfile &Profiler::threadProfile() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!currentProfile || currentGeneration != generation){
+        threads.emplace_back(new ThreadProfile());
+        threads.back()->index = threads.size();
+        currentProfile = threads.back().get();
+        currentGeneration = generation;
+    }
+    return *(ThreadProfile*)currentProfile;
+}
+
+void Profiler::record(ProfilePhase phase, std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end) {
+    // the lock is only taken the first time a thread records after a reset
+    ThreadProfile& profile = currentProfile && currentGeneration == generation ? *(ThreadProfile*)currentProfile :
+                             threadProfile();
+    PhaseProfile& totals = profile.phases[(size_t)phase];
+    double duration = std::chrono::duration<double>(end-start).count();
+    totals.calls++;
+    totals.seconds += duration;
+    if (profile.events.size()<maxTraceEvents)
+        profile.events.push_back({phase, std::chrono::duration<double, std::micro>(start-started).count(),
+                                  duration*1e6});
+}
+
+void Profiler::count(ProfilePhase phase, size_t layer, double flops, double bytes) {
+    ThreadProfile& profile = currentProfile && currentGeneration == generation ? *(ThreadProfile*)currentProfile :
+                             threadProfile();
+    PhaseProfile& totals = profile.phases[(size_t)phase];
+    if (totals.flops.size()<=layer){
+        totals.flops.resize(layer+1, 0.0);
+        totals.bytes.resize(layer+1, 0.0);
+    }
+    totals.flops[layer] += flops;
+    totals.bytes[layer] += bytes;
+}
+
+void Profiler::progress(size_t count, double loss) {
+    std::lock_guard<std::mutex> lock(mutex);
+    samples += count;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double sinceLast = std::chrono::duration<double>(now-lastProgress).count();
+    if (sinceLast<progressInterval)
+        return;
+    points.push_back({std::chrono::duration<double>(now-started).count(), samples,
+                      (samples-samplesAtLastProgress)/sinceLast, loss});
+    lastProgress = now;
+    samplesAtLastProgress = samples;
+}
+
+std::vector<PhaseProfile> Profiler::getPhases() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<PhaseProfile> phases(numProfilePhases);
+    for (const std::unique_ptr<ThreadProfile>& thread:threads)
+        for (size_t phase = 0; phase<numProfilePhases; phase++){
+            const PhaseProfile& totals = thread->phases[phase];
+            phases[phase].calls += totals.calls;
+            phases[phase].seconds += totals.seconds;
+            if (phases[phase].flops.size()<totals.flops.size()){
+                phases[phase].flops.resize(totals.flops.size(), 0.0);
+                phases[phase].bytes.resize(totals.bytes.size(), 0.0);
+            }
+            for (size_t layer = 0; layer<totals.flops.size(); layer++){
+                phases[phase].flops[layer] += totals.flops[layer];
+                phases[phase].bytes[layer] += totals.bytes[layer];
+            }
+        }
+    return phases;
+}
+
+std::vector<ProgressPoint> Profiler::getProgress() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return points;
+}
+
+uint64_t Profiler::getSamples() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples;
+}
+
+double Profiler::getSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-started).count();
+}
+
+void Profiler::printSummary(std::ostream &out) const {
+    std::vector<PhaseProfile> phases = getPhases();
+    double seconds = getSeconds();
+    uint64_t trained = getSamples();
+    char line[256];
+    std::snprintf(line, sizeof(line), "%.0f samples in %.3fs, %.1f samples/s", (double)trained, seconds,
+                  seconds>0 ? trained/seconds : 0);
+    out<<line<<"\n";
+    // the seconds of every thread are added together so the phases can add up to more than the run on many threads
+    std::snprintf(line, sizeof(line), "%-16s %12s %12s %14s %10s %10s", "phase", "calls", "seconds", "GFLOP", "GFLOP/s",
+                  "GB/s");
+    out<<line<<"\n";
+    for (size_t phase = 0; phase<numProfilePhases; phase++){
+        double flops = 0, bytes = 0;
+        for (size_t layer = 0; layer<phases[phase].flops.size(); layer++){
+            flops += phases[phase].flops[layer];
+            bytes += phases[phase].bytes[layer];
+        }
+        double time = phases[phase].seconds;
+        std::snprintf(line, sizeof(line), "%-16s %12llu %12.4f %14.3f %10.2f %10.2f", phaseNames[phase],
+                      (unsigned long long)phases[phase].calls, time, flops/1e9, time>0 ? flops/time/1e9 : 0,
+                      time>0 ? bytes/time/1e9 : 0);
+        out<<line<<"\n";
+    }
+    // the work of every layer summed over the phases
+    size_t numLayers = 0;
+    for (const PhaseProfile& phase:phases)
+        numLayers = std::max(numLayers, phase.flops.size());
+    for (size_t layer = 1; layer<numLayers; layer++){
+        double flops = 0, bytes = 0;
+        for (const PhaseProfile& phase:phases)
+            if (layer<phase.flops.size()){
+                flops += phase.flops[layer];
+                bytes += phase.bytes[layer];
+            }
+        std::snprintf(line, sizeof(line), "layer %-10zu %14.3f GFLOP %10.3f GB", layer, flops/1e9, bytes/1e9);
+        out<<line<<"\n";
+    }
+    out.flush();
+}
+
+bool Profiler::writeLog(const std::string &fileName) const {
+    std::vector<PhaseProfile> phases = getPhases();
+    Json::Value log;
+    double seconds = getSeconds();
+    uint64_t trained = getSamples();
+    log["Seconds"] = seconds;
+    log["Samples"] = (Json::UInt64)trained;
+    log["Samples Per Second"] = seconds>0 ? trained/seconds : 0;
+    log["Phases"] = Json::Value(Json::arrayValue);
+    for (size_t phase = 0; phase<numProfilePhases; phase++){
+        Json::Value entry;
+        entry["Name"] = phaseNames[phase];
+        entry["Calls"] = (Json::UInt64)phases[phase].calls;
+        entry["Seconds"] = phases[phase].seconds;
+        entry["Layers"] = Json::Value(Json::arrayValue);
+        for (size_t layer = 1; layer<phases[phase].flops.size(); layer++){
+            Json::Value counters;
+            counters["Layer"] = (Json::UInt64)layer;
+            counters["FLOPs"] = phases[phase].flops[layer];
+            counters["Bytes"] = phases[phase].bytes[layer];
+            entry["Layers"].append(counters);
+        }
+        log["Phases"].append(entry);
+    }
+    log["Progress"] = Json::Value(Json::arrayValue);
+    for (const ProgressPoint& point:getProgress()){
+        Json::Value entry;
+        entry["Seconds"] = point.seconds;
+        entry["Samples"] = (Json::UInt64)point.samples;
+        entry["Samples Per Second"] = point.samplesPerSecond;
+        entry["Loss"] = point.loss;
+        log["Progress"].append(entry);
+    }
+
+    std::ofstream file(fileName);
+    if (!file)
+        return false;
+    file<<log<<std::endl;
+    return (bool)file;
+}
+
+bool Profiler::writeTrace(const std::string &fileName) const {
+    std::ofstream file(fileName);
+    if (!file)
+        return false;
+    // the events are written by hand as there can be too many of them to build up a json document first
+    char line[256];
+    file<<"{\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::unique_ptr<ThreadProfile>& thread:threads)
+            for (const TraceEvent& event:thread->events){
+                std::snprintf(line, sizeof(line),
+                              "%s{\"name\":\"%s\",\"cat\":\"training\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+                              "\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n", phaseNames[(size_t)event.phase],
+                              thread->index, event.start, event.duration);
+                file<<line;
+                first = false;
+            }
+    }
+    for (const ProgressPoint& point:getProgress()){
+        std::snprintf(line, sizeof(line),
+                      "%s{\"name\":\"progress\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                      "\"args\":{\"samples/s\":%.6g,\"loss\":%.6g}}", first ? "" : ",\n", point.seconds*1e6,
+                      point.samplesPerSecond, std::isfinite(point.loss) ? point.loss : 0.0);
+        file<<line;
+        first = false;
+    }
+    file<<"\n],\"displayTimeUnit\":\"ms\"}"<<std::endl;
+    return (bool)file;
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.clear();
+    generation++;
+    points.clear();
+    samples = samplesAtLastProgress = 0;
+    started = lastProgress = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,144 @@
+
+#ifndef NEURALNETWORK_PROFILER_H
+#define NEURALNETWORK_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Profiler
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Times the phases of training and counts the floating point operations and bytes of every layer, along
+ *                  with the samples trained per second, the time spent waiting on the training data and the loss as it
+ *                  goes. Every thread adds to its own totals so the hot loops never take a lock. The results can be
+ *                  written as a json log or as a Chrome trace (chrome://tracing or Perfetto) with the first events of
+ *                  every thread and the progress as counters.
+ *
+ *                  The profiler is only built in when the program is configured with -DPROFILING=ON, otherwise the
+ *                  PROFILE_ macros in the hot paths compile to nothing
+ ***********************************************************/
+
+#ifdef NEURALNETWORK_PROFILING
+constexpr bool profilingEnabled = true;
+#else
+constexpr bool profilingEnabled = false;
+#endif
+
+// the phases of training that are timed, in the order they are reported
+enum class ProfilePhase : uint32_t { FORWARD, OUTPUT_GRADIENT, HIDDEN_GRADIENT, WEIGHT_GRADIENT, GRADIENT_REDUCE,
+                                     WEIGHT_UPDATE, DATA_LOAD };
+constexpr size_t numProfilePhases = 7;
+
+const char* profilePhaseName(ProfilePhase phase);
+
+// the time spent in a phase and the work done by every layer during it
+struct PhaseProfile {
+    uint64_t calls = 0;
+    double seconds = 0;
+    // indexed by layer, the input layer is never counted
+    std::vector<double> flops, bytes;
+};
+
+// how fast training was going and the average error at one point of the run
+struct ProgressPoint {
+    double seconds;
+    uint64_t samples;
+    double samplesPerSecond, loss;
+};
+
+class Profiler {
+public:
+    // the profiler every PROFILE_ macro records into
+    static Profiler& instance();
+
+    // add a finished phase to the totals of the calling thread
+    void record(ProfilePhase phase, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+    // add the work a layer did during a phase to the totals of the calling thread
+    void count(ProfilePhase phase, size_t layer, double flops, double bytes);
+    // count trained samples, the loss is kept every progressInterval seconds
+    void progress(size_t samples, double loss);
+
+    // the totals of every thread added together
+    std::vector<PhaseProfile> getPhases() const;
+    std::vector<ProgressPoint> getProgress() const;
+    uint64_t getSamples() const;
+    double getSeconds() const;
+
+    // print a table of where the time went
+    void printSummary(std::ostream& out) const;
+    // write the totals and the progress as json, returns false if the file could not be written
+    bool writeLog(const std::string& fileName) const;
+    // write the timed phases and the progress as Chrome trace events, returns false if the file could not be written
+    bool writeTrace(const std::string& fileName) const;
+    // forget everything recorded so far and start the clock again, no thread may be recording while it runs
+    void reset();
+
+    // how often the progress is kept and the number of phases of every thread kept for the trace
+    constexpr static double progressInterval = 1.0;
+    constexpr static size_t maxTraceEvents = 1<<16;
+
+private:
+    Profiler();
+
+    // a phase as it appears in the trace, in microseconds since the profiler started
+    struct TraceEvent {
+        ProfilePhase phase;
+        double start, duration;
+    };
+    // the totals of one thread, kept after the thread exits
+    struct ThreadProfile {
+        size_t index;
+        PhaseProfile phases[numProfilePhases];
+        std::vector<TraceEvent> events;
+    };
+    ThreadProfile& threadProfile();
+
+    // the threads are only added to under the mutex, their totals belong to the thread that records them
+    mutable std::mutex mutex;
+    std::deque<std::unique_ptr<ThreadProfile>> threads;
+    // bumped by reset so threads know their cached profile is gone
+    std::atomic<uint64_t> generation{0};
+    std::chrono::steady_clock::time_point started, lastProgress;
+    uint64_t samples = 0, samplesAtLastProgress = 0;
+    std::vector<ProgressPoint> points;
+};
+
+// times the rest of the scope as a phase
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        Profiler::instance().record(phase, start, std::chrono::steady_clock::now());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfilePhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef NEURALNETWORK_PROFILING
+#define PROFILE_CONCAT(a, b) a##b
+#define PROFILE_NAME(line) PROFILE_CONCAT(profileScope, line)
+#define PROFILE_PHASE(phase) ProfileScope PROFILE_NAME(__LINE__)(phase)
+#define PROFILE_COUNT(phase, layer, flops, bytes) Profiler::instance().count(phase, layer, flops, bytes)
+#define PROFILE_PROGRESS(samples, loss) Profiler::instance().progress(samples, loss)
+#else
+#define PROFILE_PHASE(phase)
+#define PROFILE_COUNT(phase, layer, flops, bytes)
+#define PROFILE_PROGRESS(samples, loss)
+#endif
+
+
+#endif //NEURALNETWORK_PROFILER_H
@@ -0,0 +1,64 @@
+
+#include "Pruning.h"
+#include <algorithm>
+#include <cmath>
+
+PruneMask pruneNetwork(NeuralNetwork &network, const PruneSettings &settings) {
+    std::vector<PackedLayer> layers = network.getPackedLayers();
+    PruneMask mask(layers.size());
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        PackedLayer& layer = layers[layerNumber];
+        std::vector<uint8_t>& kept = mask[layerNumber];
+        kept.assign(layer.weights.size(), 0);
+
+        // the weights that could be removed from the largest to the smallest, the bias weight ends every row
+        std::vector<size_t> candidates;
+        for (size_t weight = 0; weight<layer.weights.size(); weight++){
+            if (weight%layer.numInputs == layer.numInputs-1)
+                kept[weight] = 1;
+            else if (layer.weights[weight] != 0 && std::abs(layer.weights[weight])>=settings.threshold)
+                candidates.push_back(weight);
+        }
+        size_t numKept = (size_t)std::ceil(settings.keepFraction*(layer.weights.size()-layer.numNeurons));
+        if (settings.topK)
+            numKept = std::min(numKept, settings.topK);
+        numKept = std::min(numKept, candidates.size());
+        // ties are broken by position so the same network is always pruned the same way
+        std::nth_element(candidates.begin(), candidates.begin()+numKept, candidates.end(), [&](size_t a, size_t b){
+            double magnitudeA = std::abs(layer.weights[a]), magnitudeB = std::abs(layer.weights[b]);
+            return magnitudeA>magnitudeB || (magnitudeA == magnitudeB && a<b);
+        });
+        for (size_t candidate = 0; candidate<numKept; candidate++)
+            kept[candidates[candidate]] = 1;
+
+        // the optimizer's running averages are zeroed too so nothing pushes a removed weight off zero
+        for (size_t weight = 0; weight<layer.weights.size(); weight++){
+            if (kept[weight]) continue;
+            layer.weights[weight] = 0;
+            layer.deltaWeights[weight] = 0;
+            if (!layer.moments.empty()) layer.moments[weight] = 0;
+            if (!layer.squares.empty()) layer.squares[weight] = 0;
+        }
+    }
+
+    NeuralNetwork pruned(std::move(layers), network.getErrorRate(), network.getAverageError(),
+                         network.getAverageSmoothingFactor());
+    pruned.setOptimizer(network.getOptimizer());
+    pruned.setOptimizerStep(network.getOptimizerStep());
+    network = std::move(pruned);
+    return mask;
+}
+
+void trainPruned(NeuralNetwork &network, const PruneMask &mask, const double *inputs, const double *targets,
+                 size_t batchSize, BatchWorkspace &workspace) {
+    if (batchSize == 0) return;
+    network.resizeWorkspace(workspace, batchSize);
+    network.accumulateGradients(inputs, targets, batchSize, workspace);
+    // a removed weight with no gradient and no running averages is never moved by any of the optimizers
+    for (size_t layer = 1; layer<mask.size(); layer++)
+        for (size_t weight = 0; weight<mask[layer].size(); weight++)
+            if (!mask[layer][weight])
+                workspace.weightGradients[layer][weight] = 0;
+    network.recordErrors(workspace.errors.data(), batchSize);
+    network.applyGradients(workspace.weightGradients, batchSize);
+}
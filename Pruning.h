@@ -0,0 +1,41 @@
+
+#ifndef NEURALNETWORK_PRUNING_H
+#define NEURALNETWORK_PRUNING_H
+
+#include <cstdint>
+#include <vector>
+#include "NeuralNetwork.h"
+
+/**********************************************************
+ * Program	:  Pruning
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Removes the weights of a network that matter least by setting them to zero, either every weight
+ *                  smaller than a threshold or all but the largest in every layer. The weights from the bias neurons
+ *                  are always kept. A pruned network loses some accuracy which a few passes of training win back,
+ *                  that training zeroes the gradients of the removed weights so they never grow back. The pruned
+ *                  network is then run as a SparseModel which only stores and sums the weights that are left
+ ***********************************************************/
+
+// which weights pruning removes, a weight is kept only if it passes every test
+struct PruneSettings {
+    // weights smaller than the threshold are removed
+    double threshold = 0;
+    // the number of the largest weights every layer keeps and the fraction of every layer's weights kept, the
+    // smaller of the two is used. Zero keeps any number
+    size_t topK = 0;
+    double keepFraction = 1;
+};
+
+// for every layer whether each weight is kept, laid out like the weights of the layer
+typedef std::vector<std::vector<uint8_t>> PruneMask;
+
+// zero the weights the settings remove along with the optimizer's state for them and return which were kept, the
+// weights that were already zero count as removed
+PruneMask pruneNetwork(NeuralNetwork& network, const PruneSettings& settings);
+// train a pruned network on a batch of samples stored one after another, the removed weights stay at zero
+void trainPruned(NeuralNetwork& network, const PruneMask& mask, const double* inputs, const double* targets,
+                 size_t batchSize, BatchWorkspace& workspace);
+
+
+#endif //NEURALNETWORK_PRUNING_H
@@ -0,0 +1,204 @@
+
+#include "QuantizedModel.h"
+#include "Kernels.h"
+#include <cmath>
+
+// every activation table has this many steps either side of zero
+static constexpr int tableSteps = 512;
+
+// the largest sum an activation table needs to cover. Past 4 tanh is within half of an 8 bit step of +-1 and sigmoid
+// is the same past 8, the unbounded activations are covered up to the largest value the next layer's inputs can hold
+static double tableRange(Activation activation, double outputScale) {
+    if (activation == Activation::TANH) return 4;
+    if (activation == Activation::SIGMOID) return 8;
+    return 127*outputScale;
+}
+
+// the 8 bit step nearest to a value, saturating at the ends of the range which is kept symmetric
+static int8_t quantizeValue(double value, double scale) {
+    long step = std::lround(value/scale);
+    return (int8_t)std::max(-127L, std::min(127L, step));
+}
+
+// split a multiplier into a 31 bit fixed point fraction and the shift which scales the product back down
+static void fixedPoint(double multiplier, int32_t& fraction, int& shift) {
+    int exponent = 0;
+    double mantissa = std::frexp(multiplier, &exponent);
+    int64_t rounded = std::llround(mantissa*(double)(1LL<<31));
+    // the mantissa can round up to exactly one
+    if (rounded == (1LL<<31)){
+        rounded /= 2;
+        exponent++;
+    }
+    fraction = (int32_t)rounded;
+    shift = 31-exponent;
+    // a multiplier too small to ever move off the middle of the table or so big every sum runs off its ends
+    if (multiplier<=0 || shift>62){
+        fraction = 0;
+        shift = 1;
+    } else if (shift<1){
+        fraction = INT32_MAX;
+        shift = 1;
+    }
+}
+
+// scale a sum down by a fixed point multiplier rounding to nearest and clamp it to an index of the activation table
+static int requantize(int32_t sum, int32_t fraction, int shift) {
+    int64_t index = ((int64_t)sum*fraction+(1LL<<(shift-1)))>>shift;
+    return (int)std::max<int64_t>(-tableSteps, std::min<int64_t>(tableSteps, index));
+}
+
+// size both buffers for the widest layer of the model
+QuantizedWorkspace::QuantizedWorkspace(const QuantizedModel &model) {
+    current.resize(model.getMaxWidth());
+    next.resize(model.getMaxWidth());
+}
+
+// work out the multipliers and tables of every layer from its scales
+QuantizedModel::QuantizedModel(std::vector<Layer> layers, std::shared_ptr<const void> storage) :
+        layers(std::move(layers)), maxWidth(0), storage(std::move(storage)) {
+    maxWidth = getMaxWidth();
+    requantizations.resize(this->layers.size()-1);
+    for (size_t layerNumber = 0; layerNumber+1<this->layers.size(); layerNumber++){
+        const Layer& layer = this->layers[layerNumber];
+        Requantization& requantization = requantizations[layerNumber];
+        // the outputs of every layer are quantized to the scale of the inputs of the next
+        double outputScale = this->layers[layerNumber+1].scales[0];
+        requantization.bias = quantizeValue(layer.bias, outputScale);
+        // the input layer's values come straight from the inputs so it only needs its bias
+        if (layerNumber == 0) continue;
+
+        // run the sum every step of the table stands for through the layer's activation
+        double stepsPerUnit = tableSteps/tableRange(layer.activation, outputScale);
+        std::vector<double> values(2*tableSteps+1);
+        for (int index = -tableSteps; index<=tableSteps; index++)
+            values[index+tableSteps] = index/stepsPerUnit;
+        getKernels().activate[(size_t)layer.activation](values.data(), values.size());
+        requantization.activationTable.resize(values.size());
+        for (size_t index = 0; index<values.size(); index++)
+            requantization.activationTable[index] = quantizeValue(values[index], outputScale);
+        // a sum is worth the input scale times the neuron's weight scale, which is then measured in table steps
+        requantization.multipliers.resize(layer.numNeurons);
+        requantization.shifts.resize(layer.numNeurons);
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+            fixedPoint((double)layer.scales[0]*layer.scales[1+neuron]*stepsPerUnit,
+                       requantization.multipliers[neuron], requantization.shifts[neuron]);
+    }
+}
+
+// run the inputs through every layer in 8 bits bouncing between the two buffers of the workspace
+void QuantizedModel::predict(const double *inputs, double *outputs, QuantizedWorkspace &workspace) const {
+    // a default workspace is sized on its first use, after that predicting never allocates
+    if (workspace.current.size()<maxWidth)
+        workspace = QuantizedWorkspace(*this);
+    const QuantizedKernelTable& kernels = getQuantizedKernels();
+    int8_t* current = workspace.current.data();
+    int8_t* next = workspace.next.data();
+
+    // the inputs quantized to the scale of the first layer of weights followed by the bias
+    double inputScale = layers[1].scales[0];
+    for (size_t input = 0; input<layers[0].numNeurons; input++)
+        current[input] = quantizeValue(inputs[input], inputScale);
+    current[layers[0].numNeurons] = requantizations[0].bias;
+
+    // the hidden layers look the activation of every sum up in their tables
+    for (size_t layerNumber = 1; layerNumber+1<layers.size(); layerNumber++){
+        const Layer& layer = layers[layerNumber];
+        const Requantization& requantization = requantizations[layerNumber];
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+            int32_t sum = kernels.dot(current, layer.weights+neuron*layer.numInputs, layer.numInputs);
+            next[neuron] = requantization.activationTable[tableSteps+requantize(sum, requantization.multipliers[neuron],
+                                                                                requantization.shifts[neuron])];
+        }
+        next[layer.numNeurons] = requantization.bias;
+        std::swap(current, next);
+    }
+
+    // the output layer scales its sums back to real values and activates them in double precision
+    const Layer& outputLayer = layers.back();
+    for (size_t neuron = 0; neuron<outputLayer.numNeurons; neuron++){
+        int32_t sum = kernels.dot(current, outputLayer.weights+neuron*outputLayer.numInputs, outputLayer.numInputs);
+        outputs[neuron] = sum*(double)outputLayer.scales[0]*outputLayer.scales[1+neuron];
+    }
+    getKernels().activate[(size_t)outputLayer.activation](outputs, outputLayer.numNeurons);
+}
+
+size_t QuantizedModel::getNumInputs() const {
+    return layers.front().numNeurons;
+}
+
+size_t QuantizedModel::getNumOutputs() const {
+    return layers.back().numNeurons;
+}
+
+// the widest layer is worked out once when the model is made and cached from then on
+size_t QuantizedModel::getMaxWidth() const {
+    if (maxWidth) return maxWidth;
+    size_t width = 0;
+    for (const Layer& layer:layers)
+        width = std::max(width, layer.numNeurons+1);
+    return width;
+}
+
+const std::vector<QuantizedModel::Layer> &QuantizedModel::getLayers() const {
+    return layers;
+}
+
+// the weights and scales of a model quantized in memory rather than mapped from a file
+struct QuantizedStorage {
+    std::vector<std::vector<int8_t>> weights;
+    std::vector<std::vector<float>> scales;
+};
+
+std::shared_ptr<const QuantizedModel> quantizeModel(const Model &model, const double *inputs, size_t count) {
+    const std::vector<Model::Layer>& layers = model.getLayers();
+    if (layers.size()<2)
+        return nullptr;
+
+    // run the sample through the model recording the largest value fed into every layer, bias included
+    const KernelTable& kernels = getKernels();
+    std::vector<double> largest(layers.size(), 0.0);
+    std::vector<double> current(model.getMaxWidth()), next(model.getMaxWidth());
+    for (size_t sample = 0; sample<count; sample++){
+        std::copy(inputs+sample*layers[0].numNeurons, inputs+(sample+1)*layers[0].numNeurons, current.begin());
+        current[layers[0].numNeurons] = layers[0].bias;
+        for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+            const Model::Layer& layer = layers[layerNumber];
+            for (size_t input = 0; input<layer.numInputs; input++)
+                largest[layerNumber] = std::max(largest[layerNumber], std::abs(current[input]));
+            for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+                next[neuron] = kernels.dot(current.data(), layer.weights+neuron*layer.numInputs, layer.numInputs);
+            kernels.activate[(size_t)layer.activation](next.data(), layer.numNeurons);
+            next[layer.numNeurons] = layer.bias;
+            std::swap(current, next);
+        }
+    }
+
+    // quantize every row of weights to the largest of its weights, a layer or row that is all zeros gets any scale
+    std::shared_ptr<QuantizedStorage> storage = std::make_shared<QuantizedStorage>();
+    storage->weights.resize(layers.size());
+    storage->scales.resize(layers.size());
+    std::vector<QuantizedModel::Layer> quantized;
+    quantized.push_back(QuantizedModel::Layer{layers[0].numNeurons, layers[0].numInputs, nullptr, nullptr,
+                                              layers[0].bias, layers[0].activation});
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const Model::Layer& layer = layers[layerNumber];
+        std::vector<int8_t>& weights = storage->weights[layerNumber];
+        std::vector<float>& scales = storage->scales[layerNumber];
+        weights.resize(layer.numNeurons*layer.numInputs);
+        scales.resize(layer.numNeurons+1);
+        scales[0] = largest[layerNumber]>0 ? (float)(largest[layerNumber]/127) : 1.0f;
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+            const double* row = layer.weights+neuron*layer.numInputs;
+            double rowLargest = 0;
+            for (size_t input = 0; input<layer.numInputs; input++)
+                rowLargest = std::max(rowLargest, std::abs(row[input]));
+            scales[1+neuron] = rowLargest>0 ? (float)(rowLargest/127) : 1.0f;
+            for (size_t input = 0; input<layer.numInputs; input++)
+                weights[neuron*layer.numInputs+input] = quantizeValue(row[input], scales[1+neuron]);
+        }
+        quantized.push_back(QuantizedModel::Layer{layer.numNeurons, layer.numInputs, weights.data(), scales.data(),
+                                                  layer.bias, layer.activation});
+    }
+    return std::make_shared<const QuantizedModel>(std::move(quantized), std::move(storage));
+}
@@ -0,0 +1,89 @@
+
+#ifndef NEURALNETWORK_QUANTIZEDMODEL_H
+#define NEURALNETWORK_QUANTIZEDMODEL_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "Model.h"
+
+/**********************************************************
+ * Program	:  Quantized Model
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A model whose weights and values are stored as 8 bit integers, an eighth of the size of the doubles
+ *                  they come from. Every neuron's row of weights has its own scale and the values flowing into every
+ *                  layer share one, calibrated by running a sample of the training data through the full precision
+ *                  model. The rows are summed in 32 bit integers and each sum is brought back down with a fixed point
+ *                  multiplier to an index into a table of the layer's activation, which holds the next layer's 8 bit inputs directly.
+ *                  Only the output layer leaves the integers to give its outputs as doubles
+ ***********************************************************/
+
+class QuantizedModel;
+
+// the scratch space one caller needs to run a quantized model
+struct QuantizedWorkspace {
+    QuantizedWorkspace() = default;
+    explicit QuantizedWorkspace(const QuantizedModel& model);
+    // two buffers big enough for the widest layer, each layer reads from one and writes to the other
+    std::vector<int8_t> current, next;
+};
+
+class QuantizedModel {
+public:
+    // a layer of the model pointing into the model's storage
+    struct Layer {
+        // the number of neurons in the layer and the number of inputs into each, including the bias
+        size_t numNeurons, numInputs;
+        // row major matrix of the quantized weights feeding into the layer
+        const int8_t* weights;
+        // the value of one step of the layer's inputs followed by the value of one step of every neuron's weights
+        const float* scales;
+        // the value of the layer's bias neuron which is fed into the next layer
+        double bias;
+        // the activation function applied to the layer's sums
+        Activation activation;
+    };
+
+    // a model over weights and scales stored elsewhere, the storage is kept alive for as long as the model is
+    QuantizedModel(std::vector<Layer> layers, std::shared_ptr<const void> storage);
+
+    // feed the inputs forward and write the outputs, safe to call from many threads as long as each has its own
+    // workspace
+    void predict(const double* inputs, double* outputs, QuantizedWorkspace& workspace) const;
+
+    // the number of inputs and outputs of the model and the size of the widest layer including its bias
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+    size_t getMaxWidth() const;
+    // the layers of the model with the input layer first
+    const std::vector<Layer>& getLayers() const;
+
+private:
+    // how the outputs of a layer are turned into the 8 bit inputs of the next layer
+    struct Requantization {
+        // every neuron's sum is multiplied by multiplier*2^-shift to give its index into the activation table
+        std::vector<int32_t> multipliers;
+        std::vector<int> shifts;
+        // the activation at every index quantized to the scale of the next layer's inputs
+        std::vector<int8_t> activationTable;
+        // the layer's bias neuron quantized to the same scale
+        int8_t bias;
+    };
+
+    std::vector<Layer> layers;
+    // the requantization of every layer but the output layer, the input layer only uses its bias
+    std::vector<Requantization> requantizations;
+    // the size of the widest layer including its bias
+    size_t maxWidth;
+    // owner of the memory the weights and scales of the layers point into
+    std::shared_ptr<const void> storage;
+};
+
+// quantize a model using the largest values that reach each of its layers when the given inputs are run through it,
+// the inputs should be a sample of the data the model was trained on, returns nullptr if the model has no layers
+// of weights
+std::shared_ptr<const QuantizedModel> quantizeModel(const Model& model, const double* inputs, size_t count);
+
+
+#endif //NEURALNETWORK_QUANTIZEDMODEL_H
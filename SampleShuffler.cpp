@@ -0,0 +1,62 @@
+
+#include "SampleShuffler.h"
+#include <algorithm>
+
+void shuffleOrder(std::vector<size_t> &order, size_t count, std::mt19937_64 &engine) {
+    order.resize(count);
+    for (size_t index = 0; index<count; index++)
+        order[index] = index;
+    // fisher-yates written out as the standard shuffle is free to differ between libraries, the bias of the modulo
+    // is far too small to matter with 64 bit numbers
+    for (size_t index = count; index>1; index--)
+        std::swap(order[index-1], order[engine()%index]);
+}
+
+SampleShuffler::SampleShuffler(size_t numInputs, size_t numOutputs, size_t blockSize) :
+        numInputs(numInputs), numOutputs(numOutputs), blockSize(std::max<size_t>(1, blockSize)) {
+    for (StagedSamples& block:blocks){
+        block.inputs.resize(this->blockSize*numInputs);
+        block.outputs.resize(this->blockSize*numOutputs);
+    }
+}
+
+SampleShuffler::~SampleShuffler() {
+    if (pendingGather.valid())
+        pendingGather.wait();
+}
+
+void SampleShuffler::start(const size_t *order, size_t count, size_t first, Gather gather) {
+    if (pendingGather.valid())
+        pendingGather.wait();
+    this->order = order;
+    this->count = count;
+    this->gather = std::move(gather);
+    position = std::min(first, count);
+    filling = 0;
+    startGather();
+}
+
+void SampleShuffler::startGather() {
+    StagedSamples& block = blocks[filling];
+    block.count = std::min(blockSize, count-position);
+    if (block.count == 0)
+        return;
+    size_t first = position;
+    position += block.count;
+    pendingGather = std::async(std::launch::async, [this, &block, first]{
+        for (size_t sample = 0; sample<block.count; sample++)
+            gather(order[first+sample], block.inputs.data()+sample*numInputs, block.outputs.data()+sample*numOutputs);
+    });
+}
+
+const StagedSamples *SampleShuffler::next() {
+    // nothing is being gathered once every sample has been handed out
+    if (!pendingGather.valid())
+        return nullptr;
+    pendingGather.get();
+    size_t ready = filling;
+    // the block handed out on the last call is finished with so the next gather can go into it
+    filling = ready^1;
+    startGather();
+    return &blocks[ready];
+}
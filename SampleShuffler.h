@@ -0,0 +1,69 @@
+
+#ifndef NEURALNETWORK_SAMPLESHUFFLER_H
+#define NEURALNETWORK_SAMPLESHUFFLER_H
+
+#include <functional>
+#include <future>
+#include <random>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Sample Shuffler
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Feeds samples to training in a shuffled order without moving the samples themselves. The order is a
+ *                  shuffled array of sample indices, and blocks of samples are gathered through it into contiguous
+ *                  rows on a background thread while the block before is trained on. Training then always reads
+ *                  rows one after another no matter how scattered the samples are. Only two blocks exist and they
+ *                  are reused for the whole pass
+ ***********************************************************/
+
+// samples gathered into flat rows, one row of inputs and one row of outputs per sample
+struct StagedSamples {
+    std::vector<double> inputs;
+    std::vector<double> outputs;
+    // the number of samples in the block
+    size_t count = 0;
+};
+
+// fill the order with the indices of count samples shuffled by the engine, the shuffle only depends on the state of
+// the engine so the same seed always gives the same order
+void shuffleOrder(std::vector<size_t>& order, size_t count, std::mt19937_64& engine);
+
+class SampleShuffler {
+public:
+    // copy the input row and output row of a sample into the given rows
+    typedef std::function<void(size_t sample, double* inputs, double* outputs)> Gather;
+
+    // stage blocks of up to blockSize samples with the given number of inputs and outputs
+    SampleShuffler(size_t numInputs, size_t numOutputs, size_t blockSize);
+    // waits for the block being gathered before the blocks go away
+    ~SampleShuffler();
+    // the background gather holds a pointer to the shuffler so it cannot be copied
+    SampleShuffler(const SampleShuffler&) = delete;
+    SampleShuffler& operator=(const SampleShuffler&) = delete;
+
+    // start gathering the samples of the order from the given position in it, the order and everything the gather
+    // reads from have to stay valid until the last block has been handed out or the next start
+    void start(const size_t* order, size_t count, size_t first, Gather gather);
+    // get the next block of samples in the order, it stays valid until the next call, returns nullptr once every
+    // sample has been handed out
+    const StagedSamples* next();
+
+private:
+    // begin gathering the next samples of the order into the block that is not being used
+    void startGather();
+
+    size_t numInputs, numOutputs, blockSize;
+    const size_t* order = nullptr;
+    size_t count = 0, position = 0;
+    Gather gather;
+
+    // the two blocks used in turn and the one being filled by the next gather
+    StagedSamples blocks[2];
+    size_t filling = 0;
+    std::future<void> pendingGather;
+};
+
+
+#endif //NEURALNETWORK_SAMPLESHUFFLER_H
@@ -0,0 +1,170 @@
+
+#include "SparseModel.h"
+#include "Kernels.h"
+#include <chrono>
+
+SparseModel::SparseModel(std::vector<Layer> layers, std::shared_ptr<const void> storage) :
+        layers(std::move(layers)), maxWidth(0), storage(std::move(storage)) {
+    maxWidth = getMaxWidth();
+}
+
+// run the inputs through every layer bouncing between the two buffers of the workspace
+void SparseModel::predict(const double *inputs, double *outputs, Workspace &workspace) const {
+    // a default workspace is sized on its first use, after that predicting never allocates
+    if (workspace.current.size()<maxWidth){
+        workspace.current.resize(maxWidth);
+        workspace.next.resize(maxWidth);
+    }
+    const SparseKernelTable& kernels = getSparseKernels();
+    const KernelTable& denseKernels = getKernels();
+    double* current = workspace.current.data();
+    double* next = workspace.next.data();
+
+    // the input layer followed by its bias
+    std::copy(inputs, inputs+layers[0].numNeurons, current);
+    current[layers[0].numNeurons] = layers[0].bias;
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const Layer& layer = layers[layerNumber];
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+            uint32_t start = layer.rowStarts[neuron];
+            next[neuron] = kernels.dot(layer.values+start, layer.columns+start, current,
+                                       layer.rowStarts[neuron+1]-start);
+        }
+        denseKernels.activate[(size_t)layer.activation](next, layer.numNeurons);
+        next[layer.numNeurons] = layer.bias;
+        std::swap(current, next);
+    }
+    std::copy(current, current+layers.back().numNeurons, outputs);
+}
+
+size_t SparseModel::getNumInputs() const {
+    return layers.front().numNeurons;
+}
+
+size_t SparseModel::getNumOutputs() const {
+    return layers.back().numNeurons;
+}
+
+// the widest layer is worked out once when the model is made and cached from then on
+size_t SparseModel::getMaxWidth() const {
+    if (maxWidth) return maxWidth;
+    size_t width = 0;
+    for (const Layer& layer:layers)
+        width = std::max(width, layer.numNeurons+1);
+    return width;
+}
+
+const std::vector<SparseModel::Layer> &SparseModel::getLayers() const {
+    return layers;
+}
+
+// the rows of a model compressed in memory rather than mapped from a file
+struct SparseStorage {
+    std::vector<std::vector<double>> values;
+    std::vector<std::vector<uint32_t>> columns, rowStarts;
+};
+
+std::shared_ptr<const SparseModel> sparsifyModel(const Model &model) {
+    const std::vector<Model::Layer>& layers = model.getLayers();
+    if (layers.size()<2)
+        return nullptr;
+
+    std::shared_ptr<SparseStorage> storage = std::make_shared<SparseStorage>();
+    storage->values.resize(layers.size());
+    storage->columns.resize(layers.size());
+    storage->rowStarts.resize(layers.size());
+    std::vector<SparseModel::Layer> sparse;
+    sparse.push_back(SparseModel::Layer{layers[0].numNeurons, layers[0].numInputs, 0, nullptr, nullptr, nullptr,
+                                        layers[0].bias, layers[0].activation});
+    for (size_t layerNumber = 1; layerNumber<layers.size(); layerNumber++){
+        const Model::Layer& layer = layers[layerNumber];
+        std::vector<double>& values = storage->values[layerNumber];
+        std::vector<uint32_t>& columns = storage->columns[layerNumber];
+        std::vector<uint32_t>& rowStarts = storage->rowStarts[layerNumber];
+        rowStarts.push_back(0);
+        for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+            const double* row = layer.weights+neuron*layer.numInputs;
+            for (size_t input = 0; input<layer.numInputs; input++)
+                if (row[input] != 0){
+                    values.push_back(row[input]);
+                    columns.push_back((uint32_t)input);
+                }
+            rowStarts.push_back((uint32_t)values.size());
+        }
+        sparse.push_back(SparseModel::Layer{layer.numNeurons, layer.numInputs, values.size(), values.data(),
+                                            columns.data(), rowStarts.data(), layer.bias, layer.activation});
+    }
+    return std::make_shared<const SparseModel>(std::move(sparse), std::move(storage));
+}
+
+// the seconds one run of a function takes, repeating it until enough time has passed to measure it
+template<typename Function>
+static double timeRuns(const Function& function) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t runs = 0;
+    double seconds = 0;
+    do {
+        function();
+        runs++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    } while (seconds<0.01);
+    return seconds/runs;
+}
+
+std::vector<SparseLayerReport> compareLayers(const Model &dense, const SparseModel &sparse, const double *inputs,
+                                             size_t count) {
+    const std::vector<Model::Layer>& denseLayers = dense.getLayers();
+    const std::vector<SparseModel::Layer>& sparseLayers = sparse.getLayers();
+    const KernelTable& kernels = getKernels();
+    const SparseKernelTable& sparseKernels = getSparseKernels();
+    std::vector<SparseLayerReport> reports;
+    if (denseLayers.size() != sparseLayers.size())
+        return reports;
+
+    // the values reaching the layer for every sample followed by its bias, one row per sample
+    size_t numInputs = denseLayers[0].numNeurons;
+    std::vector<double> current(count*(numInputs+1)), next;
+    for (size_t sample = 0; sample<count; sample++){
+        std::copy(inputs+sample*numInputs, inputs+(sample+1)*numInputs, current.begin()+sample*(numInputs+1));
+        current[sample*(numInputs+1)+numInputs] = denseLayers[0].bias;
+    }
+    for (size_t layerNumber = 1; layerNumber<denseLayers.size(); layerNumber++){
+        const Model::Layer& layer = denseLayers[layerNumber];
+        const SparseModel::Layer& sparseLayer = sparseLayers[layerNumber];
+        next.assign(count*(layer.numNeurons+1), 0);
+        auto runDense = [&]{
+            for (size_t sample = 0; sample<count; sample++){
+                const double* values = current.data()+sample*layer.numInputs;
+                double* sums = next.data()+sample*(layer.numNeurons+1);
+                for (size_t neuron = 0; neuron<layer.numNeurons; neuron++)
+                    sums[neuron] = kernels.dot(values, layer.weights+neuron*layer.numInputs, layer.numInputs);
+                kernels.activate[(size_t)layer.activation](sums, layer.numNeurons);
+            }
+        };
+        auto runSparse = [&]{
+            for (size_t sample = 0; sample<count; sample++){
+                const double* values = current.data()+sample*layer.numInputs;
+                double* sums = next.data()+sample*(layer.numNeurons+1);
+                for (size_t neuron = 0; neuron<layer.numNeurons; neuron++){
+                    uint32_t start = sparseLayer.rowStarts[neuron];
+                    sums[neuron] = sparseKernels.dot(sparseLayer.values+start, sparseLayer.columns+start, values,
+                                                     sparseLayer.rowStarts[neuron+1]-start);
+                }
+                kernels.activate[(size_t)layer.activation](sums, layer.numNeurons);
+            }
+        };
+        SparseLayerReport report;
+        report.weights = layer.numNeurons*layer.numInputs;
+        report.keptWeights = sparseLayer.numWeights;
+        report.sparsity = 1-(double)report.keptWeights/std::max<size_t>(1, report.weights);
+        report.sparseSeconds = timeRuns(runSparse);
+        // the dense layer runs last so its outputs are the ones fed to the next layer
+        report.denseSeconds = timeRuns(runDense);
+        report.speedup = report.denseSeconds/report.sparseSeconds;
+        reports.push_back(report);
+        for (size_t sample = 0; sample<count; sample++)
+            next[sample*(layer.numNeurons+1)+layer.numNeurons] = layer.bias;
+        std::swap(current, next);
+    }
+    return reports;
+}
@@ -0,0 +1,81 @@
+#ifndef NEURALNETWORK_SPARSEMODEL_H
+#define NEURALNETWORK_SPARSEMODEL_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "Model.h"
+
+/**********************************************************
+ * Program	:  Sparse Model
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A model of a pruned network that only stores the weights left after pruning. The weights of every
+ *                  layer are kept in compressed sparse rows: the weights each neuron kept one row after another, the
+ *                  column of the input every weight reads and where each row starts. Every sum only touches the inputs
+ *                  its neuron still reads, gathered by their columns, so a layer with a tenth of its weights left
+ *                  costs about a tenth as much to run. Each weight takes an extra 4 bytes for its column, so a layer
+ *                  only gets smaller once pruning has removed more than a third of it
+ ***********************************************************/
+
+class SparseModel {
+public:
+    // a layer of the model pointing into the model's storage
+    struct Layer {
+        // the number of neurons in the layer and the number of inputs into each, including the bias
+        size_t numNeurons, numInputs;
+        // the number of weights kept by all of the neurons
+        size_t numWeights;
+        // the kept weights of every neuron one row after another, the input each one reads and where every row
+        // starts, rowStarts holds numNeurons+1 entries with the last being numWeights
+        const double* values;
+        const uint32_t* columns;
+        const uint32_t* rowStarts;
+        // the value of the layer's bias neuron which is fed into the next layer
+        double bias;
+        // the activation function applied to the layer's sums
+        Activation activation;
+    };
+
+    // a model over rows stored elsewhere, the storage is kept alive for as long as the model is
+    SparseModel(std::vector<Layer> layers, std::shared_ptr<const void> storage);
+
+    // feed the inputs forward and write the outputs, safe to call from many threads as long as each has its own
+    // workspace
+    void predict(const double* inputs, double* outputs, Workspace& workspace) const;
+
+    // the number of inputs and outputs of the model and the size of the widest layer including its bias
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+    size_t getMaxWidth() const;
+    // the layers of the model with the input layer first
+    const std::vector<Layer>& getLayers() const;
+
+private:
+    std::vector<Layer> layers;
+    // the size of the widest layer including its bias
+    size_t maxWidth;
+    // owner of the memory the rows of the layers point into
+    std::shared_ptr<const void> storage;
+};
+
+// how much of a layer pruning removed and how much faster its sparse rows run than its dense ones
+struct SparseLayerReport {
+    // the weights of the dense layer and the ones the sparse layer kept
+    size_t weights, keptWeights;
+    // the fraction of the weights removed
+    double sparsity;
+    // the seconds taken to run the layer over the samples with dense and with sparse rows
+    double denseSeconds, sparseSeconds;
+    double speedup;
+};
+
+// store only the weights of a model that are not zero, returns nullptr if the model has no layers of weights
+std::shared_ptr<const SparseModel> sparsifyModel(const Model& model);
+// run the samples through the dense model and time every layer of both models on the values that reach it, the
+// models must have the same topology. Every layer is run over the samples as many times as it takes to time it
+std::vector<SparseLayerReport> compareLayers(const Model& dense, const SparseModel& sparse, const double* inputs,
+                                             size_t count);
+
+
+#endif //NEURALNETWORK_SPARSEMODEL_H
@@ -0,0 +1,212 @@
+
+#include "Sweep.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "Evaluation.h"
+
+std::vector<SweepConfig> gridSearch(const SweepSpace &space) {
+    std::vector<SweepConfig> configs;
+    for (const std::vector<int>& hiddenLayers:space.hiddenLayers)
+        for (Activation activation:space.activations)
+            for (double learningRate:space.learningRates)
+                for (double momentum:space.momentums){
+                    SweepConfig config;
+                    config.hiddenLayers = hiddenLayers;
+                    config.activation = activation;
+                    config.optimizer.type = space.optimizer;
+                    config.optimizer.learningRate = learningRate;
+                    config.optimizer.momentum = momentum;
+                    configs.push_back(config);
+                }
+    return configs;
+}
+
+std::vector<SweepConfig> randomSearch(const SweepSpace &space, size_t count, uint64_t seed) {
+    std::vector<SweepConfig> configs;
+    if (space.hiddenLayers.empty() || space.activations.empty() || space.learningRates.empty() ||
+        space.momentums.empty())
+        return configs;
+    std::mt19937_64 generator(seed);
+    auto range = [](const std::vector<double>& values){
+        return std::make_pair(*std::min_element(values.begin(), values.end()),
+                              *std::max_element(values.begin(), values.end()));
+    };
+    std::pair<double, double> learningRates = range(space.learningRates), momentums = range(space.momentums);
+    std::uniform_real_distribution<double> logLearningRate(std::log(learningRates.first), std::log(learningRates.second));
+    std::uniform_real_distribution<double> momentum(momentums.first, momentums.second);
+    for (size_t index = 0; index<count; index++){
+        SweepConfig config;
+        config.hiddenLayers = space.hiddenLayers[generator()%space.hiddenLayers.size()];
+        config.activation = space.activations[generator()%space.activations.size()];
+        config.optimizer.type = space.optimizer;
+        config.optimizer.learningRate = std::exp(logLearningRate(generator));
+        config.optimizer.momentum = momentum(generator);
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+bool readSweep(const Json::Value &input, SweepSpace &space, SweepSettings &settings, std::string &search,
+               size_t &numSamples) {
+    if (!input.isObject()){
+        std::cerr<<"A sweep must be a json object"<<std::endl;
+        return false;
+    }
+    if (input.isMember("Hidden Layers")){
+        space.hiddenLayers.clear();
+        for (const Json::Value& layers:input["Hidden Layers"]){
+            space.hiddenLayers.emplace_back();
+            for (const Json::Value& size:layers){
+                if (size.asInt()<=0){
+                    std::cerr<<"Hidden layers need at least one neuron"<<std::endl;
+                    return false;
+                }
+                space.hiddenLayers.back().push_back(size.asInt());
+            }
+        }
+    }
+    if (input.isMember("Learning Rates")){
+        space.learningRates.clear();
+        for (const Json::Value& rate:input["Learning Rates"])
+            space.learningRates.push_back(rate.asDouble());
+        // a random search picks the learning rate on a log scale which needs it to be positive
+        for (double rate:space.learningRates)
+            if (rate<=0){
+                std::cerr<<"Learning rates must be above zero"<<std::endl;
+                return false;
+            }
+    }
+    if (input.isMember("Momentums")){
+        space.momentums.clear();
+        for (const Json::Value& momentum:input["Momentums"])
+            space.momentums.push_back(momentum.asDouble());
+    }
+    if (input.isMember("Activations")){
+        space.activations.clear();
+        for (const Json::Value& name:input["Activations"]){
+            Activation activation;
+            if (!parseActivation(name.asString(), activation) || activation == Activation::SOFTMAX){
+                std::cerr<<name.asString()<<": not an activation of a hidden layer"<<std::endl;
+                return false;
+            }
+            space.activations.push_back(activation);
+        }
+    }
+    if (input.isMember("Optimizer") && !parseOptimizer(input["Optimizer"].asString(), space.optimizer)){
+        std::cerr<<input["Optimizer"].asString()<<": not an optimizer"<<std::endl;
+        return false;
+    }
+    if (space.hiddenLayers.empty() || space.learningRates.empty() || space.momentums.empty() ||
+        space.activations.empty()){
+        std::cerr<<"Every choice of the sweep needs at least one value"<<std::endl;
+        return false;
+    }
+
+    search = input.get("Search", search).asString();
+    if (search != "grid" && search != "random"){
+        std::cerr<<search<<": the search must be grid or random"<<std::endl;
+        return false;
+    }
+    numSamples = input.get("Samples", (Json::UInt64)numSamples).asUInt64();
+    settings.epochs = input.get("Epochs", (Json::UInt64)settings.epochs).asUInt64();
+    settings.batchSize = std::max<size_t>(1, input.get("Batch Size", (Json::UInt64)settings.batchSize).asUInt64());
+    settings.validationFraction = input.get("Validation Fraction", settings.validationFraction).asDouble();
+    settings.numThreads = input.get("Threads", (Json::UInt64)settings.numThreads).asUInt64();
+    settings.seed = input.get("Seed", (Json::UInt64)settings.seed).asUInt64();
+    if (settings.validationFraction<=0 || settings.validationFraction>=1){
+        std::cerr<<"The validation fraction must be between 0 and 1"<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<SweepResult> runSweep(const TrainingSet &data, const std::vector<SweepConfig> &configs,
+                                  const SweepSettings &settings, std::unique_ptr<NeuralNetwork> &best) {
+    best.reset();
+    size_t numInputs = (size_t)data.topology.front(), numOutputs = (size_t)data.topology.back();
+    size_t numValidation = (size_t)(data.count*settings.validationFraction);
+    size_t numTraining = data.count-numValidation;
+    if (numValidation == 0 || numTraining == 0){
+        std::cerr<<"Not enough samples to hold back "<<settings.validationFraction*100<<"% of them"<<std::endl;
+        return {};
+    }
+
+    std::vector<SweepResult> results(configs.size());
+    std::atomic<size_t> nextConfig(0);
+    // the weights of a new network come from rand so they are made one at a time with the seed of their config,
+    // which keeps every network the same no matter which thread trains it
+    std::mutex createMutex, bestMutex;
+    size_t bestIndex = configs.size();
+    auto trainConfigs = [&]{
+        for (size_t index = nextConfig++; index<configs.size(); index = nextConfig++){
+            const SweepConfig& config = configs[index];
+            std::vector<int> topology = {(int)numInputs};
+            topology.insert(topology.end(), config.hiddenLayers.begin(), config.hiddenLayers.end());
+            topology.push_back((int)numOutputs);
+            std::unique_ptr<NeuralNetwork> network;
+            {
+                std::lock_guard<std::mutex> lock(createMutex);
+                std::srand((unsigned)(settings.seed+index));
+                network.reset(new NeuralNetwork(topology));
+            }
+            for (size_t layer = 1; layer+1<topology.size(); layer++)
+                network->setActivation(layer, config.activation);
+            network->setOptimizer(config.optimizer);
+
+            // every network reads its batches straight out of the shared rows
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_t epoch = 0; epoch<settings.epochs; epoch++)
+                for (size_t first = 0; first<numTraining; first += settings.batchSize)
+                    network->trainBatch(data.inputs.data()+first*numInputs, data.outputs.data()+first*numOutputs,
+                                        std::min(settings.batchSize, numTraining-first));
+            SweepResult& result = results[index];
+            result.config = config;
+            result.trainingError = network->getAverageError();
+            // a network whose weights blew up has an infinite error and is ranked last
+            Evaluator evaluator(*network);
+            evaluator.add(data.inputs.data()+numTraining*numInputs, data.outputs.data()+numTraining*numOutputs,
+                          numValidation);
+            result.validationError = evaluator.result().rmse;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+            // ties go to the earlier config so the best network does not depend on the timing of the threads
+            std::lock_guard<std::mutex> lock(bestMutex);
+            if (bestIndex == configs.size() || result.validationError<results[bestIndex].validationError ||
+                (result.validationError == results[bestIndex].validationError && index<bestIndex)){
+                best = std::move(network);
+                bestIndex = index;
+            }
+        }
+    };
+
+    size_t numThreads = settings.numThreads ? settings.numThreads :
+                        std::max<unsigned>(1, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (size_t thread = 1; thread<std::min(numThreads, configs.size()); thread++)
+        threads.emplace_back(trainConfigs);
+    trainConfigs();
+    for (std::thread& thread:threads)
+        thread.join();
+
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b){
+        return a.validationError<b.validationError;
+    });
+    return results;
+}
+
+std::string describeConfig(const SweepConfig &config) {
+    std::ostringstream description;
+    for (size_t layer = 0; layer<config.hiddenLayers.size(); layer++)
+        description<<(layer ? "," : "")<<config.hiddenLayers[layer];
+    description<<" "<<activationName(config.activation)<<" "<<optimizerName(config.optimizer.type)<<" lr "
+               <<config.optimizer.learningRate<<" momentum "<<config.optimizer.momentum;
+    return description.str();
+}
@@ -0,0 +1,82 @@
+
+#ifndef NEURALNETWORK_SWEEP_H
+#define NEURALNETWORK_SWEEP_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <json/value.h>
+#include "Activation.h"
+#include "NeuralNetwork.h"
+#include "Optimizer.h"
+#include "TrainingData.h"
+
+/**********************************************************
+ * Program	:  Sweep
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Trains many small networks with different hidden layers, learning rates, momentums and activations
+ *                  at once to find the one that does best on data it was not trained on. The configurations come from
+ *                  every combination of the choices (a grid) or from random picks between them, each one is trained
+ *                  on a single thread and all of the threads read the samples out of the same copy of the data
+ ***********************************************************/
+
+// one network to train in the sweep
+struct SweepConfig {
+    // the sizes of the layers between the inputs and outputs of the data
+    std::vector<int> hiddenLayers;
+    // the activation of the hidden layers, the output layer is always tanh
+    Activation activation = Activation::TANH;
+    OptimizerSettings optimizer;
+};
+
+// the choices a sweep picks its configurations from
+struct SweepSpace {
+    std::vector<std::vector<int>> hiddenLayers = {{4}, {8}, {16}, {8, 8}};
+    std::vector<double> learningRates = {0.01, 0.05, 0.15, 0.5};
+    std::vector<double> momentums = {0.0, 0.5, 0.9};
+    std::vector<Activation> activations = {Activation::TANH, Activation::RELU, Activation::SIGMOID};
+    OptimizerType optimizer = OptimizerType::MOMENTUM;
+};
+
+// how every configuration is trained and judged
+struct SweepSettings {
+    size_t epochs = 5, batchSize = 16;
+    // the fraction of the samples at the end of the data held back to judge the networks
+    double validationFraction = 0.2;
+    // the number of networks trained at once, zero uses every core
+    size_t numThreads = 0;
+    // the random weights of each network and the picks of a random search follow from the seed
+    uint64_t seed = 1;
+};
+
+// how one configuration did
+struct SweepResult {
+    SweepConfig config;
+    // the running average error at the end of training and the root mean squared error on the held back samples
+    double trainingError, validationError;
+    double seconds;
+};
+
+// every combination of the choices
+std::vector<SweepConfig> gridSearch(const SweepSpace& space);
+// random configurations, the learning rate is picked on a log scale and the momentum evenly between the smallest and
+// largest of the choices
+std::vector<SweepConfig> randomSearch(const SweepSpace& space, size_t count, uint64_t seed);
+
+// read the choices and settings of a sweep from json, anything left out keeps its default. Returns false and prints
+// why if a value is not valid
+bool readSweep(const Json::Value& input, SweepSpace& space, SweepSettings& settings, std::string& search,
+               size_t& numSamples);
+
+// train every configuration on the data and return the results from the lowest validation error to the highest, the
+// best network is left in best
+std::vector<SweepResult> runSweep(const TrainingSet& data, const std::vector<SweepConfig>& configs,
+                                  const SweepSettings& settings, std::unique_ptr<NeuralNetwork>& best);
+
+// the topology, activation, learning rate and momentum of a configuration on one line
+std::string describeConfig(const SweepConfig& config);
+
+
+#endif //NEURALNETWORK_SWEEP_H
@@ -1,58 +1,6 @@
 
 #include "TrainingData.h"
-
-// replace a string in a given string with another string
-std::string replace(std::string &str, const std::string &toReplace, const std::string &toAdd) {
-    // start position of to replace
-    size_t start_pos = 0;
-    // while toReplace exists in the string replace it and increment the start position so we find the next one
-    while ((start_pos = str.find(toReplace, start_pos))!=std::string::npos) {
-        str.replace(start_pos, toReplace.length(), toAdd);
-        start_pos+=toAdd.size();
-    }
-    return str;
-}
-
-// split a string along a delimiter
-std::vector<std::string> split(const std::string &input, const std::string &search) {
-    std::vector<std::string> toReturn;
-
-    // position of last found match of delimiter
-    size_t last = 0;
-    // index of the next found delimiter after last
-    size_t next = 0;
-    // while a delimiter still exists in the string split the string
-    while ((next = input.find(search, last)) != std::string::npos) {
-        toReturn.emplace_back(input.substr(last, next - last));
-        last = next + 1;
-    }
-    // add the remaining piece of the string
-    toReturn.emplace_back(input.substr(last));
-    // return the vector
-    return toReturn;
-}
-
-// converts a vector of strings to a vector of ints
-std::vector<int> stringVectorToInt(std::vector<std::string> input){
-    // initialize the return array
-    std::vector<int> ret;
-    // convert all the strings in the array into integers using stoi
-    std::transform(input.begin(), input.end(), std::back_inserter(ret),
-                        [](const std::string& value){return std::stoi(value);});
-    // return the array
-    return ret;
-}
-
-// converts a vector of strings to a vector of doubles
-std::vector<double> stringVectorToDouble(std::vector<std::string> input){
-    // create the return vector
-    std::vector<double> ret;
-    // convert all the strings in the vector to doubles using stod
-    std::transform(input.begin(), input.end(), std::back_inserter(ret),
-                   [](const std::string& value){return std::stod(value);});
-    // return the vector of doubles
-    return ret;
-}
+#include "TrainingDataParser.h"
 
 TrainingData::TrainingData() {
     // create a randomization engine using the time since epoch as a seed
@@ -79,46 +27,61 @@ void TrainingData::generateTrainingData(std::string fileName, int numSets, std::
     file.close();
 }
 
-// get the line of data and convert it to a vector
-std::vector<double> TrainingData::getLine(std::string input, std::string toReplace) {
-    // replace the input leading info
-    input = replace(input, toReplace+": ", "");
-    // split the numbers along the , separator and convert them to doubles
-    return stringVectorToDouble(split(input, ","));
-}
-
-std::vector<int> TrainingData::getTopology(std::string input){
-    // get rid of "Topology: " and split along the "," and convert the topology to ints
-    input = replace(input, "Topology: ", "");
-    return stringVectorToInt(split(input, ","));
-}
-
 // read the training data into a neural network input struct
 NeuralNetworkInput TrainingData::readTrainingData(std::string fileName) {
-    // open the file and initialize the structure to read the data into
-    std::fstream file;
+    // parse the file into flat rows and then split the rows into a vector per sample
     NeuralNetworkInput ret;
-    file.open(fileName, std::fstream::in);
-    if (!file)
+    TrainingSet set;
+    bool read = readTrainingSet(fileName, set);
+    ret.topology = set.topology;
+    ret.error = set.error;
+    if (!read)
         return ret;
+    size_t numInputs = (size_t)set.topology.front(), numOutputs = (size_t)set.topology.back();
+    ret.inputs.reserve(set.count);
+    ret.outputs.reserve(set.count);
+    for (size_t sample = 0; sample<set.count; sample++){
+        ret.inputs.emplace_back(set.inputs.begin()+sample*numInputs, set.inputs.begin()+(sample+1)*numInputs);
+        ret.outputs.emplace_back(set.outputs.begin()+sample*numOutputs, set.outputs.begin()+(sample+1)*numOutputs);
+    }
+    return ret;
+}
 
-    // get and set the topology in the structure
-    std::string topologyString;
-    std::getline(file, topologyString);
-    ret.topology = getTopology(topologyString);
-
-    // get all the input and output cases and set them to the values in the structure
-    std::string line;
-    std::vector<std::vector<double>> outputs;
-    std::vector<std::vector<double >> inputs;
-    while (std::getline(file, line)){
-        inputs.emplace_back(getLine(line, "In"));
-        std::getline(file, line);
-        outputs.emplace_back(getLine(line, "Out"));
+// read the whole file into one buffer and parse it in place into the flat rows of the set
+bool TrainingData::readTrainingSet(std::string fileName, TrainingSet &set) {
+    std::fstream file;
+    file.open(fileName, std::fstream::in | std::fstream::binary);
+    if (!file){
+        set.error = "could not open "+fileName;
+        return false;
     }
-    ret.inputs = inputs;
-    ret.outputs = outputs;
-    // close the file and return the structure
+    file.seekg(0, std::fstream::end);
+    std::string buffer((size_t)file.tellg(), '\0');
+    file.seekg(0, std::fstream::beg);
+    file.read(&buffer[0], buffer.size());
     file.close();
-    return ret;
-}
\ No newline at end of file
+    const char* begin = buffer.data();
+    const char* end = begin+buffer.size();
+
+    // get and set the topology in the set
+    const char* position = TrainingDataParser::parseTopology(begin, end, set.topology);
+    if (!position){
+        set.error = "line 1: expected Topology: followed by the size of every layer";
+        return false;
+    }
+    if (position<end) position++;
+
+    // every sample takes at least two lines so the number of lines left gives room for every sample
+    size_t numInputs = (size_t)set.topology.front(), numOutputs = (size_t)set.topology.back();
+    size_t maxSamples = (std::count(position, end, '\n')+2)/2;
+    set.inputs.resize(maxSamples*numInputs);
+    set.outputs.resize(maxSamples*numOutputs);
+
+    // parse every sample and drop the room that was not needed
+    TrainingDataParser parser(numInputs, numOutputs, 2);
+    parser.parse(position, end, true, set.inputs.data(), set.outputs.data(), maxSamples, set.count);
+    set.inputs.resize(set.count*numInputs);
+    set.outputs.resize(set.count*numOutputs);
+    set.error = parser.getError();
+    return !parser.failed();
+}
@@ -25,6 +25,19 @@ struct NeuralNetworkInput{
     std::vector<int> topology;
     std::vector<std::vector<double>> inputs;
     std::vector<std::vector<double>> outputs;
+    // the line that could not be read, empty if the whole file was read
+    std::string error;
+};
+
+// the same data stored in flat rows, one row of inputs and one row of outputs per sample one after another
+struct TrainingSet{
+    std::vector<int> topology;
+    std::vector<double> inputs;
+    std::vector<double> outputs;
+    // the number of samples in the set
+    size_t count = 0;
+    // the line that could not be read, empty if the whole file was read
+    std::string error;
 };
 
 class TrainingData {
@@ -33,16 +46,13 @@ public:
     TrainingData();
     void generateTrainingData(std::string fileName, int numSets, std::function<bool(bool, bool)> function);
     NeuralNetworkInput readTrainingData(std::string fileName);
+    // read the training data into flat rows, returns false if the file could not be opened or a line is invalid
+    bool readTrainingSet(std::string fileName, TrainingSet& set);
 
 private:
     // used for random number generation for generating training data for the neural network
     std::default_random_engine* eng;
     std::uniform_int_distribution<int>* dist;
-
-    // return a vector of doubles from a line of input in the input file
-    std::vector<double> getLine(std::string input, std::string toReplace);
-    // gets the topology of a neural network and converts it to a vector
-    std::vector<int> getTopology(std::string input);
 };
 
 
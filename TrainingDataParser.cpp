@@ -0,0 +1,136 @@
+
+#include "TrainingDataParser.h"
+#include <charconv>
+#include <cstring>
+
+TrainingDataParser::TrainingDataParser(size_t numInputs, size_t numOutputs, size_t firstLine) :
+        numInputs(numInputs), numOutputs(numOutputs), lineNumber(firstLine) {}
+
+// find the end of the line starting at the given position, the end of the buffer if there is no newline
+static const char* findLineEnd(const char* line, const char* end) {
+    const char* newline = (const char*)std::memchr(line, '\n', end-line);
+    return newline ? newline : end;
+}
+
+// skip the spaces in a line
+static const char* skipSpaces(const char* position, const char* end) {
+    while (position<end && (*position == ' ' || *position == '\t' || *position == '\r')) position++;
+    return position;
+}
+
+const char *TrainingDataParser::parseTopology(const char *begin, const char *end, std::vector<int> &topology) {
+    const char* lineEnd = findLineEnd(begin, end);
+    const char* label = "Topology:";
+    size_t labelLength = std::strlen(label);
+    if ((size_t)(lineEnd-begin)<labelLength || std::memcmp(begin, label, labelLength) != 0)
+        return nullptr;
+
+    // read the comma separated sizes of the layers
+    topology.clear();
+    const char* position = begin+labelLength;
+    while (true){
+        int size;
+        position = skipSpaces(position, lineEnd);
+        std::from_chars_result result = std::from_chars(position, lineEnd, size);
+        if (result.ec != std::errc() || size<=0)
+            return nullptr;
+        topology.push_back(size);
+        position = skipSpaces(result.ptr, lineEnd);
+        if (position == lineEnd) break;
+        if (*position++ != ',')
+            return nullptr;
+    }
+    return topology.size()<2 ? nullptr : lineEnd;
+}
+
+template<typename T>
+const char *TrainingDataParser::parse(const char *begin, const char *end, bool endOfData, T *inputs, T *outputs,
+                                      size_t maxSamples, size_t &count) {
+    count = 0;
+    const char* position = begin;
+    while (count<maxSamples && position<end && error.empty()){
+        // skip blank lines such as the one at the end of the file
+        const char* inEnd = findLineEnd(position, end);
+        if (inEnd != end && skipSpaces(position, inEnd) == inEnd){
+            position = inEnd+1;
+            lineNumber++;
+            continue;
+        }
+
+        // both lines of the sample have to be in the buffer, otherwise leave it for when more of the file is read
+        const char* outEnd = inEnd == end ? end : findLineEnd(inEnd+1, end);
+        if (outEnd == end && !endOfData)
+            break;
+        if (inEnd == end){
+            if (skipSpaces(position, end) != end)
+                fail("missing Out: line");
+            break;
+        }
+
+        if (!parseLine(position, inEnd, "In:", inputs+count*numInputs, numInputs))
+            break;
+        lineNumber++;
+        if (!parseLine(inEnd+1, outEnd, "Out:", outputs+count*numOutputs, numOutputs))
+            break;
+        lineNumber++;
+        count++;
+        position = outEnd == end ? end : outEnd+1;
+    }
+    return position;
+}
+
+template<typename T>
+bool TrainingDataParser::parseLine(const char *line, const char *lineEnd, const char *label, T *row, size_t count) {
+    size_t labelLength = std::strlen(label);
+    if ((size_t)(lineEnd-line)<labelLength || std::memcmp(line, label, labelLength) != 0){
+        fail(std::string("expected ")+label);
+        return false;
+    }
+    const char* position = line+labelLength;
+    for (size_t value = 0; value<count; value++){
+        position = skipSpaces(position, lineEnd);
+        std::from_chars_result result = std::from_chars(position, lineEnd, row[value]);
+        if (result.ec != std::errc()){
+            fail("expected "+std::to_string(count)+" values after "+label+" but found "+std::to_string(value));
+            return false;
+        }
+        position = skipSpaces(result.ptr, lineEnd);
+        // every value but the last is followed by a comma
+        if (value+1<count && (position == lineEnd || *position++ != ',')){
+            fail("expected "+std::to_string(count)+" values after "+label+" but found "+std::to_string(value+1));
+            return false;
+        }
+    }
+    if (position != lineEnd){
+        fail("more than "+std::to_string(count)+" values after "+label);
+        return false;
+    }
+    return true;
+}
+
+void TrainingDataParser::fail(const std::string &message) {
+    error = "line "+std::to_string(lineNumber)+": "+message;
+}
+
+bool TrainingDataParser::failed() const {
+    return !error.empty();
+}
+
+const std::string &TrainingDataParser::getError() const {
+    return error;
+}
+
+size_t TrainingDataParser::getLineNumber() const {
+    return lineNumber;
+}
+
+void TrainingDataParser::reset(size_t firstLine) {
+    lineNumber = firstLine;
+    error.clear();
+}
+
+// the parser can fill rows of either precision
+template const char* TrainingDataParser::parse<double>(const char*, const char*, bool, double*, double*, size_t,
+                                                       size_t&);
+template const char* TrainingDataParser::parse<float>(const char*, const char*, bool, float*, float*, size_t,
+                                                      size_t&);
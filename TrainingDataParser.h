@@ -0,0 +1,54 @@
+
+#ifndef NEURALNETWORK_TRAININGDATAPARSER_H
+#define NEURALNETWORK_TRAININGDATAPARSER_H
+
+#include <string>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Training Data Parser
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Parses the "In:"/"Out:" text format of the training data straight out of a buffer holding the file.
+ *                  Nothing is copied or allocated while parsing, the numbers are read in place with from_chars and
+ *                  written directly into rows of samples, and every line is checked to have as many values as the
+ *                  topology says it should
+ ***********************************************************/
+
+class TrainingDataParser {
+public:
+    // a parser for samples with the given number of inputs and outputs whose first line is at the given line number
+    TrainingDataParser(size_t numInputs, size_t numOutputs, size_t firstLine);
+
+    // parse the "Topology: 2,4,1" line from the start of the buffer and return where the line ends, returns nullptr
+    // if it is not a valid topology
+    static const char* parseTopology(const char* begin, const char* end, std::vector<int>& topology);
+
+    // parse up to the given number of samples from the buffer into the rows, a sample which is cut off by the end of
+    // the buffer is left for the next call unless the end of the buffer is the end of the data, returns where parsing
+    // stopped and sets the number of samples parsed
+    template<typename T>
+    const char* parse(const char* begin, const char* end, bool endOfData, T* inputs, T* outputs, size_t maxSamples,
+                      size_t& count);
+
+    // whether a line could not be parsed and what was wrong with it
+    bool failed() const;
+    const std::string& getError() const;
+    // the line number of the next line to be parsed
+    size_t getLineNumber() const;
+    // start again from the given line number forgetting any error
+    void reset(size_t firstLine);
+
+private:
+    // parse a line made of a label followed by the given number of comma separated values
+    template<typename T>
+    bool parseLine(const char* line, const char* lineEnd, const char* label, T* row, size_t count);
+    // record the error for the current line
+    void fail(const std::string& message);
+
+    size_t numInputs, numOutputs, lineNumber;
+    std::string error;
+};
+
+
+#endif //NEURALNETWORK_TRAININGDATAPARSER_H
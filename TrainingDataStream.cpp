@@ -0,0 +1,129 @@
+
+#include "TrainingDataStream.h"
+#include <algorithm>
+
+TrainingDataStream::TrainingDataStream(std::string fileName, size_t memoryLimit, bool prefetch) : prefetch(prefetch) {
+    file.open(fileName, std::fstream::in | std::fstream::binary);
+    if (!file)
+        return;
+
+    // read the topology from the first line, "Topology: 2,4,1"
+    std::string line;
+    std::getline(file, line);
+    if (!TrainingDataParser::parseTopology(line.data(), line.data()+line.size(), topology)){
+        error = "line 1: expected Topology: followed by the size of every layer";
+        return;
+    }
+    numInputs = (size_t)topology.front();
+    numOutputs = (size_t)topology.back();
+    dataStart = file.tellg();
+    parser.reset(new TrainingDataParser(numInputs, numOutputs, 2));
+
+    // both chunks and the text buffer have to fit in the memory limit together
+    size_t sampleSize = (numInputs+numOutputs)*sizeof(double);
+    chunkSize = std::max<size_t>(1, (memoryLimit-std::min(memoryLimit, textSize))/(2*sampleSize));
+    text.resize(textSize);
+    for (TrainingChunk& chunk:chunks){
+        chunk.inputs.resize(chunkSize*numInputs);
+        chunk.outputs.resize(chunkSize*numOutputs);
+    }
+    startRead();
+}
+
+TrainingDataStream::~TrainingDataStream() {
+    // wait for the background read to finish before the chunks go away
+    if (pendingRead.valid())
+        pendingRead.wait();
+}
+
+bool TrainingDataStream::isOpen() const {
+    return chunkSize>0;
+}
+
+const std::vector<int> &TrainingDataStream::getTopology() const {
+    return topology;
+}
+
+size_t TrainingDataStream::getChunkSize() const {
+    return chunkSize;
+}
+
+const std::string &TrainingDataStream::getError() const {
+    return error;
+}
+
+// begin reading the chunk that is not being used, in the background when prefetching
+void TrainingDataStream::startRead() {
+    if (prefetch)
+        pendingRead = std::async(std::launch::async, [this]{ readChunk(chunks[filling]); });
+}
+
+const TrainingChunk *TrainingDataStream::nextChunk() {
+    if (chunkSize == 0)
+        return nullptr;
+    // without prefetching the chunk is read right now
+    if (!prefetch){
+        if (!error.empty())
+            return nullptr;
+        readChunk(chunks[0]);
+        return chunks[0].count>0 && error.empty() ? &chunks[0] : nullptr;
+    }
+
+    // nothing is being read once the end of the file has been reached, the error is only looked at once the read that
+    // may have set it has finished
+    if (!pendingRead.valid())
+        return nullptr;
+    pendingRead.get();
+    size_t ready = filling;
+    if (chunks[ready].count == 0 || !error.empty())
+        return nullptr;
+    // the chunk handed out on the last call is finished with so the next read can go into it
+    filling = ready^1;
+    startRead();
+    return &chunks[ready];
+}
+
+void TrainingDataStream::rewind() {
+    if (chunkSize == 0)
+        return;
+    if (pendingRead.valid())
+        pendingRead.wait();
+    file.clear();
+    file.seekg(dataStart);
+    textStart = textEnd = 0;
+    endOfFile = false;
+    parser->reset(2);
+    error.clear();
+    filling = 0;
+    startRead();
+}
+
+void TrainingDataStream::readChunk(TrainingChunk &chunk) {
+    chunk.count = 0;
+    while (chunk.count<chunkSize){
+        // parse as many samples as are in the text read so far
+        size_t parsed;
+        const char* stop = parser->parse(text.data()+textStart, text.data()+textEnd, endOfFile,
+                                         chunk.inputs.data()+chunk.count*numInputs,
+                                         chunk.outputs.data()+chunk.count*numOutputs, chunkSize-chunk.count, parsed);
+        chunk.count += parsed;
+        textStart = stop-text.data();
+        if (parser->failed()){
+            error = parser->getError();
+            return;
+        }
+        if (chunk.count == chunkSize || endOfFile)
+            return;
+
+        // move the sample that was cut off to the front of the buffer and fill the rest from the file, growing the
+        // buffer if a single sample does not fit in it
+        size_t leftover = textEnd-textStart;
+        std::copy(text.begin()+textStart, text.begin()+textEnd, text.begin());
+        if (leftover == text.size())
+            text.resize(text.size()*2);
+        file.read(text.data()+leftover, text.size()-leftover);
+        textStart = 0;
+        textEnd = leftover+(size_t)file.gcount();
+        endOfFile = file.eof() || file.gcount() == 0;
+    }
+}
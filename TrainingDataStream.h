@@ -0,0 +1,82 @@
+
+#ifndef NEURALNETWORK_TRAININGDATASTREAM_H
+#define NEURALNETWORK_TRAININGDATASTREAM_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <future>
+#include <memory>
+#include "TrainingDataParser.h"
+
+/**********************************************************
+ * Program	:  Training Data Stream
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Reads a training data file a chunk of samples at a time instead of all at once so files much bigger
+ *                  than the memory of the machine can be trained on. Only two chunks ever exist, one being trained on
+ *                  and one being read on a background thread, and they are reused for the whole file
+ ***********************************************************/
+
+// a chunk of samples stored in flat rows, one row of inputs and one row of outputs per sample
+struct TrainingChunk {
+    std::vector<double> inputs;
+    std::vector<double> outputs;
+    // the number of samples in the chunk
+    size_t count = 0;
+};
+
+class TrainingDataStream {
+public:
+    // open the file keeping the two chunks and the text being parsed within the memory limit in bytes, the next chunk is read on a background
+    // thread while the current one is used unless prefetching is turned off
+    TrainingDataStream(std::string fileName, size_t memoryLimit, bool prefetch = true);
+    ~TrainingDataStream();
+
+    // whether the file was opened and its topology read
+    bool isOpen() const;
+    // the topology written at the top of the file
+    const std::vector<int>& getTopology() const;
+    // the number of samples in a full chunk
+    size_t getChunkSize() const;
+    // get the next chunk of samples, it stays valid until the next call, returns nullptr at the end of the file or if
+    // a line could not be read
+    const TrainingChunk* nextChunk();
+    // go back to the first sample of the file to start another pass over it
+    void rewind();
+    // a description of the line that could not be read, empty if there was no error, only valid once nextChunk has
+    // returned nullptr
+    const std::string& getError() const;
+
+private:
+    // read up to a chunk worth of samples from the file into the given chunk
+    void readChunk(TrainingChunk& chunk);
+    // start reading the chunk after the current one
+    void startRead();
+
+    std::fstream file;
+    std::vector<int> topology;
+    size_t numInputs = 0, numOutputs = 0, chunkSize = 0;
+    bool prefetch;
+    // where the samples start in the file
+    std::streampos dataStart;
+    // parses the samples out of the text read from the file
+    std::unique_ptr<TrainingDataParser> parser;
+    std::string error;
+
+    // the text read from the file but not parsed yet is between the start and end of the buffer
+    std::vector<char> text;
+    size_t textStart = 0, textEnd = 0;
+    bool endOfFile = false;
+
+    // the two chunks used in turn and the one being filled by the next read
+    TrainingChunk chunks[2];
+    size_t filling = 0;
+    // the chunk being read in the background
+    std::future<void> pendingRead;
+    // the size of the buffer the file is read into
+    constexpr static size_t textSize = 256*1024;
+};
+
+
+#endif //NEURALNETWORK_TRAININGDATASTREAM_H
@@ -0,0 +1,127 @@
+
+#include "WorkStealingPool.h"
+
+// pack and unpack the first and end index of a range
+static uint64_t packRange(uint64_t first, uint64_t end) {
+    return first | end<<32;
+}
+
+static uint64_t rangeFirst(uint64_t range) {
+    return range & 0xFFFFFFFF;
+}
+
+static uint64_t rangeEnd(uint64_t range) {
+    return range>>32;
+}
+
+// start a thread for every worker but the first which is the calling thread
+WorkStealingPool::WorkStealingPool(size_t numThreads) : numThreads(numThreads) {
+    if (this->numThreads == 0)
+        this->numThreads = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    ranges.reset(new TaskRange[this->numThreads]);
+    for (size_t worker = 1; worker<this->numThreads; worker++)
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+}
+
+// tell the threads to stop and wait for them to exit
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+    for (std::thread& thread:threads)
+        thread.join();
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t)> &task) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> turn(runMutex);
+    // the indices of a range are 32 bits so a bigger job is run as several
+    constexpr size_t largestJob = 0xFFFFFFFF;
+    for (size_t first = 0; first<count; first += largestJob){
+        size_t jobSize = std::min(count-first, largestJob);
+        std::function<void(size_t)> offsetTask;
+        if (first)
+            offsetTask = [&](size_t index){ task(first+index); };
+        const std::function<void(size_t)>& current = first ? offsetTask : task;
+        for (size_t worker = 0; worker<numThreads; worker++)
+            ranges[worker].range.store(packRange(jobSize*worker/numThreads, jobSize*(worker+1)/numThreads),
+                                       std::memory_order_relaxed);
+        if (threads.empty()){
+            work(0, current);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &current;
+            pendingWorkers = threads.size();
+            generation++;
+        }
+        jobStarted.notify_all();
+        work(0, current);
+        std::unique_lock<std::mutex> lock(mutex);
+        jobFinished.wait(lock, [&]{ return pendingWorkers == 0; });
+    }
+}
+
+size_t WorkStealingPool::getNumThreads() const {
+    return numThreads;
+}
+
+void WorkStealingPool::work(size_t worker, const std::function<void(size_t)> &task) {
+    std::atomic<uint64_t>& own = ranges[worker].range;
+    while (true){
+        // take tasks from the front of the thread's own range
+        uint64_t range = own.load(std::memory_order_acquire);
+        while (rangeFirst(range)<rangeEnd(range)){
+            if (own.compare_exchange_weak(range, packRange(rangeFirst(range)+1, rangeEnd(range)),
+                                          std::memory_order_acq_rel)){
+                task(rangeFirst(range));
+                range = own.load(std::memory_order_acquire);
+            }
+        }
+
+        // steal the back half of the first range with anything left, starting from the next thread along
+        bool stole = false;
+        for (size_t offset = 1; offset<numThreads && !stole; offset++){
+            std::atomic<uint64_t>& victim = ranges[(worker+offset)%numThreads].range;
+            uint64_t victimRange = victim.load(std::memory_order_acquire);
+            while (rangeFirst(victimRange)<rangeEnd(victimRange)){
+                uint64_t first = rangeFirst(victimRange), end = rangeEnd(victimRange);
+                uint64_t middle = end-(end-first+1)/2;
+                if (victim.compare_exchange_weak(victimRange, packRange(first, middle), std::memory_order_acq_rel)){
+                    // only this thread takes from its own range while it is empty so the stolen run can be stored
+                    own.store(packRange(middle, end), std::memory_order_release);
+                    stole = true;
+                    break;
+                }
+            }
+        }
+        // every range was empty, tasks stolen by another thread are run by that thread
+        if (!stole) return;
+    }
+}
+
+// wait for a job, run it and report back until the pool is destroyed
+void WorkStealingPool::workerLoop(size_t worker) {
+    size_t lastGeneration = 0;
+    while (true){
+        for (size_t spin = 0; spin<spinLimit && generation.load() == lastGeneration && !stopping; spin++)
+            std::this_thread::yield();
+        const std::function<void(size_t)>* currentJob;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobStarted.wait(lock, [&]{ return stopping || generation != lastGeneration; });
+            if (stopping) return;
+            lastGeneration = generation;
+            currentJob = job;
+        }
+        work(worker, *currentJob);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingWorkers == 0)
+                jobFinished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+
+#ifndef NEURALNETWORK_WORKSTEALINGPOOL_H
+#define NEURALNETWORK_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Work Stealing Pool
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Threads kept running for the life of the pool that split the work of a single call between them,
+ *                  used to run the neurons of one wide layer on every core. A job is a count of tasks; every thread
+ *                  starts on its own even run of them and once that is done steals half of what is left of another
+ *                  thread's run, so a thread slowed down by the rest of the machine holds nobody up. The calling
+ *                  thread works as the first thread of the pool. Layers follow each other within microseconds so the
+ *                  threads spin for a moment after a job before going to sleep
+ ***********************************************************/
+
+class WorkStealingPool {
+public:
+    // create a pool with the given number of threads including the calling thread, zero uses every core
+    explicit WorkStealingPool(size_t numThreads = 0);
+    // stops the threads
+    ~WorkStealingPool();
+    // the threads hold a pointer to the pool so it cannot be copied
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // call the task with every index below the count spread over the threads and return once all of them are done,
+    // callers sharing a pool take turns
+    void run(size_t count, const std::function<void(size_t)>& task);
+    // the number of threads running the tasks including the calling thread
+    size_t getNumThreads() const;
+
+private:
+    // the run of tasks a thread has left, the first index in the low 32 bits and the end in the high 32 so the owner
+    // and thieves can both take from it with one compare and swap. Each is on its own cache line
+    struct alignas(64) TaskRange {
+        std::atomic<uint64_t> range{0};
+    };
+
+    // run the tasks of a thread's own range and then steal from the others until every range is empty
+    void work(size_t worker, const std::function<void(size_t)>& task);
+    // loop run by every thread but the calling one waiting for jobs
+    void workerLoop(size_t worker);
+
+    std::unique_ptr<TaskRange[]> ranges;
+    size_t numThreads;
+    std::vector<std::thread> threads;
+
+    // held by the caller whose job is running
+    std::mutex runMutex;
+    // state shared with the threads to hand out jobs
+    std::mutex mutex;
+    std::condition_variable jobStarted, jobFinished;
+    const std::function<void(size_t)>* job = nullptr;
+    std::atomic<size_t> generation{0};
+    size_t pendingWorkers = 0;
+    std::atomic<bool> stopping{false};
+    // the times a thread checks for a new job before going to sleep
+    constexpr static size_t spinLimit = 4096;
+};
+
+
+#endif //NEURALNETWORK_WORKSTEALINGPOOL_H
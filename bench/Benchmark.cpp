@@ -0,0 +1,321 @@
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <thread>
+#include <json/json.h>
+#include <unistd.h>
+
+BenchmarkState::BenchmarkState(size_t iterations, std::vector<int64_t> arguments) :
+        iterations(iterations), remaining(iterations), arguments(std::move(arguments)) {}
+
+bool BenchmarkState::keepRunning() {
+    if (!started){
+        started = true;
+        resumeTiming();
+    }
+    if (remaining>0 && error.empty()){
+        remaining--;
+        return true;
+    }
+    if (running)
+        pauseTiming();
+    return false;
+}
+
+void BenchmarkState::pauseTiming() {
+    realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-realStart).count();
+    cpuSeconds += (double)(std::clock()-cpuStart)/CLOCKS_PER_SEC;
+    running = false;
+}
+
+void BenchmarkState::resumeTiming() {
+    running = true;
+    cpuStart = std::clock();
+    realStart = std::chrono::steady_clock::now();
+}
+
+const std::vector<int64_t>& BenchmarkState::getArguments() const {
+    return arguments;
+}
+
+int64_t BenchmarkState::argument(size_t index) const {
+    return arguments.at(index);
+}
+
+size_t BenchmarkState::getIterations() const {
+    return iterations;
+}
+
+void BenchmarkState::setItemsProcessed(double items) {
+    this->items = items;
+}
+
+void BenchmarkState::setBytesProcessed(double bytes) {
+    this->bytes = bytes;
+}
+
+void BenchmarkState::setCounter(const std::string &name, double value) {
+    counters[name] = value;
+}
+
+void BenchmarkState::skipWithError(const std::string &message) {
+    error = message;
+}
+
+Benchmark::Benchmark(std::string name, std::function<void(BenchmarkState&)> function) :
+        name(std::move(name)), function(std::move(function)) {}
+
+Benchmark* Benchmark::args(std::vector<int64_t> arguments) {
+    this->arguments.push_back(std::move(arguments));
+    return this;
+}
+
+Benchmark* Benchmark::apply(void (*addArguments)(Benchmark*)) {
+    addArguments(this);
+    return this;
+}
+
+const std::string& Benchmark::getName() const {
+    return name;
+}
+
+const std::function<void(BenchmarkState&)>& Benchmark::getFunction() const {
+    return function;
+}
+
+const std::vector<std::vector<int64_t>>& Benchmark::getArguments() const {
+    return arguments;
+}
+
+// the registry is made on first use so benchmarks registered from any file's statics find it
+static std::vector<std::unique_ptr<Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+Benchmark* registerBenchmark(const std::string &name, std::function<void(BenchmarkState&)> function) {
+    registry().emplace_back(new Benchmark(name, std::move(function)));
+    return registry().back().get();
+}
+
+// the timings of one run of a benchmark, with the times per iteration in nanoseconds
+struct BenchmarkResult {
+    std::string name, error;
+    size_t iterations;
+    double realTime, cpuTime;
+    double itemsPerSecond, bytesPerSecond;
+    std::map<std::string, double> counters;
+};
+
+class BenchmarkRunner {
+public:
+    // run the benchmark with more and more iterations until it has run for at least the minimum time
+    static BenchmarkResult run(const Benchmark& benchmark, const std::vector<int64_t>& arguments, double minTime) {
+        BenchmarkResult result;
+        result.name = benchmark.getName();
+        for (int64_t argument:arguments)
+            result.name += "/"+std::to_string(argument);
+
+        size_t iterations = 1;
+        while (true){
+            BenchmarkState state(iterations, arguments);
+            benchmark.getFunction()(state);
+            if (!state.error.empty()){
+                result.error = state.error;
+                return result;
+            }
+            // stop once the run was long enough or the iterations cannot grow any further
+            if (state.realSeconds>=minTime || iterations>=maxIterations){
+                result.iterations = iterations;
+                result.realTime = state.realSeconds*1e9/iterations;
+                result.cpuTime = state.cpuSeconds*1e9/iterations;
+                result.itemsPerSecond = state.realSeconds>0 ? state.items/state.realSeconds : 0;
+                result.bytesPerSecond = state.realSeconds>0 ? state.bytes/state.realSeconds : 0;
+                result.counters = state.counters;
+                return result;
+            }
+            // aim a little past the minimum time from how long this run took but never grow more than tenfold
+            double scale = state.realSeconds>0 ? minTime*1.4/state.realSeconds : 10;
+            iterations = std::min(maxIterations, std::max(iterations+1, (size_t)(iterations*std::min(scale, 10.0))));
+        }
+    }
+
+private:
+    constexpr static size_t maxIterations = 1000000000;
+};
+
+// the value of a "--flag=value" argument, returns false if the argument is not that flag
+static bool flagValue(const std::string& argument, const std::string& flag, std::string& value) {
+    std::string prefix = "--"+flag+"=";
+    if (argument.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    value = argument.substr(prefix.size());
+    return true;
+}
+
+// a rate such as items per second written with a unit prefix
+static std::string humanRate(double rate, const std::string& unit) {
+    const char* prefixes[] = {"", "k", "M", "G", "T"};
+    size_t prefix = 0;
+    while (rate>=1000 && prefix<4){
+        rate /= 1000;
+        prefix++;
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.4g%s%s/s", rate, prefixes[prefix], unit.c_str());
+    return buffer;
+}
+
+static void printHeader(std::ostream& stream, size_t width) {
+    char line[512];
+    std::snprintf(line, sizeof(line), "%-*s %15s %15s %12s", (int)width, "Benchmark", "Time", "CPU", "Iterations");
+    stream<<line<<"\n"<<std::string(width+45, '-')<<std::endl;
+}
+
+static void printResult(std::ostream& stream, const BenchmarkResult& result, size_t width) {
+    char line[512];
+    if (!result.error.empty()){
+        std::snprintf(line, sizeof(line), "%-*s ERROR: %s", (int)width, result.name.c_str(), result.error.c_str());
+        stream<<line<<std::endl;
+        return;
+    }
+    std::snprintf(line, sizeof(line), "%-*s %12.0f ns %12.0f ns %12zu", (int)width, result.name.c_str(),
+                  result.realTime, result.cpuTime, result.iterations);
+    stream<<line;
+    if (result.bytesPerSecond>0)
+        stream<<" "<<humanRate(result.bytesPerSecond, "B");
+    if (result.itemsPerSecond>0)
+        stream<<" "<<humanRate(result.itemsPerSecond, " items");
+    for (const std::pair<const std::string, double>& counter:result.counters)
+        stream<<" "<<counter.first<<"="<<counter.second;
+    stream<<std::endl;
+}
+
+// the same layout as Google Benchmark's --benchmark_format=json
+static Json::Value resultsToJson(const std::vector<BenchmarkResult>& results) {
+    Json::Value ret;
+    char hostName[256] = {};
+    gethostname(hostName, sizeof(hostName)-1);
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    ret["context"]["date"] = date;
+    ret["context"]["host_name"] = hostName;
+    ret["context"]["executable"] = "nn_bench";
+    ret["context"]["num_cpus"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+    ret["context"]["library_build_type"] = "release";
+#else
+    ret["context"]["library_build_type"] = "debug";
+#endif
+
+    ret["benchmarks"] = Json::Value(Json::arrayValue);
+    for (const BenchmarkResult& result:results){
+        Json::Value benchmark;
+        benchmark["name"] = result.name;
+        benchmark["run_name"] = result.name;
+        benchmark["run_type"] = "iteration";
+        if (!result.error.empty()){
+            benchmark["error_occurred"] = true;
+            benchmark["error_message"] = result.error;
+            ret["benchmarks"].append(benchmark);
+            continue;
+        }
+        benchmark["iterations"] = (Json::UInt64)result.iterations;
+        benchmark["real_time"] = result.realTime;
+        benchmark["cpu_time"] = result.cpuTime;
+        benchmark["time_unit"] = "ns";
+        if (result.bytesPerSecond>0)
+            benchmark["bytes_per_second"] = result.bytesPerSecond;
+        if (result.itemsPerSecond>0)
+            benchmark["items_per_second"] = result.itemsPerSecond;
+        for (const std::pair<const std::string, double>& counter:result.counters)
+            benchmark[counter.first] = counter.second;
+        ret["benchmarks"].append(benchmark);
+    }
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    std::string filter = ".", format = "console", outputFile, value;
+    double minTime = 0.5;
+    bool list = false;
+    for (int index = 1; index<argc; index++){
+        std::string argument = argv[index];
+        if (flagValue(argument, "benchmark_filter", value))
+            filter = value;
+        else if (flagValue(argument, "benchmark_min_time", value))
+            minTime = std::stod(value);
+        else if (flagValue(argument, "benchmark_format", value))
+            format = value;
+        else if (flagValue(argument, "benchmark_out", value))
+            outputFile = value;
+        else if (argument == "--benchmark_list_tests")
+            list = true;
+        else {
+            std::cerr<<"Usage: "<<argv[0]<<" [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] "
+                     <<"[--benchmark_format=console|json] [--benchmark_out=<file>] [--benchmark_list_tests]"<<std::endl;
+            return 1;
+        }
+    }
+    if (format != "console" && format != "json"){
+        std::cerr<<"Unknown format "<<format<<std::endl;
+        return 1;
+    }
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error&){
+        std::cerr<<"Invalid filter "<<filter<<std::endl;
+        return 1;
+    }
+
+    // find every run that matches the filter, one for every argument list a benchmark was given
+    std::vector<std::pair<const Benchmark*, std::vector<int64_t>>> runs;
+    size_t width = 9;
+    for (const std::unique_ptr<Benchmark>& benchmark:registry()){
+        std::vector<std::vector<int64_t>> argumentLists = benchmark->getArguments();
+        if (argumentLists.empty())
+            argumentLists.emplace_back();
+        for (const std::vector<int64_t>& arguments:argumentLists){
+            std::string name = benchmark->getName();
+            for (int64_t argument:arguments)
+                name += "/"+std::to_string(argument);
+            if (!std::regex_search(name, pattern))
+                continue;
+            if (list)
+                std::cout<<name<<"\n";
+            runs.emplace_back(benchmark.get(), arguments);
+            width = std::max(width, name.size());
+        }
+    }
+    if (list)
+        return 0;
+
+    // the table is printed as the runs finish so long suites show their progress
+    std::vector<BenchmarkResult> results;
+    if (format == "console")
+        printHeader(std::cout, width);
+    for (const std::pair<const Benchmark*, std::vector<int64_t>>& run:runs){
+        results.push_back(BenchmarkRunner::run(*run.first, run.second, minTime));
+        if (format == "console")
+            printResult(std::cout, results.back(), width);
+    }
+    if (format == "json")
+        std::cout<<resultsToJson(results)<<std::endl;
+    if (!outputFile.empty()){
+        std::ofstream output(outputFile);
+        if (!output){
+            std::cerr<<"Could not open "<<outputFile<<std::endl;
+            return 1;
+        }
+        output<<resultsToJson(results)<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+
+#ifndef NEURALNETWORK_BENCHMARK_H
+#define NEURALNETWORK_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**********************************************************
+ * Program	:  Benchmark
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: A small benchmark harness laid out like Google Benchmark so its results can be read by the same
+ *                  tools. Every benchmark is a function run with a list of arguments, it loops while the state says
+ *                  to keep running and the harness keeps doubling the number of iterations until the loop has run
+ *                  for the minimum time. The results are printed as a table or written as Google Benchmark's JSON
+ ***********************************************************/
+
+class BenchmarkState {
+public:
+    BenchmarkState(size_t iterations, std::vector<int64_t> arguments);
+
+    // true until the loop has run every iteration, the timer starts on the first call and stops on the last
+    bool keepRunning();
+    // leave setup inside the loop out of the timings
+    void pauseTiming();
+    void resumeTiming();
+
+    const std::vector<int64_t>& getArguments() const;
+    int64_t argument(size_t index) const;
+    size_t getIterations() const;
+
+    // the amount of work done over every iteration, reported per second
+    void setItemsProcessed(double items);
+    void setBytesProcessed(double bytes);
+    // any other number to report along with the timings
+    void setCounter(const std::string& name, double value);
+    // mark the run as failed, the loop stops and the message is reported instead of the timings
+    void skipWithError(const std::string& message);
+
+private:
+    friend class BenchmarkRunner;
+    size_t iterations, remaining;
+    std::vector<int64_t> arguments;
+    bool started = false, running = false;
+    std::chrono::steady_clock::time_point realStart;
+    std::clock_t cpuStart = 0;
+    double realSeconds = 0, cpuSeconds = 0;
+    double items = 0, bytes = 0;
+    std::map<std::string, double> counters;
+    std::string error;
+};
+
+// a benchmark and the argument lists it is run with, each list becomes a run named "<name>/<arg>/<arg>..."
+class Benchmark {
+public:
+    Benchmark(std::string name, std::function<void(BenchmarkState&)> function);
+    Benchmark* args(std::vector<int64_t> arguments);
+    // add the arguments of a sweep shared by several benchmarks
+    Benchmark* apply(void (*addArguments)(Benchmark*));
+
+    const std::string& getName() const;
+    const std::function<void(BenchmarkState&)>& getFunction() const;
+    const std::vector<std::vector<int64_t>>& getArguments() const;
+
+private:
+    std::string name;
+    std::function<void(BenchmarkState&)> function;
+    std::vector<std::vector<int64_t>> arguments;
+};
+
+// add a benchmark to those run by main, the returned benchmark is owned by the registry
+Benchmark* registerBenchmark(const std::string& name, std::function<void(BenchmarkState&)> function);
+
+// register a function as a benchmark from the file it is written in
+#define BENCHMARK_CONCAT(a, b) a##b
+#define BENCHMARK_NAME(line) BENCHMARK_CONCAT(benchmark_, line)
+#define BENCHMARK(function) static Benchmark* BENCHMARK_NAME(__LINE__) = registerBenchmark(#function, function)
+
+// keep the compiler from throwing away a value that is computed only to be timed
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+#endif //NEURALNETWORK_BENCHMARK_H
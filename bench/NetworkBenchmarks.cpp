@@ -0,0 +1,303 @@
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <json/json.h>
+#include <unistd.h>
+#include "Benchmark.h"
+#include "FixedNetwork.h"
+#include "Model.h"
+#include "NeuralNetwork.h"
+#include "ParallelTrainer.h"
+#include "Pruning.h"
+#include "SparseModel.h"
+#include "TrainingData.h"
+
+/**********************************************************
+ * Program	:  Network Benchmarks
+ * Author	:  Braydn Moore
+ * Due Date	:  I have lost track of all measures of time so I have zero clue
+ * Description	: Times the hot paths of the network over a sweep of topologies from the xor network up to wide
+ *                  layers, from a single feed forward to whole epochs of training and batches of inference. Every
+ *                  benchmark takes the topology as its arguments so "FeedForward/64/128/64/10" runs a network with
+ *                  those layers
+ ***********************************************************/
+
+// the number of samples in the data of the training, parsing and inference benchmarks
+static constexpr size_t numSamples = 4096;
+static constexpr size_t batchSize = 32;
+
+// the topology of a benchmark's network from its arguments
+static std::vector<int> topologyOf(const BenchmarkState& state) {
+    return std::vector<int>(state.getArguments().begin(), state.getArguments().end());
+}
+
+// the number of weights in a network with the topology, including the bias of every layer
+static size_t numWeights(const std::vector<int>& topology) {
+    size_t count = 0;
+    for (size_t layer = 1; layer<topology.size(); layer++)
+        count += (size_t)topology[layer]*(topology[layer-1]+1);
+    return count;
+}
+
+// random values between 0 and 1 from a fixed seed so every run sees the same data
+static std::vector<double> randomValues(size_t count, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    std::vector<double> values(count);
+    for (double& value:values)
+        value = distribution(generator);
+    return values;
+}
+
+// add every topology in the sweep to a benchmark
+static void topologies(Benchmark* benchmark) {
+    benchmark->args({2, 4, 1})->args({16, 32, 1})->args({64, 128, 64, 10})->args({256, 512, 256, 10});
+}
+
+// a training data file of random samples for the topology, removed again when the benchmark ends
+class TrainingFile {
+public:
+    explicit TrainingFile(const std::vector<int>& topology) {
+        char path[] = "/tmp/nn_bench_XXXXXX";
+        int descriptor = mkstemp(path);
+        if (descriptor>=0)
+            close(descriptor);
+        name = path;
+        std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+        std::vector<double> outputs = randomValues(numSamples*topology.back(), 2);
+        std::ofstream file(name);
+        file.precision(17);
+        file<<"Topology: ";
+        for (size_t layer = 0; layer<topology.size(); layer++)
+            file<<(layer ? "," : "")<<topology[layer];
+        for (size_t sample = 0; sample<numSamples; sample++){
+            file<<"\nIn: ";
+            for (int input = 0; input<topology.front(); input++)
+                file<<(input ? "," : "")<<inputs[sample*topology.front()+input];
+            file<<"\nOut: ";
+            for (int output = 0; output<topology.back(); output++)
+                file<<(output ? "," : "")<<outputs[sample*topology.back()+output];
+        }
+        file<<"\n";
+        size = (size_t)file.tellp();
+    }
+    ~TrainingFile() {
+        std::remove(name.c_str());
+    }
+
+    std::string name;
+    size_t size = 0;
+};
+
+// one sample forward through the network
+static void FeedForward(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    NeuralNetwork network(topology);
+    std::vector<double> inputs = randomValues((size_t)topology.front(), 1), results;
+    while (state.keepRunning()){
+        network.feedForward(inputs);
+        network.getResults(results);
+        doNotOptimize(results.data());
+    }
+    state.setItemsProcessed((double)state.getIterations());
+    state.setBytesProcessed((double)state.getIterations()*numWeights(topology)*sizeof(double));
+}
+BENCHMARK(FeedForward)->apply(topologies);
+
+// one sample forward and back through the network, the back propagation needs the outputs of the forward pass
+static void BackPropagation(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    NeuralNetwork network(topology);
+    std::vector<double> inputs = randomValues((size_t)topology.front(), 1);
+    std::vector<double> targets = randomValues((size_t)topology.back(), 2);
+    while (state.keepRunning()){
+        network.feedForward(inputs);
+        network.backPropogation(targets);
+    }
+    doNotOptimize(network.getPackedLayers().back().weights.data());
+    state.setItemsProcessed((double)state.getIterations());
+}
+BENCHMARK(BackPropagation)->apply(topologies);
+
+// a batch of samples through the batched training path
+static void TrainBatch(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    NeuralNetwork network(topology);
+    std::vector<double> inputs = randomValues(batchSize*topology.front(), 1);
+    std::vector<double> targets = randomValues(batchSize*topology.back(), 2);
+    while (state.keepRunning())
+        network.trainBatch(inputs.data(), targets.data(), batchSize);
+    doNotOptimize(network.getPackedLayers().back().weights.data());
+    state.setItemsProcessed((double)state.getIterations()*batchSize);
+}
+BENCHMARK(TrainBatch)->apply(topologies);
+
+// the network written out as json
+static void ToJson(BenchmarkState& state) {
+    NeuralNetwork network(topologyOf(state));
+    while (state.keepRunning()){
+        Json::Value json = network.toJson();
+        doNotOptimize(json);
+    }
+    state.setItemsProcessed((double)state.getIterations());
+}
+BENCHMARK(ToJson)->apply(topologies);
+
+// the json of a network parsed and turned back into a network as readNeuralNetwork does
+static void JsonLoad(BenchmarkState& state) {
+    NeuralNetwork network(topologyOf(state));
+    std::ostringstream stream;
+    stream<<network.toJson();
+    std::string text = stream.str();
+    while (state.keepRunning()){
+        Json::Value json;
+        std::istringstream input(text);
+        input>>json;
+        NeuralNetwork loaded(json);
+        doNotOptimize(loaded.getPackedLayers().data());
+    }
+    state.setItemsProcessed((double)state.getIterations());
+    state.setBytesProcessed((double)state.getIterations()*text.size());
+}
+BENCHMARK(JsonLoad)->apply(topologies);
+
+// a training data file parsed into the flat rows of a set
+static void ReadTrainingSet(BenchmarkState& state) {
+    TrainingFile file(topologyOf(state));
+    TrainingData data;
+    while (state.keepRunning()){
+        TrainingSet set;
+        if (!data.readTrainingSet(file.name, set)){
+            state.skipWithError(set.error);
+            break;
+        }
+        doNotOptimize(set.inputs.data());
+    }
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+    state.setBytesProcessed((double)state.getIterations()*file.size);
+}
+BENCHMARK(ReadTrainingSet)->apply(topologies);
+
+// a training data file parsed into a vector for every sample as the text training does
+static void ReadTrainingData(BenchmarkState& state) {
+    TrainingFile file(topologyOf(state));
+    TrainingData data;
+    while (state.keepRunning()){
+        NeuralNetworkInput input = data.readTrainingData(file.name);
+        if (!input.error.empty()){
+            state.skipWithError(input.error);
+            break;
+        }
+        doNotOptimize(input.inputs.data());
+    }
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+    state.setBytesProcessed((double)state.getIterations()*file.size);
+}
+BENCHMARK(ReadTrainingData)->apply(topologies);
+
+// a whole epoch of training on every core, the samples per second of training end to end
+static void TrainEpoch(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    NeuralNetwork network(topology);
+    ParallelTrainer trainer(network);
+    NeuralNetworkInput input;
+    input.topology = topology;
+    std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+    std::vector<double> outputs = randomValues(numSamples*topology.back(), 2);
+    for (size_t sample = 0; sample<numSamples; sample++){
+        input.inputs.emplace_back(inputs.begin()+sample*topology.front(), inputs.begin()+(sample+1)*topology.front());
+        input.outputs.emplace_back(outputs.begin()+sample*topology.back(),
+                                   outputs.begin()+(sample+1)*topology.back());
+    }
+    while (state.keepRunning())
+        trainer.train(input, batchSize);
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+    state.setCounter("threads", (double)trainer.getNumThreads());
+}
+BENCHMARK(TrainEpoch)->apply(topologies);
+
+// every sample run through the model one at a time as a single client would
+static void InferencePredict(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    Model model{NeuralNetwork(topology)};
+    Workspace workspace(model);
+    std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+    std::vector<double> outputs(numSamples*topology.back());
+    while (state.keepRunning())
+        for (size_t sample = 0; sample<numSamples; sample++)
+            model.predict(inputs.data()+sample*topology.front(), outputs.data()+sample*topology.back(), workspace);
+    doNotOptimize(outputs.data());
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+}
+BENCHMARK(InferencePredict)->apply(topologies);
+
+// every sample run through the model one at a time with the neurons of its wide layers split between every core, to
+// set against InferencePredict
+static void InferencePredictParallel(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    Model model{NeuralNetwork(topology)};
+    Workspace workspace(model);
+    workspace.pool = std::make_shared<WorkStealingPool>();
+    std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+    std::vector<double> outputs(numSamples*topology.back());
+    while (state.keepRunning())
+        for (size_t sample = 0; sample<numSamples; sample++)
+            model.predict(inputs.data()+sample*topology.front(), outputs.data()+sample*topology.back(), workspace);
+    doNotOptimize(outputs.data());
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+    state.setCounter("threads", (double)workspace.pool->getNumThreads());
+}
+BENCHMARK(InferencePredictParallel)->apply(topologies);
+
+// every sample run through the model in batches as the inference server does
+static void InferencePredictBatch(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    Model model{NeuralNetwork(topology)};
+    Workspace workspace(model);
+    std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+    std::vector<double> outputs(numSamples*topology.back());
+    while (state.keepRunning())
+        for (size_t sample = 0; sample<numSamples; sample += batchSize)
+            model.predictBatch(inputs.data()+sample*topology.front(), batchSize,
+                               outputs.data()+sample*topology.back(), workspace);
+    doNotOptimize(outputs.data());
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+}
+BENCHMARK(InferencePredictBatch)->apply(topologies);
+
+// every sample run one at a time through the xor network with its topology fixed at compile time, to set against
+// InferencePredict/2/4/1
+static void FixedNetworkPredict(BenchmarkState& state) {
+    FixedNetwork<2, 4, 1> network;
+    network.assign(NeuralNetwork(std::vector<int>{2, 4, 1}));
+    std::vector<double> inputs = randomValues(numSamples*2, 1);
+    std::vector<double> outputs(numSamples);
+    while (state.keepRunning())
+        for (size_t sample = 0; sample<numSamples; sample++)
+            network.predict(inputs.data()+sample*2, outputs.data()+sample);
+    doNotOptimize(outputs.data());
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+}
+BENCHMARK(FixedNetworkPredict);
+
+// every sample run one at a time through the network pruned to a tenth of its weights and stored as sparse rows, to
+// set against InferencePredict
+static void SparsePredict(BenchmarkState& state) {
+    std::vector<int> topology = topologyOf(state);
+    NeuralNetwork network(topology);
+    PruneSettings settings;
+    settings.keepFraction = 0.1;
+    pruneNetwork(network, settings);
+    std::shared_ptr<const SparseModel> model = sparsifyModel(Model(network));
+    Workspace workspace;
+    std::vector<double> inputs = randomValues(numSamples*topology.front(), 1);
+    std::vector<double> outputs(numSamples*topology.back());
+    while (state.keepRunning())
+        for (size_t sample = 0; sample<numSamples; sample++)
+            model->predict(inputs.data()+sample*topology.front(), outputs.data()+sample*topology.back(), workspace);
+    doNotOptimize(outputs.data());
+    state.setItemsProcessed((double)state.getIterations()*numSamples);
+}
+BENCHMARK(SparsePredict)->apply(topologies);
@@ -1,8 +1,32 @@
 #include <iostream>
+#include <chrono>
 #include <json/writer.h>
 #include <json/reader.h>
 #include "NeuralNetwork.h"
 #include "TrainingData.h"
+#include "ParallelTrainer.h"
+#include "Model.h"
+#include "ModelFile.h"
+#include "TrainingDataStream.h"
+#include "DatasetFile.h"
+#include "QuantizedModel.h"
+#include "InferenceServer.h"
+#include "LoadGenerator.h"
+#include "Profiler.h"
+#include "Sweep.h"
+#include "Checkpoint.h"
+#include "Evaluation.h"
+#include "SampleShuffler.h"
+#include "DataGenerator.h"
+#include "TrainingDataParser.h"
+#include "ModelRegistry.h"
+#include "Pruning.h"
+#include "SparseModel.h"
+#include <atomic>
+#include <csignal>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 /**********************************************************
  * Program	:  Basic Neural Network for OOP
@@ -26,6 +50,25 @@
 // change this to be any function that returns a boolean for the neural network to learn
 std::function<bool (bool, bool)> func = [](bool a, bool b) -> bool{ return (a|b)&(a^b);};
 std::string prefix = "mix";
+// the number of test cases the network is trained on before its weights are updated
+size_t batchSize = 16;
+// the number of threads used to train the network, zero uses every core
+size_t numThreads = 0;
+// the most memory in bytes the training data is allowed to take up while training
+size_t memoryLimit = 64*1024*1024;
+// the optimizer new networks are trained with
+OptimizerSettings optimizer;
+// the number of passes made over the training data
+size_t numEpochs = 1;
+// the seconds between the checkpoints written while training
+double checkpointInterval = 60;
+// the fraction of the samples held back to check the network on after every pass, zero holds none back
+double validationFraction = 0.1;
+// training stops once this many passes in a row have not improved on the best validation error, zero never stops early
+size_t patience = 3;
+// whether the samples are trained on in a new random order every pass and the seed the orders follow from
+bool shuffleSamples = true;
+uint64_t shuffleSeed = 1;
 
 
 // userful operator overloading for printing out vectors without having to loop every time
@@ -40,47 +83,348 @@ std::ostream& operator << (std::ostream& os, const std::vector<T>& vector) {
     return os;
 }
 
-// function to make a neural network and train it using the given data and save it to a given file
-void writeNeuralNetwork(std::string output, std::string data){
-    // create the file to save the neural network to
-    std::fstream neuralNetworkSave;
-    // open the file an mark as writing out
-    neuralNetworkSave.open(output, std::fstream::out);
-    // initialize the training data object
-    TrainingData trainingData;
-    // read the data into a structure to hold all the data to train the neural network
-    NeuralNetworkInput input = trainingData.readTrainingData(data);
-    // if the number of input test cases does not equal the number of outputs for the test cases then exit
-    if (input.inputs.size() != input.outputs.size()) return;
-    // create the network with the given topology from the data read in
-    NeuralNetwork network(input.topology);
+// move the run on to the given sample after training on a batch and take a checkpoint of it when one is due
+void finishBatch(const NeuralNetwork& network, TrainingProgress& progress, size_t sample, size_t count,
+                 CheckpointWriter& checkpoints){
+    progress.sample = sample;
+    progress.samplesTrained += count;
+    if (checkpoints.due())
+        checkpoints.take(network, progress);
+}
+
+// the number of samples at the end of every chunk of a text file held back from training to check the network on
+size_t numHeldBack(size_t count){
+    return (size_t)(count*validationFraction);
+}
+
+// get the next chunk of a text file, the time spent waiting here is the time the reading thread could not keep up
+const TrainingChunk* nextChunk(TrainingDataStream& input){
+    PROFILE_PHASE(ProfilePhase::DATA_LOAD);
+    return input.nextChunk();
+}
+
+// the number of samples gathered into each block of a shuffled pass, a whole number of batches filling about 256KiB so
+// the block being trained on stays in the cache
+size_t stagingSize(size_t numInputs, size_t numOutputs){
+    size_t sampleSize = (numInputs+numOutputs)*sizeof(double);
+    return std::max<size_t>(1, 256*1024/sampleSize/batchSize)*batchSize;
+}
+
+// train the network on every block a shuffler hands out, the first sample of the first block is at the given position
+// of the pass
+void trainOnStaged(ParallelTrainer& trainer, const NeuralNetwork& network, SampleShuffler& shuffler, size_t position,
+                   size_t numInputs, size_t numOutputs, TrainingProgress& progress, CheckpointWriter& checkpoints){
+    // the time spent waiting here is the time the gathering thread could not keep up with the training
+    auto nextBlock = [&]{
+        PROFILE_PHASE(ProfilePhase::DATA_LOAD);
+        return shuffler.next();
+    };
+    while (const StagedSamples* block = nextBlock()){
+        for (size_t first = 0; first<block->count; first += batchSize){
+            size_t count = std::min(batchSize, block->count-first);
+            trainer.trainBatch(block->inputs.data()+first*numInputs, block->outputs.data()+first*numOutputs, count);
+            finishBatch(network, progress, position+first+count, count, checkpoints);
+        }
+        position += block->count;
+    }
+}
+
+// train the network for one pass over a text file of test cases which is read a chunk at a time so it never has to
+// fit in memory, starting from the sample the progress is at. When shuffling the samples of every chunk are trained
+// on in an order drawn from the engine. Returns false if a test case could not be read
+bool trainOnText(ParallelTrainer& trainer, const NeuralNetwork& network, TrainingDataStream& input,
+                 std::mt19937_64& engine, TrainingProgress& progress, CheckpointWriter& checkpoints){
+    size_t numInputs = (size_t)input.getTopology().front(), numOutputs = (size_t)input.getTopology().back();
+    SampleShuffler shuffler(numInputs, numOutputs, stagingSize(numInputs, numOutputs));
+    std::vector<size_t> order;
+    // the chunks always split the file in the same places so a resumed run skips to the batch it stopped at and the
+    // same samples are held back on every pass
+    size_t chunkStart = 0;
+    while (const TrainingChunk* chunk = nextChunk(input)){
+        size_t numTraining = chunk->count-numHeldBack(chunk->count);
+        size_t first = progress.sample-std::min<size_t>(progress.sample, chunkStart);
+        if (shuffleSamples){
+            // chunks skipped by a resumed run are still shuffled so the engine is left as it was the first time
+            shuffleOrder(order, numTraining, engine);
+            shuffler.start(order.data(), numTraining, first, [chunk, numInputs, numOutputs](size_t sample,
+                                                                                           double* inputs,
+                                                                                           double* outputs){
+                std::copy_n(chunk->inputs.data()+sample*numInputs, numInputs, inputs);
+                std::copy_n(chunk->outputs.data()+sample*numOutputs, numOutputs, outputs);
+            });
+            trainOnStaged(trainer, network, shuffler, chunkStart+first, numInputs, numOutputs, progress, checkpoints);
+        }
+        else
+            for (; first<numTraining; first += batchSize){
+                size_t count = std::min(batchSize, numTraining-first);
+                trainer.trainBatch(chunk->inputs.data()+first*numInputs, chunk->outputs.data()+first*numOutputs,
+                                   count);
+                finishBatch(network, progress, chunkStart+first+count, count, checkpoints);
+            }
+        chunkStart += chunk->count;
+    }
+    return input.getError().empty();
+}
+
+// check the network on the samples held back at the end of every chunk of a text file, returns false if a test case
+// could not be read
+bool evaluateText(const NeuralNetwork& network, TrainingDataStream& input, Evaluation& evaluation){
+    size_t numInputs = (size_t)input.getTopology().front(), numOutputs = (size_t)input.getTopology().back();
+    Evaluator evaluator(network);
+    input.rewind();
+    while (const TrainingChunk* chunk = nextChunk(input)){
+        size_t first = chunk->count-numHeldBack(chunk->count);
+        evaluator.add(chunk->inputs.data()+first*numInputs, chunk->outputs.data()+first*numOutputs,
+                      chunk->count-first);
+    }
+    evaluation = evaluator.result();
+    return input.getError().empty();
+}
+
+// train the network for one pass over a binary dataset starting from the sample the progress is at, the samples at
+// the end of the dataset are held back. When shuffling the samples are gathered in an order drawn from the engine,
+// otherwise batches of doubles are used straight out of the mapped file while any other precision is converted into
+// rows of doubles first
+void trainOnDataset(ParallelTrainer& trainer, const NeuralNetwork& network, const Dataset& dataset,
+                    std::mt19937_64& engine, TrainingProgress& progress, CheckpointWriter& checkpoints){
+    size_t numTraining = dataset.getNumSamples()-numHeldBack(dataset.getNumSamples());
+    if (shuffleSamples){
+        std::vector<size_t> order;
+        shuffleOrder(order, numTraining, engine);
+        SampleShuffler shuffler(dataset.getNumInputs(), dataset.getNumOutputs(),
+                                stagingSize(dataset.getNumInputs(), dataset.getNumOutputs()));
+        shuffler.start(order.data(), numTraining, progress.sample, [&dataset](size_t sample, double* inputs,
+                                                                             double* outputs){
+            dataset.copyBatch(sample, 1, inputs, outputs);
+        });
+        trainOnStaged(trainer, network, shuffler, progress.sample, dataset.getNumInputs(), dataset.getNumOutputs(),
+                      progress, checkpoints);
+        return;
+    }
+    std::vector<double> inputs(batchSize*dataset.getNumInputs()), outputs(batchSize*dataset.getNumOutputs());
+    while (progress.sample<numTraining){
+        DatasetBatch<double> batch = dataset.getBatch<double>(progress.sample,
+                                                              std::min(batchSize, numTraining-progress.sample));
+        if (!batch.inputs){
+            PROFILE_PHASE(ProfilePhase::DATA_LOAD);
+            dataset.copyBatch(progress.sample, batch.count, inputs.data(), outputs.data());
+            batch = DatasetBatch<double>{inputs.data(), outputs.data(), batch.count};
+        }
+        trainer.trainBatch(batch.inputs, batch.outputs, batch.count);
+        finishBatch(network, progress, progress.sample+batch.count, batch.count, checkpoints);
+    }
+}
+
+// check the network on the samples held back at the end of a binary dataset
+Evaluation evaluateDataset(const NeuralNetwork& network, const Dataset& dataset){
+    constexpr size_t evaluationBatch = 1024;
+    std::vector<double> inputs(evaluationBatch*dataset.getNumInputs());
+    std::vector<double> outputs(evaluationBatch*dataset.getNumOutputs());
+    Evaluator evaluator(network);
+    for (size_t sample = dataset.getNumSamples()-numHeldBack(dataset.getNumSamples()); sample<dataset.getNumSamples();
+         sample += evaluationBatch){
+        DatasetBatch<double> batch = dataset.getBatch<double>(sample, evaluationBatch);
+        if (!batch.inputs){
+            dataset.copyBatch(sample, batch.count, inputs.data(), outputs.data());
+            batch = DatasetBatch<double>{inputs.data(), outputs.data(), batch.count};
+        }
+        evaluator.add(batch.inputs, batch.outputs, batch.count);
+    }
+    return evaluator.result();
+}
+
+// read a comma separated list of activation names, one for every layer after the input layer, returns false if a name
+// is not an activation
+bool parseActivations(const std::string& list, std::vector<Activation>& activations){
+    activations.clear();
+    for (size_t first = 0; first<=list.size();){
+        size_t last = std::min(list.find(',', first), list.size());
+        Activation activation;
+        if (!parseActivation(list.substr(first, last-first), activation)){
+            std::cerr<<list.substr(first, last-first)<<": not an activation, use one of";
+            for (size_t index = 0; index<numActivations; index++)
+                std::cerr<<" "<<activationName((Activation)index);
+            std::cerr<<std::endl;
+            return false;
+        }
+        activations.push_back(activation);
+        first = last+1;
+    }
+    return true;
+}
+
+// train the network on the data from where its run got to for the number of passes, or until the error on the held
+// back samples stops improving, writing checkpoints of it as it goes. Then save the best network to a json file for
+// debugging and a binary model file for running it
+void trainAndSave(NeuralNetwork& network, TrainingProgress& progress, std::string data, const Dataset& dataset,
+                  TrainingDataStream* input, std::string checkpointFile, std::string output, std::string binaryOutput){
     // tell them we are training using the data
     std::cout<<"Training"<<std::endl;
-    // for every test case
-    for (int counter = 0; counter<input.inputs.size(); counter++) {
-        // get the input and output vectors and initialize the vector to hold our results
-        std::vector<double> inLayer = input.inputs[counter], outLayer = input.outputs[counter];
-        std::vector<double> results;
-        // if the input or output layer's topology doesn't match the topology of the neural network then exit
-        if (inLayer.size() != input.topology[0] || outLayer.size() != input.topology[input.topology.size() - 1])
+    // "train" the network by feeding forward batches of test cases split between the threads and adjusting the
+    // weights of the connections once per batch by working backwards from the answers the network should have gotten
+    ParallelTrainer trainer(network, numThreads);
+    CheckpointWriter checkpoints(checkpointFile, checkpointInterval);
+    Profiler::instance().reset();
+    // the order of every pass is drawn from the engine, a resumed run picks it up as it was at the start of its pass
+    std::mt19937_64 engine(shuffleSeed);
+    if (!progress.randomState.empty()){
+        std::istringstream state(progress.randomState);
+        state>>engine;
+    }
+    for (bool firstPass = true; progress.epoch<numEpochs && !(patience && progress.epochsWithoutImprovement>=patience);
+         firstPass = false){
+        if (shuffleSamples){
+            std::ostringstream state;
+            state<<engine;
+            progress.randomState = state.str();
+        }
+        if (input && !firstPass)
+            input->rewind();
+        if (!input)
+            trainOnDataset(trainer, network, dataset, engine, progress, checkpoints);
+        // if a test case could not be read or doesn't match the topology of the neural network then exit
+        else if (!trainOnText(trainer, network, *input, engine, progress, checkpoints)){
+            std::cerr<<data<<": "<<input->getError()<<std::endl;
+            return;
+        }
+        progress.epoch++;
+        progress.sample = 0;
+        if (validationFraction<=0)
+            continue;
+
+        // check the network on the samples it has not been trained on to see if it is still getting better
+        Evaluation validation;
+        if (!input)
+            validation = evaluateDataset(network, dataset);
+        else if (!evaluateText(network, *input, validation)){
+            std::cerr<<data<<": "<<input->getError()<<std::endl;
             return;
-        // get the answer by following the neurons and the connections in the network using a feed forward approach
-        network.feedForward(inLayer);
-        // get the results of the feed forward access
-        network.getResults(results);
-        // "train" the network by adjusting the weights of the connections
-        // by working backwards from the answers the network should have gotten
-        network.backPropogation(outLayer);
+        }
+        std::cout<<"Pass "<<progress.epoch<<": validation rmse "<<validation.rmse<<", accuracy "
+                 <<validation.accuracy*100<<"% on "<<validation.count<<" samples"<<std::endl;
+        if (validation.count == 0)
+            continue;
+        if (validation.rmse<progress.bestError){
+            progress.bestError = validation.rmse;
+            progress.epochsWithoutImprovement = 0;
+            // keep the best network in the model file in case the passes after it do worse
+            if (progress.epoch<numEpochs){
+                if (saveModelFile(network, binaryOutput))
+                    progress.bestModelFile = binaryOutput;
+                else
+                    std::cerr<<"Could not write "<<binaryOutput<<std::endl;
+            }
+        }
+        else
+            progress.epochsWithoutImprovement++;
+    }
+    checkpoints.flush();
+    // go back to the best network when the last passes made it worse, from the file this run saved it to which is
+    // not the model file of a run resumed with another one
+    if (progress.epochsWithoutImprovement>0){
+        if (progress.epoch<numEpochs)
+            std::cout<<"Stopped early after "<<progress.epochsWithoutImprovement<<" passes without improving"
+                     <<std::endl;
+        if (!progress.bestModelFile.empty() && !loadNetworkFile(progress.bestModelFile, network))
+            std::cerr<<"Could not read the best network back from "<<progress.bestModelFile<<std::endl;
+    }
+    // tell them how well the training used the threads
+    std::cout<<"Trained on "<<trainer.getNumThreads()<<" threads at "<<trainer.getSamplesPerSecond()
+             <<" samples/s with "<<trainer.getScalingEfficiency()*100<<"% scaling efficiency"<<std::endl;
+    // when the profiler is built in say where the time went and keep the details next to the network
+    if (profilingEnabled){
+        Profiler::instance().printSummary(std::cout);
+        if (!Profiler::instance().writeLog(output+".profile.json") ||
+            !Profiler::instance().writeTrace(output+".trace.json"))
+            std::cerr<<"Could not write the profile of "<<output<<std::endl;
     }
     // attempt a test run and print out the results
     std::vector<double> results;
     network.feedForward(std::vector<double>({0.0,1.0}));
     network.getResults(results);
     std::cout<<results<<std::endl;
+    // create the file to save the neural network to and open it for writing out
+    std::fstream neuralNetworkSave;
+    neuralNetworkSave.open(output, std::fstream::out);
     // write the neural network as a json object to the file
     neuralNetworkSave<<network.toJson();
     // close the file
     neuralNetworkSave.close();
+    // save the binary model which can be mapped straight into memory when it is used
+    if (!saveModelFile(network, binaryOutput))
+        std::cerr<<"Could not write "<<binaryOutput<<std::endl;
+}
+
+// open the data as a binary dataset which is mapped into memory, or failing that as a text file which is streamed,
+// returns false if it is neither
+bool openTrainingData(std::string data, Dataset& dataset, std::unique_ptr<TrainingDataStream>& input){
+    if (dataset.open(data))
+        return true;
+    input.reset(new TrainingDataStream(data, memoryLimit));
+    return input->isOpen();
+}
+
+// function to make a neural network and train it using the given data and save it to a given json file for debugging
+// and a binary model file for running it, the layers after the input layer use the given activations or tanh if none
+// are given. Checkpoints of the training are written next to the model file
+void writeNeuralNetwork(std::string output, std::string binaryOutput, std::string data,
+                        const std::vector<Activation>& activations = {}){
+    Dataset dataset;
+    std::unique_ptr<TrainingDataStream> input;
+    if (!openTrainingData(data, dataset, input))
+        return;
+    // create the network with the given topology from the data read in
+    NeuralNetwork network(input ? input->getTopology() : dataset.getTopology());
+    if (!activations.empty() && activations.size()+1 != network.getPackedLayers().size()){
+        std::cerr<<"Need an activation for each of the "<<network.getPackedLayers().size()-1<<" layers"<<std::endl;
+        return;
+    }
+    for (size_t layer = 0; layer<activations.size(); layer++)
+        if (!network.setActivation(layer+1, activations[layer])){
+            std::cerr<<activationName(activations[layer])<<" can only be used by the output layer"<<std::endl;
+            return;
+        }
+    network.setOptimizer(optimizer);
+    TrainingProgress progress;
+    progress.numEpochs = numEpochs;
+    progress.patience = patience;
+    progress.batchSize = batchSize;
+    progress.validationFraction = validationFraction;
+    trainAndSave(network, progress, data, dataset, input.get(), binaryOutput+".checkpoint", output, binaryOutput);
+}
+
+// carry on a run from its last checkpoint on the same data, as if it had never stopped. The run keeps the passes,
+// patience, validation fraction and batch size it was started with, any of them given must be the same as those
+void resumeNeuralNetwork(std::string checkpointFile, std::string data, std::string output, std::string binaryOutput,
+                         std::optional<size_t> passes, std::optional<size_t> runPatience,
+                         std::optional<double> runValidationFraction){
+    NeuralNetwork network(std::vector<int>{});
+    TrainingProgress progress;
+    if (!loadCheckpoint(checkpointFile, network, progress))
+        return;
+    if ((passes && *passes != progress.numEpochs) || (runPatience && *runPatience != progress.patience) ||
+        (runValidationFraction && *runValidationFraction != progress.validationFraction)){
+        std::cerr<<checkpointFile<<": the run was started with "<<progress.numEpochs<<" passes, a patience of "
+                 <<progress.patience<<" and a validation fraction of "<<progress.validationFraction<<std::endl;
+        return;
+    }
+    numEpochs = progress.numEpochs;
+    patience = progress.patience;
+    batchSize = progress.batchSize;
+    validationFraction = progress.validationFraction;
+    Dataset dataset;
+    std::unique_ptr<TrainingDataStream> input;
+    if (!openTrainingData(data, dataset, input))
+        return;
+    const std::vector<int>& topology = input ? input->getTopology() : dataset.getTopology();
+    if (topology.front() != (int)network.getNumInputs() || topology.back() != (int)network.getNumOutputs()){
+        std::cerr<<data<<": does not match the topology of "<<checkpointFile<<std::endl;
+        return;
+    }
+    // a run that was shuffled saved the state of its engine
+    shuffleSamples = !progress.randomState.empty();
+    std::cout<<"Resuming at sample "<<progress.sample<<" of pass "<<progress.epoch+1<<std::endl;
+    trainAndSave(network, progress, data, dataset, input.get(), checkpointFile, output, binaryOutput);
 }
 
 // function to read a neural network in from a file and return the network
@@ -107,27 +451,598 @@ void generateTrainingData(std::string fileName){
     data.generateTrainingData(fileName, 100*100*100, func);
 }
 
+// generate samples of a built in target function for the topology on every core and write them as text or a binary
+// dataset split into shards, returns false if the settings are invalid or a shard could not be written
+bool generateShardedData(std::string fileName, std::string topology, std::string function, std::string format,
+                         GeneratorSettings settings){
+    // the topology is given the way it is written at the top of a training file
+    std::string line = "Topology: "+topology;
+    if (!TrainingDataParser::parseTopology(line.data(), line.data()+line.size(), settings.topology)){
+        std::cerr<<topology<<": not a topology, give the size of every layer as 2,4,1"<<std::endl;
+        return false;
+    }
+    TargetFunction target;
+    if (!parseTargetFunction(function, settings.topology.front(), settings.topology.back(), target)){
+        std::cerr<<function<<": not a target function for "<<settings.topology.front()<<" inputs and "
+                 <<settings.topology.back()<<" outputs, use one of mix parity majority count"<<std::endl;
+        return false;
+    }
+    if (format != "text" && format != "float" && format != "double"){
+        std::cerr<<format<<": the format must be text, float or double"<<std::endl;
+        return false;
+    }
+    settings.scalarSize = format == "float" ? sizeof(float) : format == "double" ? sizeof(double) : 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!generateShards(fileName, settings, target))
+        return false;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    std::cout<<"Generated "<<settings.numSamples<<" samples in "<<seconds<<"s"<<std::endl;
+    return true;
+}
+
 // test a neural network with static data
 void testData(std::string testUnit){
-    // read in the neural network
-    NeuralNetwork network = readNeuralNetwork(testUnit+".net");
+    // map the binary model into memory, its weights are used straight from the file and it could be shared by any
+    // number of threads
+    std::shared_ptr<const Model> model = loadModelFile(testUnit+".nnb");
+    if (!model)
+        return;
+    // the workspace holds this caller's values while they pass through the model
+    Workspace workspace(*model);
     // make inputs and declare results to store the results of the network
     std::vector<double> input({0.0,1.0});
-    std::vector<double> results;
-    // feed forward the inputs for the network to calculate the answers and then get the results
-    network.feedForward(input);
-    network.getResults(results);
+    std::vector<double> results(model->getNumOutputs());
+    // feed forward the inputs through the model to calculate the answers
+    model->predict(input.data(), results.data(), workspace);
     // print out the results of the test data
     std::cout<<results<<std::endl;
 }
 
 
+// how one precision of the network did after training on the same data as the others
+struct PrecisionResult {
+    // the outputs of the trained network for every sample
+    std::vector<double> outputs;
+    // the root mean squared error of those outputs and the speed of training
+    double error, samplesPerSecond;
+};
+
+// train a copy of the network in the given precision on every sample and then run the samples through it
+template<typename Scalar, typename Accumulator>
+PrecisionResult trainInPrecision(const NeuralNetwork& initial, const TrainingSet& data){
+    size_t numInputs = (size_t)data.topology.front(), numOutputs = (size_t)data.topology.back();
+    BasicNeuralNetwork<Scalar, Accumulator> network(initial);
+    std::vector<Scalar> inputs(data.inputs.begin(), data.inputs.end());
+    std::vector<Scalar> outputs(data.outputs.begin(), data.outputs.end());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first<data.count; first += batchSize)
+        network.trainBatch(inputs.data()+first*numInputs, outputs.data()+first*numOutputs,
+                           std::min(batchSize, data.count-first));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    // freeze the trained network and measure how far its answers are from the targets
+    BasicModel<Scalar, Accumulator> model(network);
+    typename BasicModel<Scalar, Accumulator>::Workspace workspace(model);
+    std::vector<Scalar> prediction(numOutputs);
+    PrecisionResult result{std::vector<double>(data.outputs.size()), 0, data.count/seconds};
+    for (size_t sample = 0; sample<data.count; sample++){
+        model.predict(inputs.data()+sample*numInputs, prediction.data(), workspace);
+        for (size_t output = 0; output<numOutputs; output++){
+            result.outputs[sample*numOutputs+output] = prediction[output];
+            double difference = data.outputs[sample*numOutputs+output]-(double)prediction[output];
+            result.error += difference*difference;
+        }
+    }
+    result.error = sqrt(result.error/std::max<size_t>(1, data.outputs.size()));
+    return result;
+}
+
+// read all of a binary dataset or text training data file into memory, returns false if it could not be read
+bool readSamples(std::string data, TrainingSet& set){
+    Dataset dataset;
+    if (dataset.open(data)){
+        set.topology = dataset.getTopology();
+        set.count = dataset.getNumSamples();
+        set.inputs.resize(set.count*dataset.getNumInputs());
+        set.outputs.resize(set.count*dataset.getNumOutputs());
+        dataset.copyBatch(0, set.count, set.inputs.data(), set.outputs.data());
+    } else if (!TrainingData().readTrainingSet(data, set)){
+        std::cerr<<data<<": "<<set.error<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+// train the same network in double, float and mixed precision on the same data and print how the faster precisions
+// compare with double precision
+void comparePrecisions(std::string data){
+    TrainingSet set;
+    if (!readSamples(data, set))
+        return;
+
+    // every precision starts from the same random weights
+    NeuralNetwork initial(set.topology);
+    PrecisionResult baseline = trainInPrecision<double, double>(initial, set);
+    std::pair<const char*, PrecisionResult> results[] = {
+            {"double", baseline},
+            {"float", trainInPrecision<float, float>(initial, set)},
+            {"mixed", trainInPrecision<float, double>(initial, set)}
+    };
+    for (const std::pair<const char*, PrecisionResult>& result:results){
+        double deviation = 0;
+        for (size_t output = 0; output<baseline.outputs.size(); output++)
+            deviation = std::max(deviation, std::abs(result.second.outputs[output]-baseline.outputs[output]));
+        std::cout<<result.first<<": "<<result.second.samplesPerSecond<<" samples/s, error "<<result.second.error
+                 <<", largest difference from double "<<deviation<<std::endl;
+    }
+}
+
+
+// how a model did on every sample of the data
+struct ModelResult {
+    std::vector<double> outputs;
+    // the root mean squared error of the outputs and the speed of predicting them
+    double error, samplesPerSecond;
+};
+
+// run every sample through a model given a function that predicts one sample
+ModelResult evaluateModel(const TrainingSet& data, const std::function<void(const double*, double*)>& predict){
+    size_t numInputs = (size_t)data.topology.front(), numOutputs = (size_t)data.topology.back();
+    ModelResult result{std::vector<double>(data.outputs.size()), 0, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t sample = 0; sample<data.count; sample++)
+        predict(data.inputs.data()+sample*numInputs, result.outputs.data()+sample*numOutputs);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    for (size_t output = 0; output<data.outputs.size(); output++)
+        result.error += (data.outputs[output]-result.outputs[output])*(data.outputs[output]-result.outputs[output]);
+    result.error = sqrt(result.error/std::max<size_t>(1, data.outputs.size()));
+    result.samplesPerSecond = data.count/seconds;
+    return result;
+}
+
+// quantize a saved model to int8 calibrating it on a sample of the data, save it and print how its accuracy compares
+// with the model in double and float precision on all of the data
+void quantizeNeuralNetwork(std::string modelFile, std::string data, std::string quantizedFile){
+    // the network is loaded rather than mapped so its optimizer settings are carried into the quantized file
+    NeuralNetwork network(std::vector<int>{});
+    TrainingSet set;
+    if (!loadNetworkFile(modelFile, network))
+        return;
+    std::shared_ptr<const Model> model = std::make_shared<const Model>(network);
+    std::shared_ptr<const FloatModel> floatModel = loadModelFile<float>(modelFile);
+    if (!floatModel || !readSamples(data, set))
+        return;
+    if (set.topology.front() != (int)model->getNumInputs() || set.topology.back() != (int)model->getNumOutputs()){
+        std::cerr<<data<<": does not match the topology of "<<modelFile<<std::endl;
+        return;
+    }
+
+    // calibrate on samples spread evenly through the data
+    size_t numInputs = model->getNumInputs(), calibrationSamples = std::min<size_t>(set.count, 1000);
+    std::vector<double> calibration;
+    for (size_t sample = 0; sample<calibrationSamples; sample++){
+        const double* row = set.inputs.data()+sample*(set.count/calibrationSamples)*numInputs;
+        calibration.insert(calibration.end(), row, row+numInputs);
+    }
+    std::shared_ptr<const QuantizedModel> quantized = quantizeModel(*model, calibration.data(), calibrationSamples);
+    if (!quantized || !saveQuantizedModelFile(*quantized, network.getOptimizer(), quantizedFile)){
+        std::cerr<<"Could not write "<<quantizedFile<<std::endl;
+        return;
+    }
+    // run the quantized model the way it will be used, mapped from the file it was saved to
+    quantized = loadQuantizedModelFile(quantizedFile);
+    if (!quantized)
+        return;
+
+    Workspace workspace;
+    FloatModel::Workspace floatWorkspace;
+    QuantizedWorkspace quantizedWorkspace;
+    std::vector<float> floatInputs(numInputs), floatOutputs(model->getNumOutputs());
+    ModelResult baseline = evaluateModel(set, [&](const double* inputs, double* outputs){
+        model->predict(inputs, outputs, workspace);
+    });
+    ModelResult single = evaluateModel(set, [&](const double* inputs, double* outputs){
+        std::copy(inputs, inputs+numInputs, floatInputs.begin());
+        floatModel->predict(floatInputs.data(), floatOutputs.data(), floatWorkspace);
+        std::copy(floatOutputs.begin(), floatOutputs.end(), outputs);
+    });
+    ModelResult int8 = evaluateModel(set, [&](const double* inputs, double* outputs){
+        quantized->predict(inputs, outputs, quantizedWorkspace);
+    });
+
+    std::pair<const char*, ModelResult*> results[] = {{"double", &baseline}, {"float", &single}, {"int8", &int8}};
+    for (const std::pair<const char*, ModelResult*>& result:results){
+        double fromDouble = 0, fromFloat = 0;
+        for (size_t output = 0; output<baseline.outputs.size(); output++){
+            fromDouble = std::max(fromDouble, std::abs(result.second->outputs[output]-baseline.outputs[output]));
+            fromFloat = std::max(fromFloat, std::abs(result.second->outputs[output]-single.outputs[output]));
+        }
+        std::cout<<result.first<<": "<<result.second->samplesPerSecond<<" samples/s, error "<<result.second->error
+                 <<", largest difference from double "<<fromDouble<<" and from float "<<fromFloat<<std::endl;
+    }
+}
+
+
+// train many networks on the same data with the choices in a sweep file, or the default choices when it is -, print
+// how they ranked and save the network that did best on the held back samples
+void sweepNeuralNetworks(std::string data, std::string sweepFile, std::string output, std::string binaryOutput){
+    SweepSpace space;
+    SweepSettings settings;
+    settings.batchSize = batchSize;
+    settings.numThreads = numThreads;
+    std::string search = "grid";
+    size_t numSamples = 20;
+    if (sweepFile != "-"){
+        std::fstream file(sweepFile, std::fstream::in);
+        Json::Value input;
+        if (!file || !Json::parseFromStream(Json::CharReaderBuilder(), file, &input, nullptr)){
+            std::cerr<<sweepFile<<": could not read the sweep"<<std::endl;
+            return;
+        }
+        if (!readSweep(input, space, settings, search, numSamples))
+            return;
+    }
+    // every network reads from the one copy of the samples
+    TrainingSet set;
+    if (!readSamples(data, set))
+        return;
+    std::vector<SweepConfig> configs = search == "grid" ? gridSearch(space) :
+                                       randomSearch(space, numSamples, settings.seed);
+
+    std::cout<<"Sweeping "<<configs.size()<<" networks"<<std::endl;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<NeuralNetwork> best;
+    std::vector<SweepResult> results = runSweep(set, configs, settings, best);
+    if (!best)
+        return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    std::cout<<"Trained "<<results.size()<<" networks in "<<seconds<<"s, "
+             <<results.size()*settings.epochs*set.count/seconds<<" samples/s"<<std::endl;
+    for (size_t rank = 0; rank<results.size() && rank<10; rank++)
+        std::cout<<rank+1<<". validation error "<<results[rank].validationError<<", training error "
+                 <<results[rank].trainingError<<": "<<describeConfig(results[rank].config)<<std::endl;
+
+    std::fstream neuralNetworkSave(output, std::fstream::out);
+    neuralNetworkSave<<best->toJson();
+    neuralNetworkSave.close();
+    if (!saveModelFile(*best, binaryOutput))
+        std::cerr<<"Could not write "<<binaryOutput<<std::endl;
+}
+
+
+// the size of a file in bytes, zero if it cannot be read
+uint64_t fileSize(const std::string& fileName){
+    std::ifstream file(fileName, std::ifstream::binary | std::ifstream::ate);
+    return file ? (uint64_t)file.tellg() : 0;
+}
+
+// prune a saved model, fine tune it for the given number of passes over the data before the held back fraction and
+// save it as a sparse model, then print how much was removed from every layer and how much faster it runs
+void pruneNeuralNetwork(std::string modelFile, std::string data, std::string sparseFile, PruneSettings settings,
+                        size_t passes){
+    NeuralNetwork network(std::vector<int>{});
+    TrainingSet set;
+    if (!loadNetworkFile(modelFile, network) || !readSamples(data, set))
+        return;
+    if (set.topology.front() != (int)network.getNumInputs() || set.topology.back() != (int)network.getNumOutputs()){
+        std::cerr<<data<<": does not match the topology of "<<modelFile<<std::endl;
+        return;
+    }
+
+    // every sample is used to judge the network when none are held back
+    size_t numInputs = network.getNumInputs(), numOutputs = network.getNumOutputs();
+    size_t numTraining = set.count-(size_t)(set.count*validationFraction);
+    size_t firstValidation = numTraining<set.count ? numTraining : 0;
+    auto validate = [&]{
+        Evaluator evaluator(network);
+        evaluator.add(set.inputs.data()+firstValidation*numInputs, set.outputs.data()+firstValidation*numOutputs,
+                      set.count-firstValidation);
+        return evaluator.result().rmse;
+    };
+    double unpruned = validate();
+    PruneMask mask = pruneNetwork(network, settings);
+    double pruned = validate();
+    BatchWorkspace workspace;
+    for (size_t pass = 0; pass<passes; pass++)
+        for (size_t first = 0; first<numTraining; first += batchSize)
+            trainPruned(network, mask, set.inputs.data()+first*numInputs, set.outputs.data()+first*numOutputs,
+                        std::min(batchSize, numTraining-first), workspace);
+    std::cout<<"Validation rmse "<<unpruned<<" before pruning, "<<pruned<<" after pruning and "<<validate()
+             <<" after "<<passes<<" passes of fine tuning"<<std::endl;
+
+    Model model(network);
+    std::shared_ptr<const SparseModel> sparse = sparsifyModel(model);
+    if (!sparse || !saveSparseModelFile(*sparse, network.getOptimizer(), sparseFile)){
+        std::cerr<<"Could not write "<<sparseFile<<std::endl;
+        return;
+    }
+    // run the sparse model the way it will be used, mapped from the file it was saved to
+    sparse = loadSparseModelFile(sparseFile);
+    if (!sparse)
+        return;
+
+    // time the layers on samples spread evenly through the data
+    size_t timingSamples = std::min<size_t>(set.count, 1000);
+    std::vector<double> timing;
+    for (size_t sample = 0; sample<timingSamples; sample++){
+        const double* row = set.inputs.data()+sample*(set.count/timingSamples)*numInputs;
+        timing.insert(timing.end(), row, row+numInputs);
+    }
+    std::vector<SparseLayerReport> reports = compareLayers(model, *sparse, timing.data(), timingSamples);
+    double denseSeconds = 0, sparseSeconds = 0;
+    for (size_t layer = 0; layer<reports.size(); layer++){
+        const SparseLayerReport& report = reports[layer];
+        std::cout<<"Layer "<<layer+1<<": kept "<<report.keptWeights<<" of "<<report.weights<<" weights, "
+                 <<report.sparsity*100<<"% sparse, "<<report.denseSeconds/timingSamples*1e9<<"ns dense and "
+                 <<report.sparseSeconds/timingSamples*1e9<<"ns sparse per sample, "<<report.speedup<<"x"<<std::endl;
+        denseSeconds += report.denseSeconds;
+        sparseSeconds += report.sparseSeconds;
+    }
+
+    // the sparse model only sums in a different order so its outputs should match the pruned dense model
+    Workspace denseWorkspace, sparseWorkspace;
+    std::vector<double> denseOutputs(numOutputs), sparseOutputs(numOutputs);
+    double difference = 0;
+    for (size_t sample = 0; sample<timingSamples; sample++){
+        model.predict(timing.data()+sample*numInputs, denseOutputs.data(), denseWorkspace);
+        sparse->predict(timing.data()+sample*numInputs, sparseOutputs.data(), sparseWorkspace);
+        for (size_t output = 0; output<numOutputs; output++)
+            difference = std::max(difference, std::abs(denseOutputs[output]-sparseOutputs[output]));
+    }
+    std::cout<<"Every layer "<<denseSeconds/sparseSeconds<<"x faster, "<<modelFile<<" "<<fileSize(modelFile)
+             <<" bytes and "<<sparseFile<<" "<<fileSize(sparseFile)<<" bytes, largest difference from the dense model "
+             <<difference<<std::endl;
+}
+
+
+// set when the server is asked to shut down
+std::atomic<bool> shutdownRequested(false);
+
+// print how the server has done so far
+void printStatistics(std::ostream& out, const InferenceStatistics& statistics){
+    out<<statistics.requests<<" requests in "<<statistics.batches<<" batches averaging "
+             <<statistics.averageBatchSize<<", "<<statistics.requestsPerSecond<<" requests/s, p50 "
+             <<statistics.p50Latency*1000<<"ms p99 "<<statistics.p99Latency*1000<<"ms"<<std::endl;
+}
+
+// load a model and answer requests for it on a unix socket until interrupted, or on stdin and stdout until the input
+// ends when the path is -
+void serveModel(std::string modelFile, std::string path, size_t maxBatchSize, double latencyBudget,
+                size_t layerThreads){
+    std::shared_ptr<const Model> model = loadModelFile(modelFile);
+    if (!model)
+        return;
+    InferenceServer server(model, maxBatchSize, latencyBudget, layerThreads);
+    if (path == "-"){
+        server.serveStream(STDIN_FILENO, STDOUT_FILENO);
+        printStatistics(std::cerr, server.getStatistics());
+        return;
+    }
+
+    // serve on another thread so this one can report every few seconds and shut the server down when interrupted
+    std::signal(SIGINT, [](int){ shutdownRequested = true; });
+    std::signal(SIGTERM, [](int){ shutdownRequested = true; });
+    std::thread serving([&]{
+        if (!server.serveSocket(path))
+            shutdownRequested = true;
+    });
+    std::cerr<<"Serving "<<modelFile<<" on "<<path<<std::endl;
+    size_t lastRequests = 0;
+    for (size_t tick = 1; !shutdownRequested; tick++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        InferenceStatistics statistics = server.getStatistics();
+        if (tick%100 == 0 && statistics.requests != lastRequests){
+            printStatistics(std::cerr, statistics);
+            lastRequests = statistics.requests;
+        }
+    }
+    server.stop();
+    serving.join();
+    printStatistics(std::cerr, server.getStatistics());
+}
+
+// send random requests to a server and print the latency and throughput the clients saw next to the server's own
+void runLoadGenerator(std::string path, size_t numRequests, size_t numConnections, size_t pipelineDepth){
+    LoadReport report;
+    if (!generateLoad(path, numRequests, numConnections, pipelineDepth, report))
+        std::cerr<<path<<": could not send every request"<<std::endl;
+    std::cout<<report.requests<<" requests over "<<numConnections<<" connections in "<<report.seconds<<"s, "
+             <<report.requestsPerSecond<<" requests/s, p50 "<<report.p50Latency*1000<<"ms p99 "
+             <<report.p99Latency*1000<<"ms"<<std::endl;
+    std::cout<<"Server: ";
+    printStatistics(std::cout, report.server);
+}
+
+
+// answer lines of "<model file> input,input,..." from stdin with the outputs of the model, loading the models as they
+// are asked for and keeping the most recent within the memory limit. The files are checked for new versions every
+// interval and the statistics of the registry are printed once the input ends
+void serveRegistry(size_t memoryLimit, double checkInterval){
+    ModelRegistry registry(memoryLimit, checkInterval);
+    // predicting a batch grows the workspace to fit so one workspace serves every model
+    Workspace workspace;
+    std::vector<double> inputs, outputs;
+    std::string line, modelFile, values;
+    while (std::getline(std::cin, line)){
+        std::istringstream request(line);
+        if (!(request>>modelFile))
+            continue;
+        std::shared_ptr<const Model> model = registry.get(modelFile);
+        if (!model){
+            std::cout<<"error"<<std::endl;
+            continue;
+        }
+        inputs.clear();
+        request>>values;
+        std::istringstream fields(values);
+        for (std::string field; std::getline(fields, field, ',');)
+            inputs.push_back(std::strtod(field.c_str(), nullptr));
+        if (inputs.size() != model->getNumInputs()){
+            std::cerr<<modelFile<<": takes "<<model->getNumInputs()<<" inputs"<<std::endl;
+            std::cout<<"error"<<std::endl;
+            continue;
+        }
+        outputs.resize(model->getNumOutputs());
+        model->predictBatch(inputs.data(), 1, outputs.data(), workspace);
+        for (size_t output = 0; output<outputs.size(); output++)
+            std::cout<<(output ? "," : "")<<outputs[output];
+        std::cout<<"\n";
+    }
+    std::cout.flush();
+    RegistryStatistics statistics = registry.getStatistics();
+    std::cerr<<statistics.hits<<" hits, "<<statistics.misses<<" misses, "<<statistics.reloads<<" reloads, "
+             <<statistics.evictions<<" evictions, "<<statistics.models<<" models holding "<<statistics.bytes
+             <<" bytes"<<std::endl;
+}
+
+
 // do what you will with the main file to test out the neural network
-int main() {
-    // example of generating a neural network's test data and training/writing network to a file
+int main(int argc, char** argv) {
+    // convert a text training data file to a binary dataset
+    // NeuralNetwork convert <text file> <dataset> [float|double] [samples per shard]
+    if (argc>=4 && std::string(argv[1]) == "convert"){
+        uint32_t scalarSize = argc>=5 && std::string(argv[4]) == "float" ? sizeof(float) : sizeof(double);
+        size_t samplesPerShard = argc>=6 ? std::stoul(argv[5]) : 0;
+        return convertTrainingData(argv[2], argv[3], scalarSize, samplesPerShard) ? 0 : 1;
+    }
+    // generate samples of a target function on every core, split into shards which are one per thread unless given
+    // NeuralNetwork generate <file> <topology> <samples> [mix|parity|majority|count] [text|float|double] [shards]
+    //                       [seed] [threads]
+    if (argc>=5 && std::string(argv[1]) == "generate"){
+        GeneratorSettings settings;
+        settings.numSamples = std::stoull(argv[4]);
+        if (argc>=8)
+            settings.numShards = std::stoul(argv[7]);
+        if (argc>=9)
+            settings.seed = std::stoull(argv[8]);
+        if (argc>=10)
+            settings.numThreads = std::stoul(argv[9]);
+        return generateShardedData(argv[2], argv[3], argc>=6 ? argv[5] : "parity", argc>=7 ? argv[6] : "text",
+                                   settings) ? 0 : 1;
+    }
+    // quantize a saved model to int8 and compare its accuracy with the full precision model
+    // NeuralNetwork quantize <model file> <text file or dataset> <quantized model file>
+    if (argc>=5 && std::string(argv[1]) == "quantize"){
+        quantizeNeuralNetwork(argv[2], argv[3], argv[4]);
+        return 0;
+    }
+    // prune the smallest weights of a saved model, fine tune what is left and save it as a sparse model. threshold
+    // removes every weight below the value, top keeps the given number of the largest in every layer and keep keeps
+    // the given fraction of them. Every weight from a bias neuron is kept
+    // NeuralNetwork prune <model file> <text file or dataset> <sparse model file> [threshold|top|keep] [value]
+    //                    [passes of fine tuning]
+    if (argc>=5 && std::string(argv[1]) == "prune"){
+        PruneSettings settings;
+        std::string method = argc>=6 ? argv[5] : "keep";
+        double value = argc>=7 ? std::stod(argv[6]) : 0.5;
+        if (method == "threshold")
+            settings.threshold = value;
+        else if (method == "top" && value>=1)
+            settings.topK = (size_t)value;
+        else if (method == "keep" && value>0 && value<=1)
+            settings.keepFraction = value;
+        else {
+            std::cerr<<method<<" "<<value<<": prune with threshold <value>, top <count> or keep <fraction>"<<std::endl;
+            return 1;
+        }
+        pruneNeuralNetwork(argv[2], argv[3], argv[4], settings, argc>=8 ? std::stoul(argv[7]) : 1);
+        return 0;
+    }
+    // train a network on the data with the given activations and save it, checkpoints are written to
+    // <model file>.checkpoint every checkpoint interval. Training makes up to the given number of passes over the data
+    // and stops once the error on the held back fraction of it has not improved for the patience in passes
+    // NeuralNetwork train <text file or dataset> <json file> <model file> [activation,activation,...|-]
+    //                    [momentum|nesterov|adam|rmsprop] [learning rate] [weight decay] [checkpoint interval in s]
+    //                    [passes] [patience] [validation fraction] [shuffle seed|- to keep the order of the file]
+    if (argc>=5 && std::string(argv[1]) == "train"){
+        std::vector<Activation> activations;
+        if (argc>=6 && std::string(argv[5]) != "-" && !parseActivations(argv[5], activations))
+            return 1;
+        if (argc>=7 && !parseOptimizer(argv[6], optimizer.type)){
+            std::cerr<<argv[6]<<": not an optimizer"<<std::endl;
+            return 1;
+        }
+        // adam and rmsprop take much smaller steps than the momentum the default rate is set for
+        if (optimizer.type == OptimizerType::ADAM || optimizer.type == OptimizerType::RMSPROP)
+            optimizer.learningRate = 0.001;
+        if (argc>=8)
+            optimizer.learningRate = std::stod(argv[7]);
+        if (argc>=9)
+            optimizer.weightDecay = std::stod(argv[8]);
+        if (argc>=10)
+            checkpointInterval = std::stod(argv[9]);
+        if (argc>=11)
+            numEpochs = std::stoul(argv[10]);
+        if (argc>=12)
+            patience = std::stoul(argv[11]);
+        if (argc>=13)
+            validationFraction = std::stod(argv[12]);
+        if (argc>=14 && std::string(argv[13]) == "-")
+            shuffleSamples = false;
+        else if (argc>=14)
+            shuffleSeed = std::stoull(argv[13]);
+        if (validationFraction<0 || validationFraction>=1){
+            std::cerr<<"The validation fraction must be at least 0 and below 1"<<std::endl;
+            return 1;
+        }
+        writeNeuralNetwork(argv[3], argv[4], argv[2], activations);
+        return 0;
+    }
+    // carry on training from a checkpoint on the same data with the same passes and validation it was taken with, the
+    // passes, patience and validation fraction are saved with the run and only checked against it when given
+    // NeuralNetwork resume <checkpoint file> <text file or dataset> <json file> <model file> [checkpoint interval in s]
+    //                     [passes] [patience] [validation fraction]
+    if (argc>=6 && std::string(argv[1]) == "resume"){
+        if (argc>=7)
+            checkpointInterval = std::stod(argv[6]);
+        resumeNeuralNetwork(argv[2], argv[3], argv[4], argv[5],
+                            argc>=8 ? std::optional<size_t>(std::stoul(argv[7])) : std::nullopt,
+                            argc>=9 ? std::optional<size_t>(std::stoul(argv[8])) : std::nullopt,
+                            argc>=10 ? std::optional<double>(std::stod(argv[9])) : std::nullopt);
+        return 0;
+    }
+    // answer requests for a model in micro batches over a unix socket, or stdin and stdout when the path is -. The
+    // wide layers of every batch are split between the given number of threads, zero uses every core
+    // NeuralNetwork serve <model file> [socket path|-] [max batch size] [latency budget in ms] [threads per layer]
+    if (argc>=3 && std::string(argv[1]) == "serve"){
+        serveModel(argv[2], argc>=4 ? argv[3] : prefix+".sock", argc>=5 ? std::stoul(argv[4]) : 64,
+                   argc>=6 ? std::stod(argv[5])/1000 : 0.002, argc>=7 ? std::stoul(argv[6]) : 1);
+        return 0;
+    }
+    // load a running server with random requests
+    // NeuralNetwork loadgen <socket path> [requests] [connections] [requests in flight per connection]
+    if (argc>=3 && std::string(argv[1]) == "loadgen"){
+        runLoadGenerator(argv[2], argc>=4 ? std::stoul(argv[3]) : 100000, argc>=5 ? std::stoul(argv[4]) : 16,
+                         argc>=6 ? std::stoul(argv[5]) : 1);
+        return 0;
+    }
+    // answer "<model file> input,input,..." lines from stdin with any number of models cached up to the memory limit,
+    // reloading the ones whose files change
+    // NeuralNetwork registry [memory limit in MiB] [check interval in s]
+    if (argc>=2 && std::string(argv[1]) == "registry"){
+        serveRegistry((size_t)((argc>=3 ? std::stod(argv[2]) : 256)*1024*1024), argc>=4 ? std::stod(argv[3]) : 1);
+        return 0;
+    }
+    // train networks with every configuration of a sweep at once and save the best
+    // NeuralNetwork sweep <text file or dataset> <sweep json file|-> <json file> <model file>
+    if (argc>=6 && std::string(argv[1]) == "sweep"){
+        sweepNeuralNetworks(argv[2], argv[3], argv[4], argv[5]);
+        return 0;
+    }
+    // compare training in every precision on the same data
+    // NeuralNetwork precision <text file or dataset>
+    if (argc>=3 && std::string(argv[1]) == "precision"){
+        comparePrecisions(argv[2]);
+        return 0;
+    }
+
+    // example of generating a neural network's test data, converting it to a binary dataset and training/writing
+    // network to a file
     generateTrainingData(prefix+".dat");
-    writeNeuralNetwork(prefix+".net", prefix+".dat");
+    convertTrainingData(prefix+".dat", prefix+".nnd");
+    writeNeuralNetwork(prefix+".net", prefix+".nnb", prefix+".nnd");
     // example of reading in a neural network and using test data to see if it gets the answer right or not
     testData(prefix);
     return 0;
-}
\ No newline at end of file
+}